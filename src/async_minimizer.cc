@@ -0,0 +1,119 @@
+#include "async_minimizer.hh"
+
+#include <utility>
+
+namespace pfc {
+
+  minimization_handle::minimization_handle(std::shared_ptr<state> s,
+                                           int concurrency)
+    : state_(std::move(s))
+    // No slots are reserved for the calling thread, so the search is done
+    // entirely by TBB worker threads.
+    , arena_(std::make_unique<oneapi::tbb::task_arena>(concurrency, 0))
+  {}
+
+  minimization_handle::~minimization_handle()
+  {
+    // A handle that has been moved from has nothing to clean up.
+    if (!state_)
+      return;
+    cancel();
+    wait();
+  }
+
+  void
+  minimization_handle::launch(
+    std::function<void(shared_result&, protected_engine<std::mt19937>&)> work)
+  {
+    state_->tstart = now_in_milliseconds();
+    // The enqueued task holds its own reference to the state, so that the
+    // state outlives the task even if the task is still finishing when the
+    // handle is destroyed.
+    arena_->enqueue([s = state_, work = std::move(work)]() {
+      std::exception_ptr error;
+      try {
+        work(s->solutions, s->engine);
+      }
+      catch (...) {
+        error = std::current_exception();
+      }
+      {
+        std::scoped_lock lock(s->m);
+        s->tstop = now_in_milliseconds();
+        s->error = error;
+        s->finished = true;
+      }
+      s->finished_cv.notify_all();
+    });
+  }
+
+  std::optional<solution>
+  minimization_handle::best() const
+  {
+    // Solutions are never removed, so if there is one now there will be one
+    // when we ask for the best.
+    if (state_->solutions.empty())
+      return {};
+    return state_->solutions.best();
+  }
+
+  long
+  minimization_handle::num_attempts() const
+  {
+    return state_->solutions.num_attempts();
+  }
+
+  double
+  minimization_handle::attempt_rate() const
+  {
+    double stop = 0.0;
+    {
+      std::scoped_lock lock(state_->m);
+      stop = state_->finished ? state_->tstop : now_in_milliseconds();
+    }
+    double const elapsed = stop - state_->tstart;
+    if (elapsed <= 0.0)
+      return 0.0;
+    return num_attempts() / elapsed;
+  }
+
+  bool
+  minimization_handle::done() const
+  {
+    std::scoped_lock lock(state_->m);
+    return state_->finished;
+  }
+
+  bool
+  minimization_handle::wait_for(std::chrono::milliseconds timeout) const
+  {
+    std::unique_lock lock(state_->m);
+    return state_->finished_cv.wait_for(
+      lock, timeout, [this] { return state_->finished; });
+  }
+
+  void
+  minimization_handle::wait() const
+  {
+    std::unique_lock lock(state_->m);
+    state_->finished_cv.wait(lock, [this] { return state_->finished; });
+  }
+
+  void
+  minimization_handle::cancel()
+  {
+    state_->solutions.request_stop();
+  }
+
+  minimization_results
+  minimization_handle::results() const
+  {
+    wait();
+    {
+      std::scoped_lock lock(state_->m);
+      if (state_->error)
+        std::rethrow_exception(state_->error);
+    }
+    return {state_->solutions.solutions(), state_->solutions.num_attempts()};
+  }
+}
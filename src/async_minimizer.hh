@@ -0,0 +1,164 @@
+#ifndef PROFILED_FC_CPU_ASYNC_MINIMIZER_HH
+#define PROFILED_FC_CPU_ASYNC_MINIMIZER_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "protected_engine.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "tbb/task_arena.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <type_traits>
+
+namespace pfc {
+
+  class minimization_handle;
+
+  // Start the same search as find_global_minimum, but do not wait for it to
+  // finish. The search runs in its own task arena with 'num_starting_points'
+  // threads; the calling thread does not take part in it, and is free to do
+  // other work (including starting other searches).
+  //
+  // If 'on_improvement' is supplied, it is called with each solution that is
+  // better than all the solutions found before it. It is called from the
+  // threads doing the search, while they hold the lock on the search results,
+  // so it should be quick.
+  //
+  // The function to be minimized is copied, so it need not outlive the call.
+  template <typename FUNC>
+  minimization_handle start_global_minimization(
+    FUNC&& func,
+    region<column_vector> const& starting_point_volume,
+    int num_starting_points,
+    double tolerance,
+    long max_attempts = 1000000,
+    std::function<void(solution const&)> on_improvement = {});
+
+  // minimization_handle refers to a global minimization that is running in
+  // the background, started by start_global_minimization. It allows the
+  // caller to watch the progress of the search, to wait (with or without a
+  // timeout) for it to finish, and to cancel it.
+  //
+  // Destroying a handle cancels the search it refers to, and waits for the
+  // local minimizations that are in progress to finish.
+  class minimization_handle {
+  public:
+    // A handle can be moved, but not assigned to, because assigning would
+    // abandon the search the handle already refers to.
+    minimization_handle(minimization_handle&&) = default;
+    minimization_handle& operator=(minimization_handle&&) = delete;
+    ~minimization_handle();
+
+    // Return the best solution found so far, if any.
+    std::optional<solution> best() const;
+
+    // Report how many local minimizations have been completed so far.
+    long num_attempts() const;
+
+    // Report the average number of local minimizations completed per
+    // millisecond, from the start of the search until now (or until the
+    // search finished, if it has).
+    double attempt_rate() const;
+
+    // Report whether the search has finished.
+    bool done() const;
+
+    // Wait until the search has finished, or until 'timeout' has passed.
+    // Returns true if the search has finished. No thread spins while waiting.
+    bool wait_for(std::chrono::milliseconds timeout) const;
+
+    // Wait until the search has finished.
+    void wait() const;
+
+    // Ask the search to stop. Local minimizations in progress are allowed to
+    // finish, and their results are recorded; no new ones are started. This
+    // does not wait for the search to finish.
+    void cancel();
+
+    // Wait until the search has finished, and return its results. If the
+    // function being minimized threw an exception, it is rethrown here.
+    minimization_results results() const;
+
+  private:
+    struct state;
+
+    explicit minimization_handle(std::shared_ptr<state> s, int concurrency);
+
+    // Run 'work' in the background. 'work' is given the shared_result and
+    // engine to use.
+    void launch(
+      std::function<void(shared_result&, protected_engine<std::mt19937>&)>
+        work);
+
+    template <typename FUNC>
+    friend minimization_handle start_global_minimization(
+      FUNC&& func,
+      region<column_vector> const& starting_point_volume,
+      int num_starting_points,
+      double tolerance,
+      long max_attempts,
+      std::function<void(solution const&)> on_improvement);
+
+    std::shared_ptr<state> state_;
+    std::unique_ptr<oneapi::tbb::task_arena> arena_;
+  };
+
+  // Implementation details below.
+
+  // The state shared between a handle and the search running in the
+  // background.
+  struct minimization_handle::state {
+    state(double tolerance, std::size_t max_results, std::time_t seed)
+      : solutions(tolerance, max_results), engine(seed)
+    {}
+
+    shared_result solutions;
+    protected_engine<std::mt19937> engine;
+    double tstart = 0.0;
+
+    std::mutex mutable m;
+    std::condition_variable mutable finished_cv;
+    bool finished = false;
+    double tstop = 0.0;
+    std::exception_ptr error;
+  };
+
+  template <typename FUNC>
+  minimization_handle
+  start_global_minimization(FUNC&& func,
+                            region<column_vector> const& starting_point_volume,
+                            int num_starting_points,
+                            double tolerance,
+                            long max_attempts,
+                            std::function<void(solution const&)> on_improvement)
+  {
+    auto s = std::make_shared<minimization_handle::state>(
+      tolerance, num_starting_points, std::time(0));
+    if (on_improvement)
+      s->solutions.on_improvement(std::move(on_improvement));
+
+    minimization_handle handle(s, num_starting_points);
+    // The background work owns copies of the function and the region.
+    handle.launch([f = std::decay_t<FUNC>(std::forward<FUNC>(func)),
+                   volume = starting_point_volume,
+                   num_starting_points,
+                   max_attempts](shared_result& solutions,
+                                 protected_engine<std::mt19937>& engine) {
+      run_parallel_minimizers(
+        f, volume, solutions, engine, num_starting_points, max_attempts);
+    });
+    return handle;
+  }
+}
+
+#endif
@@ -0,0 +1,70 @@
+#include "async_minimizer.hh"
+#include "geometry.hh"
+#include "rastrigin.hh"
+#include "solution.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <chrono>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("async search finds the minimum")
+{
+  auto const volume = pfc::make_box_in_n_dim(2, -5.0, 5.0);
+  std::mutex m;
+  std::vector<double> improvements;
+  auto handle = pfc::start_global_minimization(
+    pfc::rastrigin_dlib, volume, 2, 1.e-6, 100000, [&](pfc::solution const& s) {
+      std::scoped_lock lock(m);
+      improvements.push_back(s.value);
+    });
+  auto [solutions, num_attempts] = handle.results();
+  CHECK(handle.done());
+  CHECK(handle.wait_for(std::chrono::milliseconds(0)));
+  REQUIRE(!solutions.empty());
+  CHECK(num_attempts == handle.num_attempts());
+  CHECK(handle.best()->value < 1.e-6);
+
+  // Each call of the callback reports a strict improvement, and the last one
+  // is the best solution.
+  std::scoped_lock lock(m);
+  REQUIRE(!improvements.empty());
+  for (std::size_t i = 1; i < improvements.size(); ++i)
+    CHECK(improvements[i] < improvements[i - 1]);
+  CHECK(improvements.back() == handle.best()->value);
+}
+
+TEST_CASE("async search can be cancelled")
+{
+  auto const volume = pfc::make_box_in_n_dim(2, -5.0, 5.0);
+  // A desired minimum that can never be reached means only cancellation (or
+  // the very large attempt limit) stops the search.
+  double const never = -std::numeric_limits<double>::infinity();
+  auto handle = pfc::start_global_minimization(
+    pfc::rastrigin_dlib, volume, 2, never, std::numeric_limits<long>::max());
+  CHECK(!handle.wait_for(std::chrono::milliseconds(50)));
+  handle.cancel();
+  handle.wait();
+  CHECK(handle.done());
+  long const n = handle.num_attempts();
+  CHECK(n > 0);
+  CHECK(handle.attempt_rate() > 0.0);
+  // Once finished, nothing more is done.
+  CHECK(handle.num_attempts() == n);
+}
+
+TEST_CASE("async search reports exceptions")
+{
+  auto const volume = pfc::make_box_in_n_dim(2, -5.0, 5.0);
+  auto handle = pfc::start_global_minimization(
+    [](pfc::column_vector const&) -> double {
+      throw std::runtime_error("bad function");
+    },
+    volume,
+    2,
+    1.e-6);
+  CHECK_THROWS_AS(handle.results(), std::runtime_error);
+}
@@ -1,7 +1,13 @@
+#include "local_minimizer_comparison.hh"
 #include "minimizers.hh"
+#include "nelder_mead.hh"
+#include "remez.hh"
 
 #include <cmath>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <vector>
 
 using column_vector = pfc::column_vector;
 
@@ -39,14 +45,94 @@ objective_function(column_vector const& params)
   return max_abs_deviation(params);
 }
 
+// Fit the parameters of better_atan_core with the Remez exchange algorithm.
+// better_atan_core is not linear in its parameters, because a(2) and a(3)
+// appear as a product. Writing b = a(2) * a(3), it is
+//   a(0) z - a(1) z(z-1) - b z^2(z-1) - a(2) z^3(z-1)
+// which is linear in (a(0), a(1), b, a(2)); we fit those, and then recover
+// a(3) = b / a(2).
+inline pfc::solution
+fit_with_remez()
+{
+  std::vector<std::function<double(double)>> const basis{
+    [](double z) { return z; },
+    [](double z) { return -z * (z - 1); },
+    [](double z) { return -z * z * (z - 1); },
+    [](double z) { return -z * z * z * (z - 1); }};
+  pfc::solution result;
+  result.tstart = pfc::now_in_milliseconds();
+  auto const fit = pfc::remez_fit(
+    [](double z) { return std::atan2(z, 1.0); }, basis, 0.0, 1.0);
+  result.tstop = pfc::now_in_milliseconds();
+  auto const& c = fit.coefficients;
+  result.location = column_vector({c[0], c[1], c[3], c[2] / c[3]});
+  // We report the deviation as measured by the objective used by the
+  // minimizers, so the results of the two methods can be compared directly.
+  result.start = result.location;
+  result.value = result.start_value = max_abs_deviation(result.location);
+  result.nsteps = fit.iterations;
+  return result;
+}
+
 int
-main()
+main(int argc, char** argv)
 {
+  std::string const mode = (argc > 1) ? argv[1] : "";
+  if (argc > 3 || (argc > 1 && mode != "compare" && mode != "remez")) {
+    std::cerr << "Usage: atan2_fitting [remez | compare [runs]]\n";
+    return 1;
+  }
   long const ndim = 4;
   double const tolerance = 1.e-6;
   long const num_starting_points = 20;
   long max_attempts = 1 * 1000;
   auto starting_volume = pfc::make_box_in_n_dim(ndim, -1.0, 1.0);
+
+  // In 'remez' mode, we fit using the Remez exchange algorithm rather than
+  // minimizing the maximum deviation.
+  if (mode == "remez") {
+    pfc::print_report({fit_with_remez()}, std::cout);
+    return 0;
+  }
+
+  // In 'compare' mode, we compare the success rate and cost of the local
+  // minimization policies, rather than doing a single fit.
+  if (mode == "compare") {
+    int const runs = (argc > 2) ? std::stoi(argv[2]) : 10;
+    pfc::print_comparison_header(std::cout);
+    pfc::compare_local_minimizer("bfgs",
+                                 objective_function,
+                                 starting_volume,
+                                 num_starting_points,
+                                 tolerance,
+                                 max_attempts,
+                                 runs,
+                                 pfc::bfgs_minimizer(),
+                                 std::cout);
+    pfc::compare_local_minimizer("nelder_mead",
+                                 objective_function,
+                                 starting_volume,
+                                 num_starting_points,
+                                 tolerance,
+                                 max_attempts,
+                                 runs,
+                                 pfc::nelder_mead_minimizer(),
+                                 std::cout);
+    // The same method, without the speculative parallel evaluation of the
+    // candidate points of each iteration.
+    pfc::nelder_mead_minimizer serial_nelder_mead;
+    serial_nelder_mead.parallel_steps = false;
+    pfc::compare_local_minimizer("nelder_mead_serial",
+                                 objective_function,
+                                 starting_volume,
+                                 num_starting_points,
+                                 tolerance,
+                                 max_attempts,
+                                 runs,
+                                 serial_nelder_mead,
+                                 std::cout);
+    return 0;
+  }
   auto [solutions, num_attempts] = pfc::find_global_minimum(objective_function,
                                                             ndim,
                                                             starting_volume,
@@ -0,0 +1,58 @@
+#include "basin_hopping.hh"
+
+#include <cassert>
+
+namespace pfc {
+
+  best_channel::best_channel(std::size_t ndim) : ndim_(ndim) {}
+
+  best_channel::~best_channel()
+  {
+    record const* r = best_.load(std::memory_order_relaxed);
+    while (r != nullptr) {
+      record const* previous = r->previous;
+      delete r;
+      r = previous;
+    }
+  }
+
+  bool
+  best_channel::publish(column_vector const& location, double value)
+  {
+    assert(static_cast<std::size_t>(location.size()) == ndim_);
+    record const* current = best_.load(std::memory_order_acquire);
+    if (current != nullptr && !(value < current->value))
+      return false;
+
+    auto r = new record{location, value, current};
+    // On failure, 'current' is the record another thread has published since
+    // we loaded it; ours is still better than that, or we give up.
+    while (!best_.compare_exchange_weak(
+      current, r, std::memory_order_release, std::memory_order_acquire)) {
+      if (current != nullptr && !(value < current->value)) {
+        delete r;
+        return false;
+      }
+      r->previous = current;
+    }
+    return true;
+  }
+
+  double
+  best_channel::value() const
+  {
+    record const* r = best_.load(std::memory_order_acquire);
+    return (r == nullptr) ? std::numeric_limits<double>::infinity() : r->value;
+  }
+
+  bool
+  best_channel::read(column_vector& location, double& value) const
+  {
+    record const* r = best_.load(std::memory_order_acquire);
+    if (r == nullptr)
+      return false;
+    location = r->location;
+    value = r->value;
+    return true;
+  }
+}
@@ -0,0 +1,256 @@
+#ifndef PROFILED_FC_CPU_BASIN_HOPPING_HH
+#define PROFILED_FC_CPU_BASIN_HOPPING_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "protected_engine.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <ctime>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace pfc {
+
+  // best_channel holds the best location and value published by any of a
+  // set of threads, without locking. Each publication is an immutable record,
+  // made before it is published; publishing swaps an atomic pointer to the
+  // best record with a compare-and-swap, which fails only if another thread
+  // has published in the meantime, and reading is a single load of that
+  // pointer. Records are never changed or freed while the channel exists, so
+  // a reader can never see a torn or freed record; the cost is one record
+  // for each improvement, which suits the basin-hopping walkers, which read
+  // the best far more often than they improve it.
+  class best_channel {
+  public:
+    explicit best_channel(std::size_t ndim);
+    ~best_channel();
+
+    best_channel(best_channel const&) = delete;
+    best_channel& operator=(best_channel const&) = delete;
+
+    // Publish 'location' and 'value' if 'value' is less than the value
+    // currently held. Return true if it was published.
+    bool publish(column_vector const& location, double value);
+
+    // Return the value currently held; infinity if nothing has been
+    // published.
+    double value() const;
+
+    // Copy the location and value currently held into 'location' and
+    // 'value'. Return false, leaving them unchanged, if nothing has been
+    // published.
+    bool read(column_vector& location, double& value) const;
+
+  private:
+    struct record {
+      column_vector location;
+      double value;
+      record const* previous; // the record this one replaced
+    };
+
+    std::atomic<record const*> best_ = nullptr;
+    std::size_t ndim_;
+
+    static_assert(std::atomic<record const*>::is_always_lock_free);
+  };
+
+  // basin_hopping_config controls run_basin_hopping.
+  struct basin_hopping_config {
+    // The number of walkers; 0 means one per thread.
+    int num_walkers = 0;
+    // The initial step of the perturbations, as a fraction of the extent of
+    // the region in each coordinate.
+    double initial_step = 0.1;
+    // The temperature of the Metropolis acceptance, in units of the function.
+    double temperature = 1.0;
+    // Every 'adapt_interval' hops a walker compares the fraction of those
+    // hops it accepted with 'target_acceptance', and multiplies its step by
+    // 'step_factor' if it accepted too few, or divides it if too many.
+    double target_acceptance = 0.5;
+    long adapt_interval = 10;
+    double step_factor = 0.9;
+    // A walker that has not improved on its own best for this many hops
+    // moves to the best minimum published by any walker.
+    long patience = 20;
+    // The seed of the random number engines; 0 means use the time.
+    unsigned seed = 0;
+  };
+
+  // Run basin-hopping walkers over 'bounds' until 'solutions' says we are
+  // done, or 'max_attempts' solutions have been inserted.
+  //
+  // Each walker starts from one of the solutions already in 'solutions'
+  // (best first), or from a random minimum if there are none. Each hop
+  // perturbs the walker's current minimum uniformly within its step, clamped
+  // to 'bounds', minimizes from there with 'local_minimizer', inserts the
+  // result into 'solutions', and moves to the new minimum with the
+  // Metropolis probability min(1, exp(-delta / temperature)). The walkers
+  // share the best minimum found through a best_channel, without locking;
+  // see basin_hopping_config::patience.
+  //
+  // The walkers are run with tbb::parallel_for in the current task arena.
+  template <typename FUNC, typename LOCAL = bfgs_minimizer>
+  void run_basin_hopping(FUNC const& func,
+                         region<column_vector> const& bounds,
+                         shared_result& solutions,
+                         long max_attempts,
+                         basin_hopping_config const& config = {},
+                         LOCAL local_minimizer = LOCAL());
+
+  // Search as find_global_minimum does, but spend only 'config.max_attempts
+  // / 10' attempts (and at least one per walker) on random starts, and the
+  // rest on basin hopping from the best of them.
+  template <typename FUNC, typename LOCAL = bfgs_minimizer>
+  minimization_results find_global_minimum_hopping(
+    FUNC const& func,
+    region<column_vector> const& starting_point_volume,
+    double tolerance,
+    search_config const& config,
+    basin_hopping_config const& hopping = {},
+    LOCAL local_minimizer = LOCAL());
+
+  // Implementation details below.
+
+  template <typename FUNC, typename LOCAL>
+  void
+  run_basin_hopping(FUNC const& func,
+                    region<column_vector> const& bounds,
+                    shared_result& solutions,
+                    long max_attempts,
+                    basin_hopping_config const& config,
+                    LOCAL local_minimizer)
+  {
+    int const num_walkers =
+      (config.num_walkers > 0)
+        ? config.num_walkers
+        : oneapi::tbb::this_task_arena::max_concurrency();
+    unsigned const seed = (config.seed == 0)
+                            ? static_cast<unsigned>(std::time(0))
+                            : config.seed;
+    std::size_t const ndim = bounds.ndims();
+
+    auto starts = solutions.solutions();
+    std::sort(starts.begin(), starts.end());
+    best_channel best(ndim);
+    if (!starts.empty())
+      best.publish(starts.front().location, starts.front().value);
+
+    auto walk = [&](int w) {
+      std::mt19937 engine(seed + static_cast<unsigned>(w));
+      std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+      std::uniform_real_distribution<double> unit;
+
+      solution current;
+      if (starts.empty()) {
+        if (solutions.is_done(max_attempts))
+          return;
+        current = local_minimizer(
+          func, random_point_within(bounds, engine), solutions);
+        solutions.insert(current);
+        best.publish(current.location, current.value);
+      } else {
+        current = starts[static_cast<std::size_t>(w) % starts.size()];
+      }
+
+      double step = config.initial_step;
+      double own_best = current.value;
+      long since_improvement = 0;
+      long accepted = 0; // in the current adaptation interval
+      long hops = 0;
+      column_vector start(ndim);
+      while (!solutions.is_done(max_attempts)) {
+        for (std::size_t i = 0; i != ndim; ++i)
+          start(i) = std::clamp(current.location(i) +
+                                  step * bounds.width(i) * uniform(engine),
+                                bounds.lower(i),
+                                bounds.upper(i));
+        solution trial = local_minimizer(func, start, solutions);
+        solutions.insert(trial);
+        ++hops;
+
+        double const delta = trial.value - current.value;
+        if (delta <= 0.0 ||
+            unit(engine) < std::exp(-delta / config.temperature)) {
+          current = trial;
+          ++accepted;
+        }
+        if (trial.value < own_best) {
+          own_best = trial.value;
+          since_improvement = 0;
+          best.publish(trial.location, trial.value);
+        } else if (++since_improvement >= config.patience) {
+          // Give up on this part of the space, and join the best walker.
+          column_vector location(ndim);
+          double value = 0.0;
+          if (best.read(location, value) && value < current.value) {
+            current.location = location;
+            current.value = value;
+            own_best = value;
+          }
+          since_improvement = 0;
+        }
+
+        if (hops % config.adapt_interval == 0) {
+          double const rate =
+            static_cast<double>(accepted) / config.adapt_interval;
+          step = (rate < config.target_acceptance) ? step * config.step_factor
+                                                   : step / config.step_factor;
+          step = std::min(step, 1.0);
+          accepted = 0;
+        }
+      }
+    };
+
+    oneapi::tbb::parallel_for(0, num_walkers, walk);
+  }
+
+  template <typename FUNC, typename LOCAL>
+  minimization_results
+  find_global_minimum_hopping(
+    FUNC const& func,
+    region<column_vector> const& starting_point_volume,
+    double tolerance,
+    search_config const& config,
+    basin_hopping_config const& hopping,
+    LOCAL local_minimizer)
+  {
+    shared_result solutions(tolerance, config.num_retained);
+    protected_engine<std::mt19937> engine(std::time(0));
+    run_with_concurrency(config.concurrency, [&]() {
+      long const num_walkers =
+        (hopping.num_walkers > 0)
+          ? hopping.num_walkers
+          : oneapi::tbb::this_task_arena::max_concurrency();
+      long const random_starts =
+        std::min(config.max_attempts,
+                 std::max(config.max_attempts / 10, num_walkers));
+      run_parallel_attempts(func,
+                            starting_point_volume,
+                            solutions,
+                            engine,
+                            random_starts,
+                            config.grain_size,
+                            local_minimizer);
+      run_basin_hopping(func,
+                        starting_point_volume,
+                        solutions,
+                        config.max_attempts,
+                        hopping,
+                        local_minimizer);
+    });
+    return {solutions.solutions(), solutions.num_attempts()};
+  }
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "basin_hopping.hh"
+#include "geometry.hh"
+#include "rastrigin.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "tbb/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+
+TEST_CASE("best_channel keeps the best value published")
+{
+  pfc::best_channel channel(2);
+  pfc::column_vector location(2);
+  double value = 0.0;
+  CHECK_FALSE(channel.read(location, value));
+
+  // Each point published has both coordinates equal to its value, so a torn
+  // read would show up as unequal coordinates.
+  std::atomic<int> torn_reads = 0;
+  oneapi::tbb::parallel_for(0, 1000, [&](int i) {
+    double const v = 1000.0 - i;
+    channel.publish(pfc::column_vector({v, v}), v);
+    pfc::column_vector seen(2);
+    double seen_value = 0.0;
+    if (channel.read(seen, seen_value) &&
+        (seen(0) != seen_value || seen(1) != seen_value))
+      torn_reads += 1;
+  });
+  CHECK(torn_reads == 0);
+  REQUIRE(channel.read(location, value));
+  CHECK(value == 1.0);
+  CHECK(location(0) == 1.0);
+  CHECK_FALSE(channel.publish(pfc::column_vector({2.0, 2.0}), 2.0));
+}
+
+TEST_CASE("basin hopping finds the global minimum of Rastrigin in 5 dimensions")
+{
+  pfc::search_config config;
+  config.max_attempts = 20000;
+  pfc::basin_hopping_config hopping;
+  hopping.seed = 11;
+  auto [solutions, num_attempts] =
+    pfc::find_global_minimum_hopping(pfc::rastrigin_dlib,
+                                     pfc::make_box_in_n_dim(5, -5.0, 5.0),
+                                     1.0e-6,
+                                     config,
+                                     hopping);
+  REQUIRE(!solutions.empty());
+  double best = solutions.front().value;
+  for (auto const& s : solutions)
+    best = std::min(best, s.value);
+  CHECK(best < 1.0e-6);
+  CHECK(num_attempts < config.max_attempts);
+}
@@ -0,0 +1,138 @@
+#ifndef PROFILED_FC_CPU_BATCH_MINIMIZER_HH
+#define PROFILED_FC_CPU_BATCH_MINIMIZER_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "tbb/blocked_range.h"
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <ctime>
+#include <random>
+#include <ranges>
+#include <vector>
+
+namespace pfc {
+
+  // minimization_problem is one of the problems given to minimize_batch: the
+  // function to minimize, the region in which starting points are
+  // generated, and the value below which a solution is good enough to stop.
+  template <typename FUNC>
+  struct minimization_problem {
+    FUNC func;
+    region<column_vector> starting_point_volume;
+    double tolerance;
+  };
+
+  // batch_config holds the settings that apply to every problem of a batch.
+  struct batch_config {
+    // The number of best solutions to keep for each problem.
+    std::size_t num_retained = 4;
+    // The maximum number of local minimizations for each problem.
+    long max_attempts = 1000;
+    // The maximum number of threads to use; 0 means as many as TBB allows.
+    int concurrency = 0;
+    // The seed of the random number engines; 0 means use the time.
+    unsigned seed = 0;
+  };
+
+  // batch_result is the result of one problem of a batch.
+  struct batch_result {
+    std::vector<solution> best_solutions; // The best solutions, best first
+    long num_attempts = 0;  // The number of local minimizations done
+    bool converged = false; // True if a solution reached the tolerance
+    double wall_ms = 0.0;   // Time from the first attempt to the last
+  };
+
+  // Minimize each of a range of minimization_problem objects, returning the
+  // results in the same order as the problems.
+  //
+  // All the problems share one scheduler: the problems are scheduled with
+  // tbb::parallel_for, and the attempts for each problem with a nested
+  // tbb::parallel_for, so threads that run out of attempts for one problem
+  // take work from the others. Each problem stops on its own, when a solution
+  // reaches its tolerance or its attempts are used up; its remaining
+  // attempts are cancelled without affecting the other problems.
+  //
+  // The random number engines are per thread, and reused for all the
+  // problems, rather than one locked engine per problem as in
+  // find_global_minimum. This makes the starting points of a problem depend
+  // on the scheduling, and so not reproducible run to run, even with a fixed
+  // seed.
+  template <std::ranges::random_access_range PROBLEMS,
+            typename LOCAL = bfgs_minimizer>
+  std::vector<batch_result> minimize_batch(PROBLEMS const& problems,
+                                           batch_config const& config,
+                                           LOCAL local_minimizer = LOCAL());
+
+  // Implementation details below.
+
+  template <std::ranges::random_access_range PROBLEMS, typename LOCAL>
+  std::vector<batch_result>
+  minimize_batch(PROBLEMS const& problems,
+                 batch_config const& config,
+                 LOCAL local_minimizer)
+  {
+    std::size_t const nproblems = std::ranges::size(problems);
+    std::vector<batch_result> results(nproblems);
+
+    unsigned const seed = (config.seed == 0)
+                            ? static_cast<unsigned>(std::time(0))
+                            : config.seed;
+    std::atomic<unsigned> next_stream = 0;
+    oneapi::tbb::enumerable_thread_specific<std::mt19937> engines([&]() {
+      return std::mt19937(seed + next_stream.fetch_add(1));
+    });
+
+    auto solve = [&](std::size_t p) {
+      auto const& problem = std::ranges::begin(problems)[p];
+      shared_result solutions(problem.tolerance, config.num_retained);
+      double const tstart = now_in_milliseconds();
+
+      using range = oneapi::tbb::blocked_range<long>;
+      oneapi::tbb::task_group_context context;
+      oneapi::tbb::parallel_for(
+        range(0, config.max_attempts),
+        [&](range const& r) {
+          std::mt19937& engine = engines.local();
+          for (long i = r.begin(); i != r.end(); ++i) {
+            if (solutions.is_done(config.max_attempts)) {
+              context.cancel_group_execution();
+              return;
+            }
+            auto const starting_point =
+              random_point_within(problem.starting_point_volume, engine);
+            solutions.insert(
+              local_minimizer(problem.func, starting_point, solutions));
+          }
+        },
+        oneapi::tbb::auto_partitioner(),
+        context);
+
+      batch_result& result = results[p];
+      result.wall_ms = now_in_milliseconds() - tstart;
+      result.best_solutions = solutions.solutions();
+      std::sort(result.best_solutions.begin(), result.best_solutions.end());
+      result.num_attempts = solutions.num_attempts();
+      result.converged = !std::isnan(solutions.first_success_time());
+    };
+
+    run_with_concurrency(config.concurrency, [&]() {
+      using range = oneapi::tbb::blocked_range<std::size_t>;
+      oneapi::tbb::parallel_for(range(0, nproblems), [&](range const& r) {
+        for (std::size_t p = r.begin(); p != r.end(); ++p)
+          solve(p);
+      });
+    });
+    return results;
+  }
+}
+
+#endif
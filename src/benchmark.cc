@@ -0,0 +1,78 @@
+#include "benchmark.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+namespace pfc {
+
+  double
+  median(std::vector<double> values)
+  {
+    if (values.empty())
+      return std::nan("");
+    auto const n = values.size();
+    auto mid = values.begin() + n / 2;
+    std::nth_element(values.begin(), mid, values.end());
+    if (n % 2 == 1)
+      return *mid;
+    // For an even number of values, average the two middle values. The lower
+    // one is the largest value in the lower half.
+    double const upper = *mid;
+    double const lower = *std::max_element(values.begin(), mid);
+    return 0.5 * (lower + upper);
+  }
+
+  double
+  median_absolute_deviation(std::vector<double> const& values)
+  {
+    double const m = median(values);
+    std::vector<double> deviations;
+    deviations.reserve(values.size());
+    for (double v : values)
+      deviations.push_back(std::abs(v - m));
+    return median(std::move(deviations));
+  }
+
+  benchmark_result
+  summarize(std::string name,
+            std::string param,
+            std::vector<double> const& rep_times_ns,
+            long iterations)
+  {
+    benchmark_result result;
+    result.name = std::move(name);
+    result.param = std::move(param);
+    result.repetitions = rep_times_ns.size();
+    result.iterations = iterations;
+    if (rep_times_ns.empty())
+      return result;
+
+    std::vector<double> per_iteration;
+    per_iteration.reserve(rep_times_ns.size());
+    for (double t : rep_times_ns)
+      per_iteration.push_back(t / iterations);
+    result.median = median(per_iteration);
+    result.mad = median_absolute_deviation(per_iteration);
+    auto [lo, hi] =
+      std::minmax_element(per_iteration.begin(), per_iteration.end());
+    result.min = *lo;
+    result.max = *hi;
+    return result;
+  }
+
+  void
+  print_benchmark_header(std::ostream& os)
+  {
+    os << "name\tparam\treps\titers\tmedian_ns\tmad_ns\tmin_ns\tmax_ns\n";
+  }
+
+  std::ostream&
+  operator<<(std::ostream& os, benchmark_result const& r)
+  {
+    os << r.name << '\t' << r.param << '\t' << r.repetitions << '\t'
+       << r.iterations << '\t' << r.median << '\t' << r.mad << '\t' << r.min
+       << '\t' << r.max;
+    return os;
+  }
+}
@@ -0,0 +1,106 @@
+#ifndef PROFILED_FC_CPU_BENCHMARK_HH
+#define PROFILED_FC_CPU_BENCHMARK_HH
+
+#include <chrono>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace pfc {
+
+  // benchmark_config controls how a microbenchmark is run. Each repetition
+  // times 'iterations' consecutive calls of the function being measured. The
+  // first 'warmup' repetitions are run but their timings are discarded, so
+  // that caches, branch predictors and lazily-initialized state are warm
+  // before we start recording.
+  struct benchmark_config {
+    int warmup = 3;
+    int repetitions = 25;
+    long iterations = 1000;
+  };
+
+  // benchmark_result holds the summary statistics of one microbenchmark. All
+  // times are in nanoseconds per iteration. We report the median and the
+  // median absolute deviation (MAD) rather than the mean and standard
+  // deviation because timing distributions have long upper tails (interrupts,
+  // preemption, frequency changes) to which the median and MAD are insensitive.
+  struct benchmark_result {
+    std::string name;
+    std::string param; // free-form parameter, e.g. the dimension or threads
+    int repetitions = 0;
+    long iterations = 0;
+    double median = 0.0;
+    double mad = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+  };
+
+  // Return the median of the given values. The values are taken by value
+  // because we need to partially sort them.
+  double median(std::vector<double> values);
+
+  // Return the median absolute deviation of the given values from their
+  // median.
+  double median_absolute_deviation(std::vector<double> const& values);
+
+  // Build a benchmark_result from per-repetition timings, each of which is
+  // the time in nanoseconds for 'iterations' iterations. This is useful for
+  // benchmarks that need to do their own per-repetition setup and timing.
+  benchmark_result summarize(std::string name,
+                             std::string param,
+                             std::vector<double> const& rep_times_ns,
+                             long iterations);
+
+  // Prevent the compiler from optimizing away the computation of 'value'.
+  template <typename T>
+  void do_not_optimize(T const& value);
+
+  // Run 'func' (a callable taking no arguments) according to 'cfg', and
+  // return the summary statistics.
+  template <typename FUNC>
+  benchmark_result run_benchmark(std::string name,
+                                 std::string param,
+                                 benchmark_config const& cfg,
+                                 FUNC&& func);
+
+  // Print the header line, and a single result line, in the tab-separated
+  // format we use for all our machine-readable output.
+  void print_benchmark_header(std::ostream& os);
+  std::ostream& operator<<(std::ostream& os, benchmark_result const& r);
+
+  // Implementation details below.
+
+  template <typename T>
+  inline void
+  do_not_optimize(T const& value)
+  {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  template <typename FUNC>
+  benchmark_result
+  run_benchmark(std::string name,
+                std::string param,
+                benchmark_config const& cfg,
+                FUNC&& func)
+  {
+    using clock = std::chrono::steady_clock;
+    std::vector<double> times;
+    times.reserve(cfg.repetitions);
+    for (int rep = 0; rep != cfg.warmup + cfg.repetitions; ++rep) {
+      auto const start = clock::now();
+      for (long i = 0; i != cfg.iterations; ++i) {
+        func();
+      }
+      auto const stop = clock::now();
+      if (rep >= cfg.warmup) {
+        std::chrono::duration<double, std::nano> const delta = stop - start;
+        times.push_back(delta.count());
+      }
+    }
+    return summarize(
+      std::move(name), std::move(param), times, cfg.iterations);
+  }
+}
+
+#endif
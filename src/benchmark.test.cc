@@ -0,0 +1,49 @@
+#include "benchmark.hh"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+
+#include <vector>
+
+using Catch::Matchers::WithinAbs;
+
+TEST_CASE("median of odd and even length samples")
+{
+  CHECK(pfc::median({3.0, 1.0, 2.0}) == 2.0);
+  CHECK(pfc::median({4.0, 1.0, 3.0, 2.0}) == 2.5);
+  CHECK(pfc::median({7.0}) == 7.0);
+}
+
+TEST_CASE("median absolute deviation ignores outliers")
+{
+  std::vector<double> const values{1.0, 2.0, 3.0, 4.0, 1000.0};
+  CHECK(pfc::median(values) == 3.0);
+  // deviations are 2, 1, 0, 1, 997
+  CHECK(pfc::median_absolute_deviation(values) == 1.0);
+}
+
+TEST_CASE("summarize reports per-iteration times")
+{
+  std::vector<double> const rep_times{100.0, 200.0, 300.0};
+  auto r = pfc::summarize("test", "p", rep_times, 10);
+  CHECK(r.repetitions == 3);
+  CHECK(r.iterations == 10);
+  CHECK_THAT(r.median, WithinAbs(20.0, 1.e-12));
+  CHECK_THAT(r.mad, WithinAbs(10.0, 1.e-12));
+  CHECK_THAT(r.min, WithinAbs(10.0, 1.e-12));
+  CHECK_THAT(r.max, WithinAbs(30.0, 1.e-12));
+}
+
+TEST_CASE("run_benchmark records the requested repetitions")
+{
+  pfc::benchmark_config cfg;
+  cfg.warmup = 2;
+  cfg.repetitions = 5;
+  cfg.iterations = 3;
+  long ncalls = 0;
+  auto r = pfc::run_benchmark("count", "", cfg, [&]() { ++ncalls; });
+  CHECK(ncalls == (2 + 5) * 3);
+  CHECK(r.repetitions == 5);
+  CHECK(r.min <= r.median);
+  CHECK(r.median <= r.max);
+}
@@ -0,0 +1,49 @@
+# Compile SOURCE with COMPILER, asking GCC to report the loops it
+# vectorizes, and fail unless each loop marked with a trailing
+# '// vectorized' comment in SOURCE has been vectorized with 32-byte (AVX2)
+# vectors. This is run by ctest; see the vectorization tests in
+# CMakeLists.txt.
+#
+# Usage:
+#   cmake -DCOMPILER=<c++> -DSOURCE=<file> [-DFLAGS=<flag;flag;...>]
+#         -P check_vectorized.cmake
+
+execute_process(
+  COMMAND ${COMPILER} -std=c++20 -O3 -fopt-info-vec-optimized ${FLAGS} -S
+          -o /dev/null ${SOURCE}
+  RESULT_VARIABLE status
+  ERROR_VARIABLE report)
+if(NOT status EQUAL 0)
+  message(FATAL_ERROR "Unable to compile ${SOURCE}:\n${report}")
+endif()
+
+get_filename_component(name ${SOURCE} NAME)
+# file(STRINGS) skips empty lines, and CMake lists do not split on the
+# semicolons within square brackets, so the lines are taken one by one.
+file(READ ${SOURCE} rest)
+set(line_number 0)
+set(num_marked 0)
+while(NOT rest STREQUAL "")
+  math(EXPR line_number "${line_number} + 1")
+  string(FIND "${rest}" "\n" end)
+  if(end EQUAL -1)
+    set(line "${rest}")
+    set(rest "")
+  else()
+    string(SUBSTRING "${rest}" 0 ${end} line)
+    math(EXPR end "${end} + 1")
+    string(SUBSTRING "${rest}" ${end} -1 rest)
+  endif()
+  if(line MATCHES "// vectorized$")
+    math(EXPR num_marked "${num_marked} + 1")
+    string(REGEX MATCH
+           "${name}:${line_number}:[0-9]+: optimized: loop vectorized using 32 byte vectors"
+           found "${report}")
+    if(NOT found)
+      message(SEND_ERROR "The loop on line ${line_number} of ${name} was not vectorized")
+    endif()
+  endif()
+endwhile()
+if(num_marked EQUAL 0)
+  message(FATAL_ERROR "No loops of ${name} are marked '// vectorized'")
+endif()
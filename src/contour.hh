@@ -0,0 +1,398 @@
+#ifndef PROFILED_FC_CPU_CONTOUR_HH
+#define PROFILED_FC_CPU_CONTOUR_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "solution.hh"
+
+#include "dlib/optimization.h"
+#include "tbb/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <numbers>
+#include <vector>
+
+namespace pfc {
+
+  // contour_config controls trace_contour.
+  struct contour_config {
+    // The indices of the two parameters of interest; all the others are
+    // nuisance parameters, minimized over at each point.
+    std::size_t x_index = 0;
+    std::size_t y_index = 1;
+    // The value of the profiled delta chi-squared on the contour; 2.30 is
+    // the 68.3% level for two parameters.
+    double level = 2.30;
+    // The distance between successive contour points, as a fraction of the
+    // extent of the region in each of the two parameters.
+    double step = 0.02;
+    // The contour points are accurate to this, in delta chi-squared.
+    double level_tolerance = 1.0e-4;
+    // The number of rays from the best fit along which the first contour
+    // points are found; one contour segment is traced from each, in
+    // parallel.
+    int num_segments = 8;
+    // The maximum number of points in each segment.
+    long max_points_per_segment = 10000;
+    // The maximum number of threads to use; 0 means as many as TBB allows.
+    int concurrency = 0;
+  };
+
+  // contour_point is one point of a contour: the full parameter vector, with
+  // the nuisance parameters at their profiled values, and the profiled delta
+  // chi-squared there.
+  struct contour_point {
+    column_vector location;
+    double delta;
+  };
+
+  // contour_result is the result of trace_contour.
+  struct contour_result {
+    solution global_fit;               // The best fit found by the search
+    std::vector<contour_point> points; // In order around the contour
+    long num_profile_minimizations = 0;
+    // False if the contour leaves the region, or a segment could not be
+    // traced; the points are then the parts of the contour that were.
+    bool closed = true;
+  };
+
+  // Trace the contour on which the profile of 'func' (a chi-squared, or -2
+  // ln L) over all parameters except those of interest rises by
+  // config.level above its global minimum.
+  //
+  // The global minimum is first found with find_global_minimum, using
+  // 'tolerance' and 'search' as that function does. Then the contour is
+  // found along config.num_segments rays from the best fit, in parallel,
+  // and one segment is traced from each ray to the next, in parallel. Each
+  // step of a segment predicts the next point along the direction of the
+  // last step, and corrects it along the normal to that direction by a root
+  // search on the profiled delta chi-squared. Every profile minimization
+  // starts from the nuisance parameters of the previous point, so it takes
+  // only a few iterations.
+  //
+  // The contour is assumed to enclose the best fit. The tracing is done in
+  // coordinates in which the region has unit extent in both parameters of
+  // interest.
+  template <typename FUNC>
+  contour_result trace_contour(FUNC const& func,
+                               region<column_vector> const& bounds,
+                               double tolerance,
+                               search_config const& search,
+                               contour_config const& config = {});
+
+  // Return the number of profile minimizations of a grid over the region
+  // with the same spacing as the contour points of trace_contour.
+  long equivalent_grid_size(contour_config const& config);
+
+  // Implementation details below.
+
+  inline long
+  equivalent_grid_size(contour_config const& config)
+  {
+    long const n = static_cast<long>(std::ceil(1.0 / config.step)) + 1;
+    return n * n;
+  }
+
+  namespace detail {
+
+    // profile evaluates the profiled delta chi-squared at a point of the
+    // plane of the parameters of interest, given in unit coordinates
+    // relative to the best fit.
+    template <typename FUNC>
+    class profile {
+    public:
+      profile(FUNC const& func,
+              column_vector const& best_fit,
+              double best_value,
+              region<column_vector> const& bounds,
+              contour_config const& config,
+              std::atomic<long>& count)
+        : func_(func)
+        , best_fit_(best_fit)
+        , best_value_(best_value)
+        , ix_(config.x_index)
+        , iy_(config.y_index)
+        , wx_(bounds.width(config.x_index))
+        , wy_(bounds.width(config.y_index))
+        , count_(count)
+      {
+        for (long i = 0; i != best_fit.size(); ++i)
+          if (i != static_cast<long>(ix_) && i != static_cast<long>(iy_))
+            nuisance_index_.push_back(i);
+      }
+
+      // Return the full parameter vector at (u, v), with the nuisance
+      // parameters 'nuisance'.
+      column_vector
+      location(double u, double v, column_vector const& nuisance) const
+      {
+        column_vector x = best_fit_;
+        x(ix_) += u * wx_;
+        x(iy_) += v * wy_;
+        for (std::size_t k = 0; k != nuisance_index_.size(); ++k)
+          x(nuisance_index_[k]) = nuisance(k);
+        return x;
+      }
+
+      column_vector
+      best_nuisance() const
+      {
+        column_vector nuisance(nuisance_index_.size());
+        for (std::size_t k = 0; k != nuisance_index_.size(); ++k)
+          nuisance(k) = best_fit_(nuisance_index_[k]);
+        return nuisance;
+      }
+
+      // Return the profiled delta chi-squared at (u, v), minimizing from
+      // 'nuisance', which is updated to the minimum found.
+      double
+      operator()(double u, double v, column_vector& nuisance) const
+      {
+        count_.fetch_add(1, std::memory_order_relaxed);
+        if (nuisance_index_.empty())
+          return func_(location(u, v, nuisance)) - best_value_;
+        auto restricted = [&](column_vector const& n) {
+          return func_(location(u, v, n));
+        };
+        solution const s = do_one_minimization(
+          restricted, nuisance, dlib::objective_delta_stop_strategy(1.0e-10));
+        nuisance = s.location;
+        return s.value - best_value_;
+      }
+
+    private:
+      FUNC const& func_;
+      column_vector best_fit_;
+      double best_value_;
+      std::size_t ix_;
+      std::size_t iy_;
+      double wx_;
+      double wy_;
+      std::vector<long> nuisance_index_;
+      std::atomic<long>& count_;
+    };
+
+    // Given g(a) and g(b) of opposite signs, find a root of g in [a, b]
+    // with the Illinois variant of regula falsi, stopping when |g| is no
+    // more than 'tolerance'. Return the root; if the search succeeds, it is
+    // the last point at which g was called.
+    template <typename G>
+    double
+    find_root(G&& g, double a, double ga, double b, double gb, double tolerance)
+    {
+      int side = 0;
+      for (int i = 0; i != 100; ++i) {
+        double const c = (a * gb - b * ga) / (gb - ga);
+        double const gc = g(c);
+        if (std::abs(gc) <= tolerance)
+          return c;
+        if ((gc > 0.0) == (gb > 0.0)) {
+          b = c;
+          gb = gc;
+          if (side == -1)
+            ga /= 2.0;
+          side = -1;
+        } else {
+          a = c;
+          ga = gc;
+          if (side == 1)
+            gb /= 2.0;
+          side = 1;
+        }
+      }
+      return (a * gb - b * ga) / (gb - ga);
+    }
+
+    struct plane_point {
+      double u;
+      double v;
+      column_vector nuisance;
+      double delta;
+      bool on_boundary = false;
+    };
+  }
+
+  template <typename FUNC>
+  contour_result
+  trace_contour(FUNC const& func,
+                region<column_vector> const& bounds,
+                double tolerance,
+                search_config const& search,
+                contour_config const& config)
+  {
+    contour_result result;
+    {
+      auto fit = find_global_minimum(func, bounds, tolerance, search);
+      result.global_fit = *std::min_element(fit.best_solutions.begin(),
+                                            fit.best_solutions.end());
+    }
+    column_vector const& best = result.global_fit.location;
+    std::atomic<long> count = 0;
+    detail::profile<FUNC> const profile(
+      func, best, result.global_fit.value, bounds, config, count);
+
+    // The limits of the region, in unit coordinates.
+    std::size_t const ix = config.x_index;
+    std::size_t const iy = config.y_index;
+    double const umin = (bounds.lower(ix) - best(ix)) / bounds.width(ix);
+    double const umax = (bounds.upper(ix) - best(ix)) / bounds.width(ix);
+    double const vmin = (bounds.lower(iy) - best(iy)) / bounds.width(iy);
+    double const vmax = (bounds.upper(iy) - best(iy)) / bounds.width(iy);
+    auto inside = [&](double u, double v) {
+      return u >= umin && u <= umax && v >= vmin && v <= vmax;
+    };
+
+    std::size_t const nsegments =
+      static_cast<std::size_t>(std::max(config.num_segments, 2));
+    std::vector<detail::plane_point> rays(nsegments);
+    std::vector<std::vector<detail::plane_point>> segments(nsegments);
+    std::atomic<bool> closed = true;
+
+    // Find the contour along one ray from the best fit, by doubling the
+    // distance until the level is crossed, then refining.
+    auto find_on_ray = [&](std::size_t k) {
+      double const angle = 2.0 * std::numbers::pi * k / nsegments;
+      double const du = std::cos(angle);
+      double const dv = std::sin(angle);
+      // The distance along the ray to the edge of the region.
+      double rmax = std::numeric_limits<double>::infinity();
+      if (du > 0.0)
+        rmax = std::min(rmax, umax / du);
+      if (du < 0.0)
+        rmax = std::min(rmax, umin / du);
+      if (dv > 0.0)
+        rmax = std::min(rmax, vmax / dv);
+      if (dv < 0.0)
+        rmax = std::min(rmax, vmin / dv);
+
+      column_vector nuisance = profile.best_nuisance();
+      // The last point evaluated, to which 'nuisance' belongs.
+      double last_r = 0.0;
+      double last_delta = 0.0;
+      auto g = [&](double r) {
+        last_r = r;
+        last_delta = profile(r * du, r * dv, nuisance);
+        return last_delta - config.level;
+      };
+      double a = 0.0;
+      double ga = -config.level;
+      double b = std::min(config.step, rmax);
+      double gb = g(b);
+      while (gb < 0.0 && b < rmax) {
+        a = b;
+        ga = gb;
+        b = std::min(2.0 * b, rmax);
+        gb = g(b);
+      }
+      detail::plane_point& p = rays[k];
+      if (gb < 0.0) {
+        p.on_boundary = true;
+        closed = false;
+      } else if (gb > config.level_tolerance) {
+        detail::find_root(g, a, ga, b, gb, config.level_tolerance);
+      }
+      p.delta = last_delta;
+      p.u = last_r * du;
+      p.v = last_r * dv;
+      p.nuisance = nuisance;
+    };
+
+    // Trace the contour from ray k to ray k + 1, counterclockwise.
+    auto trace_segment = [&](std::size_t k) {
+      auto& segment = segments[k];
+      detail::plane_point p = rays[k];
+      detail::plane_point const& target = rays[(k + 1) % nsegments];
+      segment.push_back(p);
+      if (p.on_boundary || target.on_boundary)
+        return;
+
+      double const max_step = config.step;
+      double const min_step = config.step / 1024.0;
+      double h = max_step;
+      double r = std::hypot(p.u, p.v);
+      double tu = -p.v / r;
+      double tv = p.u / r;
+      while (static_cast<long>(segment.size()) <
+             config.max_points_per_segment) {
+        if (std::hypot(target.u - p.u, target.v - p.v) <= h)
+          return;
+        // Predict along the tangent, then correct along the outward normal.
+        double const qu = p.u + h * tu;
+        double const qv = p.v + h * tv;
+        double const nu = tv;
+        double const nv = -tu;
+        column_vector nuisance = p.nuisance;
+        double last_s = 0.0;
+        double last_delta = 0.0;
+        auto g = [&](double s) {
+          last_s = s;
+          last_delta = profile(qu + s * nu, qv + s * nv, nuisance);
+          return last_delta - config.level;
+        };
+        double const g0 = g(0.0);
+        bool found = std::abs(g0) <= config.level_tolerance;
+        if (!found) {
+          // Search outward if we are inside the contour, inward if outside.
+          double const sign = (g0 < 0.0) ? 1.0 : -1.0;
+          double a = 0.0;
+          double ga = g0;
+          for (double b = 0.5 * h; b <= 8.0 * h; b *= 2.0) {
+            double const gb = g(sign * b);
+            if ((gb > 0.0) != (ga > 0.0)) {
+              detail::find_root(
+                g, sign * a, ga, sign * b, gb, config.level_tolerance);
+              found =
+                std::abs(last_delta - config.level) <= config.level_tolerance;
+              break;
+            }
+            a = b;
+            ga = gb;
+          }
+        }
+        if (!found) {
+          h /= 2.0;
+          if (h < min_step) {
+            closed = false;
+            return;
+          }
+          continue;
+        }
+        detail::plane_point next;
+        next.u = qu + last_s * nu;
+        next.v = qv + last_s * nv;
+        if (!inside(next.u, next.v)) {
+          closed = false;
+          return;
+        }
+        next.delta = last_delta;
+        next.nuisance = nuisance;
+        double const length = std::hypot(next.u - p.u, next.v - p.v);
+        tu = (next.u - p.u) / length;
+        tv = (next.v - p.v) / length;
+        segment.push_back(next);
+        p = next;
+        h = std::min(1.25 * h, max_step);
+      }
+      closed = false;
+    };
+
+    run_with_concurrency(config.concurrency, [&]() {
+      oneapi::tbb::parallel_for(std::size_t(0), nsegments, find_on_ray);
+      oneapi::tbb::parallel_for(std::size_t(0), nsegments, trace_segment);
+    });
+
+    for (auto const& segment : segments)
+      for (auto const& p : segment)
+        result.points.push_back(
+          {profile.location(p.u, p.v, p.nuisance), p.delta});
+    result.num_profile_minimizations = count.load();
+    result.closed = closed.load();
+    return result;
+  }
+}
+
+#endif
@@ -0,0 +1,54 @@
+#include "contour.hh"
+#include "geometry.hh"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+
+#include <cmath>
+
+using Catch::Matchers::WithinAbs;
+
+namespace {
+  // The profile of this function over z is the quadratic form
+  // x^2 + x y + y^2, whose contours are ellipses centred on the origin.
+  double
+  correlated(pfc::column_vector const& p)
+  {
+    double const x = p(0);
+    double const y = p(1);
+    double const z = p(2);
+    return x * x + x * y + y * y + 3.0 * (z - x + 2.0 * y) * (z - x + 2.0 * y);
+  }
+}
+
+TEST_CASE("a traced contour lies on the level set")
+{
+  pfc::search_config search;
+  search.max_attempts = 20;
+  pfc::contour_config config;
+  config.level = 1.0;
+  config.step = 0.01;
+  auto const bounds = pfc::make_box_in_n_dim(3, -5.0, 5.0);
+  auto const result =
+    pfc::trace_contour(correlated, bounds, 1.0e-12, search, config);
+
+  CHECK(result.closed);
+  REQUIRE(result.points.size() > 20);
+  for (auto const& p : result.points) {
+    double const x = p.location(0);
+    double const y = p.location(1);
+    CHECK_THAT(x * x + x * y + y * y, WithinAbs(1.0, 1.0e-3));
+    CHECK_THAT(p.delta, WithinAbs(1.0, 1.0e-3));
+  }
+  // Successive points are about one step apart; the correction along the
+  // normal can lengthen a step somewhat.
+  for (std::size_t i = 1; i != result.points.size(); ++i) {
+    double const du = (result.points[i].location(0) -
+                       result.points[i - 1].location(0)) / 10.0;
+    double const dv = (result.points[i].location(1) -
+                       result.points[i - 1].location(1)) / 10.0;
+    CHECK(std::hypot(du, dv) <= 2.0 * config.step);
+  }
+  CHECK(result.num_profile_minimizations <
+        pfc::equivalent_grid_size(config));
+}
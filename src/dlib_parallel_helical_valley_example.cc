@@ -16,9 +16,12 @@
 #include <string>
 #include <utility>
 
+// With the argument 'constrained', the local minimizations are kept within
+// the search volume; otherwise they are unconstrained.
 int
-main()
+main(int argc, char** argv)
 {
+  bool const constrained = (argc > 1 && std::string(argv[1]) == "constrained");
   long const ndim = 3;
   int const num_starting_points = oneapi::tbb::info::default_concurrency();
   std::cerr << "We are using: " << num_starting_points << " starting points\n";
@@ -32,8 +35,20 @@ main()
 
   pfc::CountedHelicalValley helical_valley;
 
-  auto [solutions, num_attempts] = pfc::find_global_minimum(
-    helical_valley, ndim, starting_volume, num_starting_points, tolerance);
+  auto [solutions, num_attempts] =
+    constrained ? pfc::find_global_minimum(
+                    helical_valley,
+                    ndim,
+                    starting_volume,
+                    num_starting_points,
+                    tolerance,
+                    1000000,
+                    pfc::box_constrained_minimizer(starting_volume))
+                : pfc::find_global_minimum(helical_valley,
+                                           ndim,
+                                           starting_volume,
+                                           num_starting_points,
+                                           tolerance);
   if (solutions.empty()) {
     std::cerr << "No solutions were found!\n";
     return 1;
@@ -42,7 +57,8 @@ main()
   // We print this count information to standard error so that redirecting
   // standard output to a file does not result in this text also being
   // redirected.
-  std::cerr << " A total of " << num_attempts << " minimizations were done.\n";
+  std::cerr << " A total of " << num_attempts << " minimizations were done, "
+            << "using " << helical_valley.ncalls() << " function calls.\n";
   std::sort(solutions.begin(), solutions.end());
   print_report(solutions, std::cout);
 }
@@ -1,34 +1,45 @@
 #include "geometry.hh"
 #include "minimizers.hh"
+#include "protected_engine.hh"
 #include "rastrigin.hh"
 #include "shared_result.hh"
 #include "solution.hh"
+#include "time_budget.hh"
 
 #include "tbb/task_arena.h" // for default_concurrency()
 #include "tbb/task_group.h"
 
 #include <chrono>
+#include <ctime>
 #include <iostream>
 #include <limits>
 #include <mutex>
+#include <random>
 #include <span>
 #include <string>
 #include <utility>
 
 // This is a simple wrapper to adapt the pfc::rastrigin function to the
-// interface expected by dlib.
-inline double
-rastrigin_dlib_wrapper(pfc::column_vector const& x)
-{
-  std::span xx = x;
-  return pfc::rastrigin(xx);
-}
+// interface expected by dlib. It accepts any vector type, so that
+// find_global_minimum can use fixed-size vectors for the dimensionality given
+// at run time.
+struct rastrigin_dlib_wrapper {
+  template <typename VEC>
+  double
+  operator()(VEC const& x) const
+  {
+    std::span xx = x;
+    return pfc::rastrigin(xx);
+  }
+};
 
 int
 main(int argc, char** argv)
 {
-  if (argc != 2) {
-    std::cerr << "Please specify the number of dimensions to use\n";
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Please specify the number of dimensions to use, "
+                 "optionally a time budget in milliseconds, and optionally "
+                 "the distance within which minima are considered the same\n";
     return 1;
   }
   long const ndim = std::stol(argv[1]);
@@ -37,11 +48,57 @@ main(int argc, char** argv)
   int const num_starting_points = oneapi::tbb::info::default_concurrency();
   auto starting_volume = pfc::make_box_in_n_dim(ndim, -10.0, 10.0);
 
+  // If a time budget and a distance are given, we search until the budget is
+  // used up, and report the distinct minima found rather than the best
+  // solutions, which are mostly the same minimum found many times.
+  if (argc == 4) {
+    pfc::shared_result solutions(-std::numeric_limits<double>::infinity(),
+                                 num_starting_points);
+    solutions.set_time_budget(pfc::time_budget(std::stod(argv[2])));
+    solutions.enable_minima_catalog(std::stod(argv[3]), 10000);
+    pfc::protected_engine<std::mt19937> engine(std::time(0));
+    rastrigin_dlib_wrapper func;
+    pfc::run_parallel_minimizers(func,
+                                 starting_volume,
+                                 solutions,
+                                 engine,
+                                 num_starting_points,
+                                 std::numeric_limits<long>::max(),
+                                 pfc::bfgs_minimizer());
+    auto const minima = solutions.minima();
+    std::cerr << "A total of " << solutions.num_attempts()
+              << " minimizations found " << minima.size()
+              << " distinct minima.\n";
+    pfc::print_minima(minima, std::cout);
+    return 0;
+  }
+
+  // If a time budget is given, we search until it is used up, and keep the
+  // best solutions found.
+  if (argc == 3) {
+    pfc::time_budget const budget(std::stod(argv[2]));
+    auto [solutions, num_attempts, percent_used] =
+      pfc::find_global_minimum_within(
+        rastrigin_dlib_wrapper(),
+        starting_volume,
+        num_starting_points,
+        budget);
+    std::cerr << "A total of " << num_attempts
+              << " minimizations were done using " << percent_used
+              << " percent of the time budget.\n";
+    pfc::print_report(solutions, std::cout);
+    return 0;
+  }
+
   // Create shared state for answer.
   // We're done when we have found a minimum with a value < 1.0e-6.
   auto start = pfc::now_in_milliseconds();
-  auto [solutions, num_attempts] = pfc::find_global_minimum(
-    rastrigin_dlib_wrapper, ndim, starting_volume, num_starting_points, 1.e-6);
+  auto [solutions, num_attempts] =
+    pfc::find_global_minimum(rastrigin_dlib_wrapper(),
+                             ndim,
+                             starting_volume,
+                             num_starting_points,
+                             1.e-6);
   auto stop = pfc::now_in_milliseconds();
 
   auto running_time = stop - start;
@@ -1,10 +1,11 @@
 #include "geometry.hh"
+#include "lipo_search.hh"
 #include "rastrigin.hh"
 
 #include "dlib/global_optimization.h"
 
 #include <iostream>
-#include <span>
+#include <limits>
 
 pfc::bounds
 pfc::make_bounds(int dim)
@@ -23,12 +24,6 @@ pfc::make_bounds(int dim)
 // arbitrary length, so we use the dynamic-sized version of column vector.
 using column_vector = dlib::matrix<double, 0, 1>;
 
-double
-rastrigin_dlib_wrapper(column_vector const& x)
-{
-  return pfc::rastrigin(std::span(x));
-}
-
 // Structure to supply the boundaries for the minimization search region.
 struct bounds {
   explicit bounds(int dim) : lower(dim), upper(dim) {}
@@ -49,21 +44,43 @@ make_bounds(int dim)
   return result;
 }
 
+// Do the same search as dlib::find_min_global, but with the function calls
+// made in parallel, by pfc::find_global_minimum_lipo. Like
+// dlib::find_min_global, it always makes maxcalls calls: no value is good
+// enough to stop early.
+dlib::function_evaluation
+parallel_find_min_global(column_vector const& lower_bounds,
+                         column_vector const& upper_bounds,
+                         long maxcalls)
+{
+  auto [solutions, num_calls] =
+    pfc::find_global_minimum_lipo(pfc::rastrigin_dlib,
+                                  {lower_bounds, upper_bounds},
+                                  maxcalls,
+                                  -std::numeric_limits<double>::infinity(),
+                                  1);
+  return dlib::function_evaluation(solutions.front().location,
+                                   solutions.front().value);
+}
+
 bool
 do_one_minimization(column_vector const& lower_bounds,
                     column_vector const& upper_bounds,
                     int dim,
                     long maxcalls,
+                    bool parallel,
                     std::ostream& os)
 {
   static bool first = true;
   auto start = std::chrono::steady_clock::now();
-  dlib::function_evaluation result = dlib::find_min_global(
-    rastrigin_dlib_wrapper,
-    lower_bounds,
-    upper_bounds,
-    dlib::max_function_calls(maxcalls) // max function evaluations
-  );
+  dlib::function_evaluation result =
+    parallel ? parallel_find_min_global(lower_bounds, upper_bounds, maxcalls)
+             : dlib::find_min_global(
+                 pfc::rastrigin_dlib,
+                 lower_bounds,
+                 upper_bounds,
+                 dlib::max_function_calls(maxcalls) // max function evaluations
+               );
   auto stop = std::chrono::steady_clock::now();
   auto delta_t = stop - start;
   // Print out the header the first time we're called
@@ -88,8 +105,9 @@ do_one_minimization(column_vector const& lower_bounds,
 int
 main(int argc, char* argv[])
 {
-  if (argc != 2) {
-    std::cerr << "Please supply the dimensionality to be used\n";
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Please supply the dimensionality to be used, and optionally "
+                 "'parallel' to make the function calls in parallel\n";
     return 1;
   }
   std::vector<std::string> args(argv + 1, argv + argc);
@@ -98,13 +116,14 @@ main(int argc, char* argv[])
     std::cerr << "Please supply a positive dimensionality less than 20\n";
     return 2;
   }
+  bool const parallel = (args.size() == 2 && args[1] == "parallel");
   auto [lower_bounds, upper_bounds] = make_bounds(dim);
 
   std::cout.precision(17);
   for (long i = 0; i != 24; ++i) {
     long maxcalls = std::pow(2, i);
-    bool converged =
-      do_one_minimization(lower_bounds, upper_bounds, dim, maxcalls, std::cout);
+    bool converged = do_one_minimization(
+      lower_bounds, upper_bounds, dim, maxcalls, parallel, std::cout);
     if (converged)
       break;
   }
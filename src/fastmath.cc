@@ -0,0 +1,61 @@
+#include "fastmath.hh"
+
+#include <cstddef>
+
+namespace pfc::fastmath {
+
+  // The first loop of each kernel is the one that is vectorized; it must
+  // contain no calls and no branches that can not be made into selects.
+  // The arguments the scalar kernels pass to the C library are counted in
+  // that loop, and fixed up in a second loop, which is only run if there
+  // are any. fastmath_vectorization_test checks the loops marked
+  // '// vectorized'.
+
+  PFC_FASTMATH_TARGETS void
+  acos(std::span<double const> x, std::span<double> out)
+  {
+    for (std::size_t i = 0; i != x.size(); ++i) // vectorized
+      out[i] = acos(x[i]);
+  }
+
+  PFC_FASTMATH_TARGETS void
+  atan2(std::span<double const> y,
+        std::span<double const> x,
+        std::span<double> out)
+  {
+    for (std::size_t i = 0; i != y.size(); ++i) // vectorized
+      out[i] = atan2(y[i], x[i]);
+  }
+
+  PFC_FASTMATH_TARGETS void
+  cos(std::span<double const> x, std::span<double> out)
+  {
+    long num_special = 0;
+    for (std::size_t i = 0; i != x.size(); ++i) { // vectorized
+      out[i] = detail::cos_kernel(x[i]);
+      num_special += detail::is_cos_special(x[i]);
+    }
+    if (num_special == 0)
+      return;
+    for (std::size_t i = 0; i != x.size(); ++i) {
+      if (detail::is_cos_special(x[i]))
+        out[i] = std::cos(x[i]);
+    }
+  }
+
+  PFC_FASTMATH_TARGETS void
+  log(std::span<double const> x, std::span<double> out)
+  {
+    long num_special = 0;
+    for (std::size_t i = 0; i != x.size(); ++i) { // vectorized
+      out[i] = detail::log_kernel(x[i]);
+      num_special += detail::is_log_special(x[i]);
+    }
+    if (num_special == 0)
+      return;
+    for (std::size_t i = 0; i != x.size(); ++i) {
+      if (detail::is_log_special(x[i]))
+        out[i] = std::log(x[i]);
+    }
+  }
+}
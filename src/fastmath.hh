@@ -0,0 +1,349 @@
+#ifndef PROFILED_FC_CPU_FASTMATH_HH
+#define PROFILED_FC_CPU_FASTMATH_HH
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numbers>
+#include <span>
+
+// pfc::fastmath provides approximations of acos, atan2, cos and log that are
+// faster than those of the C library, at the cost of accuracy. The
+// coefficients of acos, atan2 and cos were fitted with remez_fit; the program
+// fastmath_coefficients regenerates them. Those of log are the terms of the
+// series of atanh.
+//
+// Each kernel has a documented maximum absolute error, which is verified by
+// the tests on a fine grid covering the whole domain. The scalar kernels are
+// inline, so that they can be inlined into objective functions. The kernels
+// taking spans give the same results as the scalar ones, but are written to
+// be vectorized by the compiler: the argument reduction is done with bit
+// operations rather than calls or conversions, and the arguments that the
+// scalar kernels pass to the C library are handled in a separate pass, run
+// only if there are any. On x86-64 they are compiled both for the baseline
+// instruction set and for AVX2, and the version is chosen when the program
+// is loaded; only the AVX2 versions are fully vectorized, since the baseline
+// set lacks the 64-bit integer vector operations they need.
+// fastmath_vectorization_test checks, with GCC, that the main loop of each
+// AVX2 version is vectorized.
+//
+// None of the kernels sets errno or raises floating point exceptions in the
+// way the C library does. NaN arguments give NaN results.
+
+// On x86-64, each batch kernel is compiled for the baseline instruction set
+// and for AVX2, which has twice as many lanes; the dynamic loader picks the
+// version the processor supports. Other vectorized loops of the library use
+// the same attribute.
+#if defined(__x86_64__) && defined(__gnu_linux__) &&                        \
+  (defined(__clang__) || defined(__GNUC__))
+#define PFC_FASTMATH_TARGETS __attribute__((target_clones("avx2", "default")))
+#else
+#define PFC_FASTMATH_TARGETS
+#endif
+
+namespace pfc::fastmath {
+
+  // Maximum absolute error of acos, over [-1, 1].
+  inline constexpr double acos_max_error = 1.5e-8;
+
+  // Maximum absolute error of atan2, for all finite arguments. Infinite
+  // arguments are not supported. The signs of zero arguments are treated as
+  // by std::atan2.
+  inline constexpr double atan2_max_error = 2.0e-10;
+
+  // Maximum absolute error of cos, for |x| <= cos_max_argument. Larger
+  // arguments are passed to std::cos.
+  inline constexpr double cos_max_error = 1.0e-15;
+  inline constexpr double cos_max_argument = 1.0e6;
+
+  // Maximum error of log, relative to max(1, |log(x)|), for positive normal
+  // x. Other arguments (zero, negative, subnormal, infinite) are passed to
+  // std::log.
+  inline constexpr double log_max_error = 5.0e-16;
+
+  inline double acos(double x);
+  inline double atan2(double y, double x);
+  inline double cos(double x);
+  inline double log(double x);
+
+  // Batch forms: out[i] = f(in[i]). The output span must be at least as long
+  // as the input spans.
+  void acos(std::span<double const> x, std::span<double> out);
+  void atan2(std::span<double const> y,
+             std::span<double const> x,
+             std::span<double> out);
+  void cos(std::span<double const> x, std::span<double> out);
+  void log(std::span<double const> x, std::span<double> out);
+
+  // Math policies, to choose the implementation at each call site of an
+  // objective function, e.g. helical_valley_with<fastmath::fast_math>.
+  struct libm_math {
+    static double
+    acos(double x)
+    {
+      return std::acos(x);
+    }
+
+    static double
+    atan2(double y, double x)
+    {
+      return std::atan2(y, x);
+    }
+
+    static double
+    cos(double x)
+    {
+      return std::cos(x);
+    }
+
+    static double
+    log(double x)
+    {
+      return std::log(x);
+    }
+  };
+
+  struct fast_math {
+    static double
+    acos(double x)
+    {
+      return fastmath::acos(x);
+    }
+
+    static double
+    atan2(double y, double x)
+    {
+      return fastmath::atan2(y, x);
+    }
+
+    static double
+    cos(double x)
+    {
+      return fastmath::cos(x);
+    }
+
+    static double
+    log(double x)
+    {
+      return fastmath::log(x);
+    }
+  };
+
+  // Implementation details below.
+
+  namespace detail {
+
+    // acos(x) = sqrt(1 - x) * p(x) on [0, 1], coefficients in increasing
+    // powers of x.
+    inline constexpr double acos_coefficients[] = {
+      1.57079631431878375e+00,
+      -2.14599892442503076e-01,
+      8.89992649173495382e-02,
+      -5.03127849300585989e-02,
+      3.13354720632609482e-02,
+      -1.78089872049333915e-02,
+      7.24545051508049959e-03,
+      -1.44148066720599030e-03,
+    };
+
+    // atan(z) = z * p(z^2) on [0, 1].
+    inline constexpr double atan_coefficients[] = {
+      9.99999996672455538e-01,
+      -3.33333020897038312e-01,
+      1.99991298015394364e-01,
+      -1.42744321744704417e-01,
+      1.10286514174282077e-01,
+      -8.71386173427468602e-02,
+      6.54138186995328191e-02,
+      -4.20881606634866956e-02,
+      2.04678874698665109e-02,
+      -6.39479481803808137e-03,
+      9.37563972026888431e-04,
+    };
+
+    // cos(t) = p(t^2) and sin(t) = t * q(t^2) on [-pi/4, pi/4].
+    inline constexpr double cos_coefficients[] = {
+      1.00000000000000000e+00,
+      -4.99999999999995504e-01,
+      4.16666666665272481e-02,
+      -1.38888888744734089e-03,
+      2.48015802177744901e-05,
+      -2.75555147222166563e-07,
+      2.06475574159269601e-09,
+    };
+
+    inline constexpr double sin_coefficients[] = {
+      1.00000000000000000e+00,
+      -1.66666666666662106e-01,
+      8.33333333322614292e-03,
+      -1.98412697598462066e-04,
+      2.75572916428049925e-06,
+      -2.50475787930617100e-08,
+      1.57244137349512342e-10,
+    };
+
+    // log(m) = 2 s p(s^2), with s = (m - 1) / (m + 1), on [sqrt(1/2),
+    // sqrt(2)]; the coefficients are 1 / (2k + 1).
+    inline constexpr double log_coefficients[] = {
+      1.0,
+      1.0 / 3.0,
+      1.0 / 5.0,
+      1.0 / 7.0,
+      1.0 / 9.0,
+      1.0 / 11.0,
+      1.0 / 13.0,
+      1.0 / 15.0,
+      1.0 / 17.0,
+    };
+
+    // log(2) split into two parts; the first has trailing zero bits, so that
+    // e * ln2_hi is exact for every binary exponent e.
+    inline constexpr double ln2_hi = 6.93147180369123816490e-01;
+    inline constexpr double ln2_lo = 1.90821492927058770002e-10;
+
+    // pi/2 split into three parts for Cody-Waite argument reduction. The
+    // first two have trailing zero bits, so that k * part is exact for the
+    // values of k allowed by cos_max_argument.
+    inline constexpr double pio2_1 = 1.57079632673412561417e+00;
+    inline constexpr double pio2_2 = 6.07710050630396597660e-11;
+    inline constexpr double pio2_3 = 2.02226624879595063154e-21;
+
+    // Adding and then subtracting round_shift rounds a double of magnitude
+    // less than 2^51 to the nearest integer; the low bits of the sum are
+    // those of that integer, in two's complement.
+    inline constexpr double round_shift = 0x1.8p52;
+
+    // Return 'a' if 'c' is true, and 'b' otherwise. This is done with bit
+    // operations, because compilers do not turn a conditional expression
+    // into a select if one of its operands might raise a floating point
+    // exception, and so would not vectorize the loops of the batch kernels.
+    inline double
+    select(bool c, double a, double b)
+    {
+      std::uint64_t const mask = -static_cast<std::uint64_t>(c);
+      return std::bit_cast<double>((std::bit_cast<std::uint64_t>(a) & mask) |
+                                   (std::bit_cast<std::uint64_t>(b) & ~mask));
+    }
+
+    // Return 'x' with its sign bit flipped if 'y' is negative.
+    inline double
+    flip_sign(double x, double y)
+    {
+      std::uint64_t const sign = 0x8000000000000000ULL;
+      return std::bit_cast<double>(std::bit_cast<std::uint64_t>(x) ^
+                                   (std::bit_cast<std::uint64_t>(y) & sign));
+    }
+
+    // Evaluate the polynomial with coefficients 'c', in increasing powers, at
+    // x, by Horner's rule.
+    template <std::size_t N>
+    inline double
+    horner(double const (&c)[N], double x)
+    {
+      double sum = c[N - 1];
+      for (std::size_t i = N - 1; i != 0; --i)
+        sum = sum * x + c[i - 1];
+      return sum;
+    }
+
+    // The arguments that cos and log pass to the C library.
+    inline bool
+    is_cos_special(double x)
+    {
+      return !(std::abs(x) <= cos_max_argument);
+    }
+
+    inline bool
+    is_log_special(double x)
+    {
+      return !((x >= std::numeric_limits<double>::min()) &
+               (x <= std::numeric_limits<double>::max()));
+    }
+
+    // The kernels of cos and log, for the arguments that are not passed to
+    // the C library; they give meaningless results (but do not trap) for
+    // the others.
+    inline double
+    cos_kernel(double x)
+    {
+      double const shifted = x * (2.0 * std::numbers::inv_pi) + round_shift;
+      double const k = shifted - round_shift;
+      double const t = ((x - k * pio2_1) - k * pio2_2) - k * pio2_3;
+      double const t2 = t * t;
+      double const c = horner(cos_coefficients, t2);
+      double const s = t * horner(sin_coefficients, t2);
+      // cos(t + k pi/2) is cos(t), -sin(t), -cos(t), sin(t) for k = 0, 1, 2,
+      // 3 modulo 4.
+      std::uint64_t const quadrant = std::bit_cast<std::uint64_t>(shifted) & 3;
+      double const v = select(quadrant & 1, s, c);
+      std::uint64_t const sign = ((quadrant + 1) & 2) << 62;
+      return std::bit_cast<double>(std::bit_cast<std::uint64_t>(v) ^ sign);
+    }
+
+    inline double
+    log_kernel(double x)
+    {
+      // x = m 2^e, with m in [sqrt(1/2), sqrt(2)). The exponent is converted
+      // to a double by placing it in the mantissa of 2^52.
+      auto const bits = std::bit_cast<std::uint64_t>(x);
+      double m = std::bit_cast<double>((bits & 0x000fffffffffffffULL) |
+                                       0x3ff0000000000000ULL);
+      double e = std::bit_cast<double>((bits >> 52) | 0x4330000000000000ULL) -
+                 (0x1p52 + 1023.0);
+      bool const high = m > std::numbers::sqrt2;
+      m = select(high, 0.5 * m, m);
+      e = select(high, e + 1.0, e);
+      double const s = (m - 1.0) / (m + 1.0);
+      double const s2 = s * s;
+      double const logm = 2.0 * s * horner(log_coefficients, s2);
+      return e * ln2_hi + (logm + e * ln2_lo);
+    }
+  }
+
+  inline double
+  acos(double x)
+  {
+    double const a = std::abs(x);
+    double const r =
+      std::sqrt(1.0 - a) * detail::horner(detail::acos_coefficients, a);
+    return detail::select(x < 0.0, std::numbers::pi - r, r);
+  }
+
+  inline double
+  atan2(double y, double x)
+  {
+    double const ax = std::abs(x);
+    double const ay = std::abs(y);
+    double const big = std::max(ax, ay);
+    double const small = std::min(ax, ay);
+    double const z = detail::select(big == 0.0, 0.0, small / big);
+    double r = z * detail::horner(detail::atan_coefficients, z * z);
+    r = detail::select(ay > ax, 0.5 * std::numbers::pi - r, r);
+    // std::signbit is not vectorized by GCC, so we test the sign bit
+    // ourselves.
+    bool const x_negative = std::bit_cast<std::int64_t>(x) < 0;
+    r = detail::select(x_negative, std::numbers::pi - r, r);
+    return detail::flip_sign(r, y);
+  }
+
+  inline double
+  cos(double x)
+  {
+    if (detail::is_cos_special(x))
+      return std::cos(x);
+    return detail::cos_kernel(x);
+  }
+
+  inline double
+  log(double x)
+  {
+    if (detail::is_log_special(x))
+      return std::log(x);
+    return detail::log_kernel(x);
+  }
+}
+
+#endif
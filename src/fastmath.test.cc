@@ -0,0 +1,156 @@
+#include "fastmath.hh"
+#include "helical_valley.hh"
+#include "rastrigin.hh"
+#include "catch2/catch_test_macros.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numbers>
+#include <vector>
+
+namespace fm = pfc::fastmath;
+
+// The error bounds are checked on grids fine enough to resolve every
+// oscillation of the error of the fitted polynomials.
+
+TEST_CASE("acos is within its error bound on [-1, 1]")
+{
+  long const n = 2000000;
+  double max_error = 0.0;
+  for (long i = 0; i <= n; ++i) {
+    double const x = -1.0 + 2.0 * i / n;
+    max_error = std::max(max_error, std::abs(fm::acos(x) - std::acos(x)));
+  }
+  CHECK(max_error <= fm::acos_max_error);
+  CHECK(fm::acos(1.0) == 0.0);
+  CHECK(std::isnan(fm::acos(1.5)));
+}
+
+TEST_CASE("atan2 is within its error bound all around the circle")
+{
+  long const n = 2000000;
+  double max_error = 0.0;
+  for (long i = 0; i != n; ++i) {
+    double const phi = 2.0 * std::numbers::pi * i / n;
+    for (double radius : {1.0e-300, 1.0, 1.0e300}) {
+      double const x = radius * std::cos(phi);
+      double const y = radius * std::sin(phi);
+      max_error =
+        std::max(max_error, std::abs(fm::atan2(y, x) - std::atan2(y, x)));
+    }
+  }
+  CHECK(max_error <= fm::atan2_max_error);
+}
+
+TEST_CASE("atan2 treats zeros as std::atan2 does")
+{
+  for (double y : {0.0, -0.0}) {
+    for (double x : {0.0, -0.0, 1.0, -1.0}) {
+      CHECK(fm::atan2(y, x) == std::atan2(y, x));
+      CHECK(std::signbit(fm::atan2(y, x)) == std::signbit(std::atan2(y, x)));
+    }
+  }
+}
+
+TEST_CASE("cos is within its error bound up to its maximum argument")
+{
+  long const n = 4000000;
+  double max_error = 0.0;
+  // A fine grid over a few periods near zero...
+  for (long i = 0; i <= n; ++i) {
+    double const x = -20.0 + 40.0 * i / n;
+    max_error = std::max(max_error, std::abs(fm::cos(x) - std::cos(x)));
+  }
+  // ... and a coarser one out to the maximum argument.
+  for (long i = 0; i <= n; ++i) {
+    double const x = fm::cos_max_argument * i / n;
+    max_error = std::max(max_error, std::abs(fm::cos(x) - std::cos(x)));
+    max_error = std::max(max_error, std::abs(fm::cos(-x) - std::cos(-x)));
+  }
+  CHECK(max_error <= fm::cos_max_error);
+  CHECK(fm::cos(1.0e10) == std::cos(1.0e10));
+}
+
+TEST_CASE("log is within its error bound for all positive normal arguments")
+{
+  long const n = 4000000;
+  double max_error = 0.0;
+  auto check = [&](double x) {
+    double const expected = std::log(x);
+    max_error = std::max(max_error,
+                         std::abs(fm::log(x) - expected) /
+                           std::max(1.0, std::abs(expected)));
+  };
+  // A fine grid around 1, where log is small...
+  for (long i = 0; i <= n; ++i)
+    check(0.5 + 1.5 * i / n);
+  // ... and a logarithmic one over the whole normal range.
+  for (long i = 0; i <= n; ++i)
+    check(std::exp(-708.0 + 1417.0 * i / n));
+  CHECK(max_error <= fm::log_max_error);
+  CHECK(fm::log(1.0) == 0.0);
+  CHECK(std::isinf(fm::log(0.0)));
+  CHECK(std::isnan(fm::log(-1.0)));
+}
+
+TEST_CASE("batch kernels agree with the scalar kernels")
+{
+  std::vector<double> x;
+  std::vector<double> y;
+  for (int i = 0; i != 101; ++i) {
+    x.push_back(-1.0 + 0.02 * i);
+    y.push_back(0.5 - 0.01 * i);
+  }
+  std::vector<double> out(x.size());
+
+  fm::acos(x, out);
+  for (std::size_t i = 0; i != x.size(); ++i)
+    CHECK(out[i] == fm::acos(x[i]));
+  fm::atan2(y, x, out);
+  for (std::size_t i = 0; i != x.size(); ++i)
+    CHECK(out[i] == fm::atan2(y[i], x[i]));
+  fm::cos(x, out);
+  for (std::size_t i = 0; i != x.size(); ++i)
+    CHECK(out[i] == fm::cos(x[i]));
+  fm::log(y, out);
+  for (std::size_t i = 0; i != y.size(); ++i)
+    CHECK((out[i] == fm::log(y[i]) || std::isnan(out[i])));
+}
+
+TEST_CASE("objectives using fast_math agree with those using libm")
+{
+  using fm::fast_math;
+  for (double x : {-5.12, -1.5, 0.0, 0.25, 1.0, 3.7}) {
+    for (double y : {-2.0, 0.1, 4.9}) {
+      std::vector<double> const xy{x, y};
+      CHECK(std::abs(pfc::rastrigin_with<fast_math>(xy) - pfc::rastrigin(xy)) <=
+            1.0e-12);
+      pfc::column_vector const p({x, y, 0.5});
+      CHECK(std::abs(pfc::helical_valley_with<fast_math>(p) -
+                     pfc::helical_valley(p)) <= 1.0e-6);
+    }
+  }
+}
+
+TEST_CASE("batch kernels agree with the scalar kernels for special arguments")
+{
+  double const inf = std::numeric_limits<double>::infinity();
+  double const nan = std::numeric_limits<double>::quiet_NaN();
+  double const tiny = std::numeric_limits<double>::denorm_min();
+  // The special arguments are mixed with ordinary ones, so that both
+  // passes of the batch kernels write to the output.
+  std::vector<double> const x{
+    0.5, 1.0e10, -2.0, inf, 3.0, -inf, 0.0, nan, 7.0, -1.0, tiny, 1.0e300};
+  std::vector<double> out(x.size());
+  auto same = [](double a, double b) {
+    return (a == b) || (std::isnan(a) && std::isnan(b));
+  };
+
+  fm::cos(x, out);
+  for (std::size_t i = 0; i != x.size(); ++i)
+    CHECK(same(out[i], fm::cos(x[i])));
+  fm::log(x, out);
+  for (std::size_t i = 0; i != x.size(); ++i)
+    CHECK(same(out[i], fm::log(x[i])));
+}
@@ -0,0 +1,79 @@
+#include "remez.hh"
+
+#include "fmt/format.h"
+
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <numbers>
+#include <string>
+#include <vector>
+
+// This program generates the coefficient tables used by the kernels in
+// fastmath.hh, using remez_fit. Its output is C++ source that can be pasted
+// into fastmath.hh. The maximum error of each fit on the Remez grid is
+// written as a comment; the error bounds documented in fastmath.hh are
+// those verified by the tests, on a finer grid, and include rounding.
+
+namespace {
+
+  using basis_t = std::vector<std::function<double(double)>>;
+
+  void
+  print_table(std::string const& name,
+              pfc::remez_result const& fit,
+              std::ostream& os)
+  {
+    os << "    // max error of fit: " << fit.max_error
+       << (fit.converged ? "" : " (not converged)") << '\n';
+    os << "    inline constexpr double " << name << "[] = {\n";
+    for (double c : fit.coefficients)
+      os << fmt::format("      {:.17e},\n", c);
+    os << "    };\n";
+  }
+}
+
+int
+main()
+{
+  // acos(x) = sqrt(1 - x) * p(x) on [0, 1], as in hastings_acos_fitting.
+  {
+    basis_t basis;
+    for (int k = 0; k != 8; ++k)
+      basis.push_back(
+        [k](double x) { return std::pow(x, k) * std::sqrt(1.0 - x); });
+    auto const fit = pfc::remez_fit(
+      [](double x) { return std::acos(x); }, basis, 0.0, 1.0);
+    print_table("acos_coefficients", fit, std::cout);
+  }
+
+  // atan(z) = z * p(z^2) on [0, 1].
+  {
+    basis_t basis;
+    for (int k = 0; k != 11; ++k)
+      basis.push_back([k](double z) { return std::pow(z, 2 * k + 1); });
+    auto const fit = pfc::remez_fit(
+      [](double z) { return std::atan(z); }, basis, 0.0, 1.0);
+    print_table("atan_coefficients", fit, std::cout);
+  }
+
+  // cos(t) = p(t^2) and sin(t) = t * q(t^2) on [0, pi/4], for the reduced
+  // argument of cos.
+  double const quarter_pi = std::numbers::pi / 4.0;
+  {
+    basis_t basis;
+    for (int k = 0; k != 7; ++k)
+      basis.push_back([k](double t) { return std::pow(t, 2 * k); });
+    auto const fit = pfc::remez_fit(
+      [](double t) { return std::cos(t); }, basis, 0.0, quarter_pi);
+    print_table("cos_coefficients", fit, std::cout);
+  }
+  {
+    basis_t basis;
+    for (int k = 0; k != 7; ++k)
+      basis.push_back([k](double t) { return std::pow(t, 2 * k + 1); });
+    auto const fit = pfc::remez_fit(
+      [](double t) { return std::sin(t); }, basis, 0.0, quarter_pi);
+    print_table("sin_coefficients", fit, std::cout);
+  }
+}
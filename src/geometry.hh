@@ -25,6 +25,11 @@ namespace pfc {
   template <typename VEC = pfc::column_vector>
   class region;
 
+  // Return the regions made by splitting each of 'regions' 'ngenerations'
+  // times. This stores every region of every generation; region_tree (in
+  // region_tree.hh) computes the regions on demand instead, choosing the
+  // split dimensions by an exact rule that can differ from that of
+  // region::split when some widths are equal.
   template <typename VEC>
   std::vector<region<VEC>> make_splits(int ngenerations,
                                        std::vector<region<VEC>> const& regions);
@@ -1,7 +1,13 @@
+#include "local_minimizer_comparison.hh"
 #include "minimizers.hh"
+#include "nelder_mead.hh"
+#include "remez.hh"
 
 #include <cmath>
+#include <functional>
 #include <iostream>
+#include <string>
+#include <vector>
 
 using column_vector = pfc::column_vector;
 
@@ -42,12 +48,43 @@ objective_function(column_vector const& params)
   return max_abs_deviation(params);
 }
 
+// Fit the parameters of better_hastings directly with the Remez exchange
+// algorithm. better_hastings is linear in its parameters: parameter k
+// multiplies x^(ndim-1-k) * sqrt(1-x).
+inline pfc::solution
+fit_with_remez(long ndim)
+{
+  std::vector<std::function<double(double)>> basis;
+  for (long k = 0; k != ndim; ++k) {
+    basis.push_back([power = ndim - 1 - k](double x) {
+      return std::pow(x, power) * std::sqrt(1.0 - x);
+    });
+  }
+  pfc::solution result;
+  result.tstart = pfc::now_in_milliseconds();
+  auto const fit = pfc::remez_fit(
+    [](double x) { return std::acos(x); }, basis, 0.0, 1.0);
+  result.tstop = pfc::now_in_milliseconds();
+  result.location.set_size(ndim);
+  for (long k = 0; k != ndim; ++k)
+    result.location(k) = fit.coefficients[k];
+  // We report the deviation as measured by the objective used by the
+  // minimizers, so the results of the two methods can be compared directly.
+  result.start = result.location;
+  result.value = result.start_value = max_abs_deviation(result.location);
+  result.nsteps = fit.iterations;
+  return result;
+}
+
 int
 main(int argc, char** argv)
 {
-  if (argc != 3) {
+  std::string const mode = (argc > 3) ? argv[3] : "";
+  if (argc < 3 || argc > 5 ||
+      (argc > 3 && mode != "compare" && mode != "remez")) {
     std::cerr << "Please specify the number of fit parameters and the minimal "
-                 "tolerance to achieve\n.";
+                 "tolerance to achieve, and optionally 'remez', or 'compare' "
+                 "and the number of runs\n.";
     return 1;
   }
 
@@ -56,6 +93,52 @@ main(int argc, char** argv)
   long const num_starting_points = 12;
   long max_attempts = 1 * 1000;
   auto starting_volume = pfc::make_box_in_n_dim(ndim, -1.0, 1.0);
+
+  // In 'remez' mode, we fit using the Remez exchange algorithm rather than
+  // minimizing the maximum deviation.
+  if (mode == "remez") {
+    pfc::print_report({fit_with_remez(ndim)}, std::cout);
+    return 0;
+  }
+
+  // In 'compare' mode, we compare the success rate and cost of the local
+  // minimization policies, rather than doing a single fit.
+  if (mode == "compare") {
+    int const runs = (argc > 4) ? std::atoi(argv[4]) : 10;
+    pfc::print_comparison_header(std::cout);
+    pfc::compare_local_minimizer("bfgs",
+                                 objective_function,
+                                 starting_volume,
+                                 num_starting_points,
+                                 tolerance,
+                                 max_attempts,
+                                 runs,
+                                 pfc::bfgs_minimizer(),
+                                 std::cout);
+    pfc::compare_local_minimizer("nelder_mead",
+                                 objective_function,
+                                 starting_volume,
+                                 num_starting_points,
+                                 tolerance,
+                                 max_attempts,
+                                 runs,
+                                 pfc::nelder_mead_minimizer(),
+                                 std::cout);
+    // The same method, without the speculative parallel evaluation of the
+    // candidate points of each iteration.
+    pfc::nelder_mead_minimizer serial_nelder_mead;
+    serial_nelder_mead.parallel_steps = false;
+    pfc::compare_local_minimizer("nelder_mead_serial",
+                                 objective_function,
+                                 starting_volume,
+                                 num_starting_points,
+                                 tolerance,
+                                 max_attempts,
+                                 runs,
+                                 serial_nelder_mead,
+                                 std::cout);
+    return 0;
+  }
   auto [solutions, num_attempts] = pfc::find_global_minimum(objective_function,
                                                             ndim,
                                                             starting_volume,
@@ -1,32 +1,44 @@
 #pragma once
 
+#include "fastmath.hh"
 #include "geometry.hh"
 
 #include <cmath>
 #include <numbers>
 
 namespace pfc {
+  // MATH selects the implementation of atan2; see fastmath.hh.
+  template <typename MATH = fastmath::libm_math>
   inline double
   theta(double x, double y)
   {
-    double v = std::atan2(y, x);
+    double v = MATH::atan2(y, x);
     if (x < 0)
       v += std::numbers::pi;
     return 0.5 * std::numbers::inv_pi * v;
   }
 
+  // helical_valley_with<MATH> is the helical valley function, using the math
+  // policy MATH (fastmath::libm_math or fastmath::fast_math).
+  template <typename MATH>
   inline double
-  helical_valley(pfc::column_vector const& arg)
+  helical_valley_with(pfc::column_vector const& arg)
   {
     double const x = arg(0);
     double const y = arg(1);
     double const z = arg(2);
-    double const t2 = z - 10.0 * theta(x, y);
+    double const t2 = z - 10.0 * theta<MATH>(x, y);
     double const t3 = std::hypot(x, y) - 1.0;
     double const t1 = t2 * t2 + t3 * t3;
     return 100.0 * t1 + z * z;
   }
 
+  inline double
+  helical_valley(pfc::column_vector const& arg)
+  {
+    return helical_valley_with<fastmath::libm_math>(arg);
+  }
+
   // This callable class wraps the helical valley function to
   // count the number of times operator() is invoked.
   class CountedHelicalValley {
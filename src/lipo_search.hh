@@ -0,0 +1,99 @@
+#ifndef PROFILED_FC_CPU_LIPO_SEARCH_HH
+#define PROFILED_FC_CPU_LIPO_SEARCH_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "dlib/global_optimization.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
+#include <cstddef>
+#include <mutex>
+
+namespace pfc {
+
+  // Minimize 'func' over 'bounds' with dlib's MaxLIPO+TR global search (the
+  // method of dlib::find_min_global), making at most 'max_calls' function
+  // calls, and keeping the best 'num_retained' evaluations. The search stops
+  // early when a value less than 'tolerance' is found.
+  //
+  // dlib::find_min_global makes every function call from one thread. Here
+  // the calls are made from TBB tasks, so that every thread has a function
+  // evaluation outstanding: each task takes the next point from the shared
+  // dlib::global_function_search, evaluates the function there without
+  // holding any lock, and reports the value back. The choice of the next
+  // point is serialized, but the function calls are not, so this pays off
+  // when the function is not much cheaper than choosing the points.
+  // Because points are chosen while other evaluations are outstanding, the
+  // sequence of points differs from that of the serial search.
+  //
+  // Each function evaluation is reported as a solution whose start and
+  // location are the point evaluated; num_attempts is the number of function
+  // calls made.
+  template <typename FUNC>
+  minimization_results find_global_minimum_lipo(
+    FUNC const& func,
+    region<column_vector> const& bounds,
+    long max_calls,
+    double tolerance,
+    std::size_t num_retained = 16,
+    int concurrency = 0);
+
+  // Implementation details below.
+
+  template <typename FUNC>
+  minimization_results
+  find_global_minimum_lipo(FUNC const& func,
+                           region<column_vector> const& bounds,
+                           long max_calls,
+                           double tolerance,
+                           std::size_t num_retained,
+                           int concurrency)
+  {
+    shared_result solutions(tolerance, num_retained);
+    // global_function_search maximizes, so we give it the negated values.
+    dlib::global_function_search search(
+      dlib::function_spec(bounds.lower(), bounds.upper()));
+    std::mutex guard_search;
+
+    run_with_concurrency(concurrency, [&]() {
+      using range = oneapi::tbb::blocked_range<long>;
+      oneapi::tbb::task_group_context context;
+      oneapi::tbb::parallel_for(
+        range(0, max_calls),
+        [&](range const& r) {
+          for (long i = r.begin(); i != r.end(); ++i) {
+            if (solutions.is_done(max_calls)) {
+              context.cancel_group_execution();
+              return;
+            }
+            dlib::function_evaluation_request request;
+            {
+              std::scoped_lock lock(guard_search);
+              request = search.get_next_x();
+            }
+            solution s;
+            s.tstart = now_in_milliseconds();
+            s.start = request.x();
+            s.location = request.x();
+            s.value = s.start_value = func(s.location);
+            s.tstop = now_in_milliseconds();
+            s.nsteps = 0;
+            {
+              std::scoped_lock lock(guard_search);
+              request.set(-s.value);
+            }
+            solutions.insert(s);
+          }
+        },
+        oneapi::tbb::simple_partitioner(),
+        context);
+    });
+    return {solutions.solutions(), solutions.num_attempts()};
+  }
+}
+
+#endif
@@ -0,0 +1,56 @@
+#include "lipo_search.hh"
+#include "geometry.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+
+namespace {
+  std::atomic<long> num_calls = 0;
+
+  double
+  bowl(pfc::column_vector const& x)
+  {
+    num_calls.fetch_add(1);
+    return (x(0) - 0.25) * (x(0) - 0.25) + (x(1) + 0.5) * (x(1) + 0.5);
+  }
+
+  double
+  best_value(pfc::minimization_results const& results)
+  {
+    double best = std::numeric_limits<double>::infinity();
+    for (auto const& s : results.best_solutions)
+      best = std::min(best, s.value);
+    return best;
+  }
+}
+
+TEST_CASE("find_global_minimum_lipo makes max_calls calls")
+{
+  num_calls = 0;
+  long const max_calls = 500;
+  auto const results =
+    pfc::find_global_minimum_lipo(bowl,
+                                  pfc::make_box_in_n_dim(2, -1.0, 1.0),
+                                  max_calls,
+                                  -std::numeric_limits<double>::infinity(),
+                                  4);
+  CHECK(num_calls.load() == max_calls);
+  CHECK(results.num_attempts == max_calls);
+  CHECK(results.best_solutions.size() == 4);
+  CHECK(best_value(results) < 0.05);
+}
+
+TEST_CASE("find_global_minimum_lipo stops when the minimum is found")
+{
+  num_calls = 0;
+  long const max_calls = 10000;
+  auto const results = pfc::find_global_minimum_lipo(
+    bowl, pfc::make_box_in_n_dim(2, -1.0, 1.0), max_calls, 0.05);
+  CHECK(num_calls.load() <= max_calls);
+  CHECK(results.num_attempts == num_calls.load());
+  CHECK(results.num_attempts < max_calls);
+  CHECK(best_value(results) < 0.05);
+}
@@ -0,0 +1,97 @@
+#ifndef PROFILED_FC_CPU_LOCAL_MINIMIZER_COMPARISON_HH
+#define PROFILED_FC_CPU_LOCAL_MINIMIZER_COMPARISON_HH
+
+#include "benchmark.hh"
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "protected_engine.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace pfc {
+
+  // Print the header line for the output of compare_local_minimizer.
+  inline void
+  print_comparison_header(std::ostream& os)
+  {
+    os << "method\truns\tsuccesses\tsuccess_rate\tmedian_calls"
+          "\tmedian_wall\tmedian_best\n";
+  }
+
+  // Run 'runs' independent global minimizations of 'f', using the local
+  // minimization policy 'local_minimizer', and print one line of
+  // tab-separated values to 'os'. A run is successful if it finds a value
+  // less than 'tolerance' within 'max_attempts' local minimizations. For the
+  // successful runs, we report the median number of calls to 'f' made
+  // (by all threads) before the first success, and the median wall-clock
+  // time to the first success, in milliseconds. These are NA if no run
+  // succeeded. We also report the median over all runs of the best value
+  // found.
+  template <typename FUNC, typename LOCAL>
+  void
+  compare_local_minimizer(std::string const& name,
+                          FUNC const& f,
+                          region<column_vector> const& starting_point_volume,
+                          int num_starting_points,
+                          double tolerance,
+                          long max_attempts,
+                          int runs,
+                          LOCAL local_minimizer,
+                          std::ostream& os)
+  {
+    std::vector<double> calls_to_success;
+    std::vector<double> wall_to_success;
+    std::vector<double> best_values;
+    for (int run = 0; run != runs; ++run) {
+      std::atomic<long> ncalls = 0;
+      auto counted = [&f, &ncalls](column_vector const& x) {
+        ncalls.fetch_add(1, std::memory_order_relaxed);
+        return f(x);
+      };
+      long calls_at_success = -1;
+      shared_result solutions(tolerance, num_starting_points);
+      solutions.on_improvement([&](solution const& s) {
+        if (s.value < tolerance && calls_at_success < 0)
+          calls_at_success = ncalls.load(std::memory_order_relaxed);
+      });
+      protected_engine<std::mt19937> engine(run);
+      double const start = now_in_milliseconds();
+      run_parallel_minimizers(counted,
+                              starting_point_volume,
+                              solutions,
+                              engine,
+                              num_starting_points,
+                              max_attempts,
+                              local_minimizer);
+      if (!solutions.empty())
+        best_values.push_back(solutions.best().value);
+      if (calls_at_success >= 0) {
+        calls_to_success.push_back(calls_at_success);
+        wall_to_success.push_back(solutions.first_success_time() - start);
+      }
+    }
+
+    auto median_or_na = [&os](std::vector<double> const& v) {
+      if (v.empty())
+        os << "NA";
+      else
+        os << median(v);
+    };
+    os << name << '\t' << runs << '\t' << calls_to_success.size() << '\t'
+       << static_cast<double>(calls_to_success.size()) / runs << '\t';
+    median_or_na(calls_to_success);
+    os << '\t';
+    median_or_na(wall_to_success);
+    os << '\t';
+    median_or_na(best_values);
+    os << '\n';
+  }
+}
+
+#endif
@@ -0,0 +1,393 @@
+#include "metrics.hh"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+  std::atomic<std::uint64_t> next_instance_id = 1;
+
+  // Format a value as Prometheus expects; in particular, infinities are
+  // written as +Inf and -Inf.
+  std::string
+  prometheus_value(double x)
+  {
+    if (std::isnan(x))
+      return "NaN";
+    if (std::isinf(x))
+      return (x > 0) ? "+Inf" : "-Inf";
+    return fmt::format("{}", x);
+  }
+
+  void
+  append_metric(std::string& out,
+                char const* name,
+                char const* type,
+                char const* help,
+                std::string const& value)
+  {
+    out += fmt::format(
+      "# HELP {0} {1}\n# TYPE {0} {2}\n{0} {3}\n", name, help, type, value);
+  }
+
+  [[noreturn]] void
+  throw_socket_error(std::string const& what)
+  {
+    throw std::runtime_error(what + ": " + std::strerror(errno));
+  }
+
+  int
+  make_unix_listener(std::string const& path)
+  {
+    sockaddr_un address{};
+    if (path.size() >= sizeof(address.sun_path))
+      throw std::runtime_error("Unix socket path too long: " + path);
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    int const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+      throw_socket_error("Unable to create Unix socket");
+    ::unlink(path.c_str());
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+          0 ||
+        ::listen(fd, 16) != 0) {
+      ::close(fd);
+      throw_socket_error("Unable to listen on Unix socket " + path);
+    }
+    return fd;
+  }
+
+  // Listen on 'port' of the loopback interface; set 'port' to the port
+  // actually used.
+  int
+  make_tcp_listener(int& port)
+  {
+    int const fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+      throw_socket_error("Unable to create TCP socket");
+    int const yes = 1;
+    ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    socklen_t length = sizeof(address);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), length) != 0 ||
+        ::listen(fd, 16) != 0 ||
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length) !=
+          0) {
+      ::close(fd);
+      throw_socket_error("Unable to listen on TCP port " +
+                         std::to_string(port));
+    }
+    port = ntohs(address.sin_port);
+    return fd;
+  }
+
+  // Read what the client sends, up to the end of an HTTP request header,
+  // waiting at most 'timeout_ms' for each part of it. Clients that send
+  // nothing (e.g. nc) get the response after the timeout.
+  void
+  read_request(int fd, int timeout_ms)
+  {
+    std::string request;
+    char buffer[1024];
+    pollfd p{fd, POLLIN, 0};
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < 65536 && ::poll(&p, 1, timeout_ms) > 0) {
+      ssize_t const n = ::recv(fd, buffer, sizeof(buffer), 0);
+      if (n <= 0)
+        return;
+      request.append(buffer, n);
+    }
+  }
+
+  void
+  send_all(int fd, std::string const& data)
+  {
+    std::size_t sent = 0;
+    while (sent < data.size()) {
+      ssize_t const n =
+        ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0)
+        return;
+      sent += n;
+    }
+  }
+}
+
+namespace pfc {
+
+  search_metrics::search_metrics(std::size_t max_threads)
+    : slots_(new slot[max_threads + 1])
+    , num_slots_(max_threads + 1)
+    , start_ns_(now_ns())
+    , id_(next_instance_id.fetch_add(1))
+  {
+    // The last slot is shared by any threads beyond max_threads.
+    slots_[num_slots_ - 1].start_ns = start_ns_;
+  }
+
+  search_metrics::~search_metrics() = default;
+
+  void
+  search_metrics::watch(shared_result const& solutions)
+  {
+    solutions_ = &solutions;
+  }
+
+  std::int64_t
+  search_metrics::now_ns()
+  {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  search_metrics::meter
+  search_metrics::claim_meter()
+  {
+    meter result;
+    result.best_ = &best_;
+    result.slot_ = &slots_[num_slots_ - 1];
+    result.exclusive_ = false;
+    auto const me = std::this_thread::get_id();
+    for (std::size_t i = 0; i != num_slots_ - 1; ++i) {
+      slot& s = slots_[i];
+      std::thread::id owner = s.owner.load(std::memory_order_acquire);
+      if (owner == std::thread::id{} &&
+          s.owner.compare_exchange_strong(owner, me)) {
+        s.start_ns.store(now_ns(), std::memory_order_release);
+        owner = me;
+      }
+      if (owner == me) {
+        result.slot_ = &s;
+        result.exclusive_ = true;
+        break;
+      }
+    }
+    detail::meter_cache.instance = id_;
+    detail::meter_cache.meter = result;
+    return result;
+  }
+
+  search_metrics::sample
+  search_metrics::take_sample() const
+  {
+    sample result;
+    std::int64_t const now = now_ns();
+    result.elapsed_seconds = (now - start_ns_) * 1.0e-9;
+    for (std::size_t i = 0; i != num_slots_; ++i) {
+      slot const& s = slots_[i];
+      // A slot is in use once its start time has been set.
+      std::int64_t const start = s.start_ns.load(std::memory_order_acquire);
+      if (start == 0)
+        continue;
+      thread_sample t;
+      t.thread = i;
+      t.attempts = s.attempts.load(std::memory_order_relaxed);
+      t.calls = s.calls.load(std::memory_order_relaxed);
+      if (i == num_slots_ - 1 && t.attempts == 0 && t.calls == 0)
+        continue;
+      t.busy_seconds = s.busy_ns.load(std::memory_order_relaxed) * 1.0e-9;
+      t.idle_seconds =
+        std::max(0.0, (now - start) * 1.0e-9 - t.busy_seconds);
+      result.attempts += t.attempts;
+      result.calls += t.calls;
+      result.threads.push_back(t);
+    }
+    result.best_value = best_.load(std::memory_order_relaxed);
+    if (solutions_)
+      result.distinct_minima = solutions_->num_minima_found();
+    return result;
+  }
+
+  std::string
+  format_prometheus(search_metrics::sample const& sample,
+                    double attempts_per_second)
+  {
+    std::string out;
+    append_metric(out,
+                  "pfc_elapsed_seconds",
+                  "gauge",
+                  "Time since the metrics were created.",
+                  prometheus_value(sample.elapsed_seconds));
+    append_metric(out,
+                  "pfc_attempts_total",
+                  "counter",
+                  "Local minimizations completed.",
+                  std::to_string(sample.attempts));
+    append_metric(out,
+                  "pfc_attempts_per_second",
+                  "gauge",
+                  "Local minimizations completed per second, since the "
+                  "previous sample.",
+                  prometheus_value(attempts_per_second));
+    append_metric(out,
+                  "pfc_objective_calls_total",
+                  "counter",
+                  "Calls of the objective function.",
+                  std::to_string(sample.calls));
+    append_metric(out,
+                  "pfc_best_value",
+                  "gauge",
+                  "Best value of the objective function found.",
+                  prometheus_value(sample.best_value));
+    append_metric(out,
+                  "pfc_distinct_minima",
+                  "gauge",
+                  "Distinct minima found by the minima catalog.",
+                  std::to_string(sample.distinct_minima));
+
+    out += "# HELP pfc_thread_busy_seconds_total Time each worker thread has "
+           "spent in local minimizations.\n"
+           "# TYPE pfc_thread_busy_seconds_total counter\n";
+    for (auto const& t : sample.threads)
+      out += fmt::format("pfc_thread_busy_seconds_total{{thread=\"{}\"}} {}\n",
+                         t.thread,
+                         prometheus_value(t.busy_seconds));
+    out += "# HELP pfc_thread_idle_seconds_total Time each worker thread has "
+           "spent outside local minimizations, since its first.\n"
+           "# TYPE pfc_thread_idle_seconds_total counter\n";
+    for (auto const& t : sample.threads)
+      out += fmt::format("pfc_thread_idle_seconds_total{{thread=\"{}\"}} {}\n",
+                         t.thread,
+                         prometheus_value(t.idle_seconds));
+    return out;
+  }
+
+  metrics_publisher::metrics_publisher(search_metrics const& metrics,
+                                       metrics_publisher_config config)
+    : metrics_(metrics), config_(std::move(config))
+  {
+    try {
+      if (::pipe(wake_) != 0)
+        throw_socket_error("Unable to create pipe");
+      if (!config_.unix_socket.empty())
+        unix_listener_ = make_unix_listener(config_.unix_socket);
+      if (config_.tcp_port >= 0) {
+        tcp_port_ = config_.tcp_port;
+        tcp_listener_ = make_tcp_listener(tcp_port_);
+      }
+    }
+    catch (...) {
+      for (int fd : {wake_[0], wake_[1], unix_listener_, tcp_listener_})
+        if (fd >= 0)
+          ::close(fd);
+      throw;
+    }
+    publish();
+    thread_ = std::thread(&metrics_publisher::run, this);
+  }
+
+  metrics_publisher::~metrics_publisher()
+  {
+    char const stop = 's';
+    [[maybe_unused]] auto n = ::write(wake_[1], &stop, 1);
+    thread_.join();
+    publish();
+    for (int fd : {wake_[0], wake_[1], unix_listener_, tcp_listener_})
+      if (fd >= 0)
+        ::close(fd);
+    if (unix_listener_ >= 0)
+      ::unlink(config_.unix_socket.c_str());
+  }
+
+  int
+  metrics_publisher::tcp_port() const
+  {
+    return tcp_port_;
+  }
+
+  std::string
+  metrics_publisher::text() const
+  {
+    std::scoped_lock<std::mutex> lock(guard_text_);
+    return text_;
+  }
+
+  void
+  metrics_publisher::run()
+  {
+    using clock = std::chrono::steady_clock;
+    auto next = clock::now() + config_.period;
+    pollfd fds[3] = {{wake_[0], POLLIN, 0},
+                     {unix_listener_, POLLIN, 0},
+                     {tcp_listener_, POLLIN, 0}};
+    while (true) {
+      auto const wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        next - clock::now());
+      int const timeout = static_cast<int>(std::max<long>(0, wait.count()));
+      // poll ignores the entries with negative descriptors.
+      if (::poll(fds, 3, timeout) > 0) {
+        if (fds[0].revents != 0)
+          return;
+        for (int i : {1, 2})
+          if (fds[i].revents & POLLIN)
+            serve(fds[i].fd);
+      }
+      if (clock::now() >= next) {
+        publish();
+        next = std::max(next + config_.period, clock::now());
+      }
+    }
+  }
+
+  void
+  metrics_publisher::publish()
+  {
+    auto const sample = metrics_.take_sample();
+    double const dt = sample.elapsed_seconds - previous_seconds_;
+    double const rate =
+      (dt > 0.0) ? (sample.attempts - previous_attempts_) / dt : 0.0;
+    previous_attempts_ = sample.attempts;
+    previous_seconds_ = sample.elapsed_seconds;
+    std::string text = format_prometheus(sample, rate);
+
+    if (!config_.file.empty()) {
+      // Failures are ignored; the next sample will try again.
+      std::string const temporary = config_.file + ".tmp";
+      std::ofstream out(temporary);
+      out << text;
+      out.close();
+      std::error_code ec;
+      if (out)
+        std::filesystem::rename(temporary, config_.file, ec);
+    }
+
+    std::scoped_lock<std::mutex> lock(guard_text_);
+    text_ = std::move(text);
+  }
+
+  void
+  metrics_publisher::serve(int listener) const
+  {
+    int const fd = ::accept(listener, nullptr, nullptr);
+    if (fd < 0)
+      return;
+    read_request(fd, 100);
+    std::string const body = text();
+    send_all(fd,
+             fmt::format("HTTP/1.0 200 OK\r\n"
+                         "Content-Type: text/plain; version=0.0.4\r\n"
+                         "Content-Length: {}\r\n"
+                         "\r\n",
+                         body.size()) +
+               body);
+    ::close(fd);
+  }
+}
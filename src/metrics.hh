@@ -0,0 +1,278 @@
+#ifndef PROFILED_FC_CPU_METRICS_HH
+#define PROFILED_FC_CPU_METRICS_HH
+
+#include "minimizers.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pfc {
+
+  // search_metrics holds counters describing a running search, written by
+  // the worker threads and read by a sampler (e.g. metrics_publisher) at any
+  // time, without locking.
+  //
+  // Each worker thread claims a slot of its own, on its own cache line, the
+  // first time it records anything; after that it only ever writes to its
+  // own slot, with plain (uncontended) atomic stores. The only shared
+  // counter is the best value, which is written only when it improves.
+  // Sampling reads the slots with relaxed loads; it never touches the lock
+  // of the shared_result.
+  //
+  // Workers record through metered_minimizer, below.
+  class search_metrics {
+    struct slot;
+
+  public:
+    // The counters of one worker thread.
+    struct thread_sample {
+      std::size_t thread = 0; // the slot number, stable for the search
+      long attempts = 0;
+      long calls = 0;
+      double busy_seconds = 0.0; // time spent in local minimizations
+      double idle_seconds = 0.0; // the rest of the time since it started
+    };
+
+    struct sample {
+      double elapsed_seconds = 0.0;
+      long attempts = 0;
+      long calls = 0;
+      double best_value = std::numeric_limits<double>::infinity();
+      long distinct_minima = 0;
+      std::vector<thread_sample> threads;
+    };
+
+    // meter is the handle a worker thread uses to record into its slot. It
+    // is cheap to copy, and must be used only by the thread that obtained
+    // it.
+    class meter {
+    public:
+      // Count 'n' calls of the objective function.
+      void count_calls(long n) const;
+
+      // Count one local minimization, which took 'busy_ns' nanoseconds and
+      // reached 'value'.
+      void record_attempt(double value, std::int64_t busy_ns) const;
+
+    private:
+      friend class search_metrics;
+      slot* slot_ = nullptr;
+      std::atomic<double>* best_ = nullptr;
+      bool exclusive_ = true;
+    };
+
+    // Create metrics with room for 'max_threads' worker threads; threads
+    // beyond that share one slot, which they update with atomic
+    // read-modify-write operations.
+    explicit search_metrics(std::size_t max_threads = 256);
+    ~search_metrics();
+
+    search_metrics(search_metrics const&) = delete;
+    search_metrics& operator=(search_metrics const&) = delete;
+
+    // Report the number of distinct minima found by the catalog of
+    // 'solutions' in each sample. The shared_result must outlive *this.
+    void watch(shared_result const& solutions);
+
+    // Return the meter of the calling thread, claiming a slot if it has
+    // none. This is lock-free. After the first call on a thread it is an
+    // inline check of a thread-local cache, cheap enough to be made for
+    // each function call.
+    meter local_meter();
+
+    // Read all the counters, without locking.
+    sample take_sample() const;
+
+    // Return the steady clock, in nanoseconds.
+    static std::int64_t now_ns();
+
+  private:
+    // The slow path of local_meter: find or claim the slot of the calling
+    // thread, and cache its meter.
+    meter claim_meter();
+
+    std::unique_ptr<slot[]> slots_;
+    std::size_t num_slots_;
+    std::atomic<double> best_ = std::numeric_limits<double>::infinity();
+    shared_result const* solutions_ = nullptr;
+    std::int64_t const start_ns_;
+    std::uint64_t const id_; // distinguishes instances in the thread cache
+  };
+
+  // metered_minimizer is a local minimization policy that wraps another,
+  // LOCAL, recording each local minimization, its duration and the calls of
+  // the function it makes in 'metrics'. Pass it as the local minimizer of
+  // any of the searches, e.g.
+  //
+  //   pfc::search_metrics metrics;
+  //   pfc::find_global_minimum(func, volume, tolerance, config,
+  //                            pfc::metered_minimizer{&metrics});
+  //
+  // It costs two reads of the steady clock per local minimization, and for
+  // each function call a check of a thread-local cache and an increment of
+  // the counter of the calling thread, which no other thread writes. LOCAL
+  // may call the function from several threads, as nelder_mead_minimizer
+  // does; each call is counted by the thread that makes it.
+  template <typename LOCAL = bfgs_minimizer>
+  struct metered_minimizer {
+    search_metrics* metrics;
+    LOCAL local = LOCAL();
+
+    template <typename FUNC, typename VEC>
+    solution
+    operator()(FUNC const& f,
+               VEC const& starting_point,
+               shared_result const& solutions) const
+    {
+      search_metrics::meter const m = metrics->local_meter();
+      auto counted = [&f, metrics = metrics](auto const& x) {
+        metrics->local_meter().count_calls(1);
+        return f(x);
+      };
+      std::int64_t const start = search_metrics::now_ns();
+      solution result = local(counted, starting_point, solutions);
+      m.record_attempt(result.value, search_metrics::now_ns() - start);
+      return result;
+    }
+  };
+
+  // Format 'sample' in the Prometheus text exposition format (version
+  // 0.0.4). 'attempts_per_second' is reported as a gauge, since a sampler
+  // that publishes to a file cannot leave the rate to the scraper.
+  std::string format_prometheus(search_metrics::sample const& sample,
+                                double attempts_per_second);
+
+  // metrics_publisher_config says where a metrics_publisher publishes.
+  // Any combination of the outputs can be used.
+  struct metrics_publisher_config {
+    // The interval between samples.
+    std::chrono::milliseconds period{1000};
+    // If not empty, write each sample to this file. The file is replaced
+    // atomically (written beside it, then renamed), so a reader never sees
+    // a partial sample.
+    std::string file;
+    // If not empty, serve the latest sample on a Unix-domain socket at this
+    // path. Any existing file at the path is removed.
+    std::string unix_socket;
+    // If not negative, serve the latest sample on this TCP port of the
+    // loopback interface only; 0 chooses a free port (see
+    // metrics_publisher::tcp_port).
+    int tcp_port = -1;
+  };
+
+  // metrics_publisher samples a search_metrics periodically on a thread of
+  // its own (not a TBB worker), and publishes the samples as configured.
+  // The sockets answer every connection with an HTTP/1.0 response holding
+  // the latest sample, so a Prometheus server, or curl, can scrape them
+  // directly. The publisher stops, after publishing a final sample, when it
+  // is destroyed.
+  //
+  // The constructor throws std::runtime_error if a socket cannot be set up.
+  class metrics_publisher {
+  public:
+    metrics_publisher(search_metrics const& metrics,
+                      metrics_publisher_config config);
+    ~metrics_publisher();
+
+    metrics_publisher(metrics_publisher const&) = delete;
+    metrics_publisher& operator=(metrics_publisher const&) = delete;
+
+    // Report the TCP port being served; -1 if none.
+    int tcp_port() const;
+
+    // Return the text of the latest sample.
+    std::string text() const;
+
+  private:
+    void run();
+    void publish();
+    void serve(int listener) const;
+
+    search_metrics const& metrics_;
+    metrics_publisher_config const config_;
+    int unix_listener_ = -1;
+    int tcp_listener_ = -1;
+    int tcp_port_ = -1;
+    int wake_[2] = {-1, -1}; // a pipe, written to stop the thread
+    std::mutex mutable guard_text_;
+    std::string text_;
+    long previous_attempts_ = 0;
+    double previous_seconds_ = 0.0;
+    std::thread thread_;
+  };
+
+  // Implementation details below.
+
+  // The counters of one thread. The owner is the only writer, unless the
+  // slot is the shared overflow slot.
+  struct alignas(64) search_metrics::slot {
+    std::atomic<std::thread::id> owner{};
+    std::atomic<std::int64_t> start_ns = 0;
+    std::atomic<long> attempts = 0;
+    std::atomic<long> calls = 0;
+    std::atomic<std::int64_t> busy_ns = 0;
+  };
+
+  namespace detail {
+    // The meter the calling thread last obtained, and the id of the
+    // search_metrics it belongs to.
+    struct cached_meter {
+      std::uint64_t instance = 0;
+      search_metrics::meter meter;
+    };
+
+    inline thread_local cached_meter meter_cache;
+
+    // Add 'n' to a counter. A counter with a single writer needs no
+    // read-modify-write instruction.
+    template <typename T>
+    void
+    add_to_counter(std::atomic<T>& counter, T n, bool exclusive)
+    {
+      if (exclusive)
+        counter.store(counter.load(std::memory_order_relaxed) + n,
+                      std::memory_order_relaxed);
+      else
+        counter.fetch_add(n, std::memory_order_relaxed);
+    }
+  }
+
+  inline search_metrics::meter
+  search_metrics::local_meter()
+  {
+    if (detail::meter_cache.instance == id_)
+      return detail::meter_cache.meter;
+    return claim_meter();
+  }
+
+  inline void
+  search_metrics::meter::count_calls(long n) const
+  {
+    detail::add_to_counter(slot_->calls, n, exclusive_);
+  }
+
+  inline void
+  search_metrics::meter::record_attempt(double value,
+                                        std::int64_t busy_ns) const
+  {
+    detail::add_to_counter(slot_->busy_ns, busy_ns, exclusive_);
+    detail::add_to_counter(slot_->attempts, 1L, exclusive_);
+    double best = best_->load(std::memory_order_relaxed);
+    while (value < best &&
+           !best_->compare_exchange_weak(
+             best, value, std::memory_order_relaxed)) {
+    }
+  }
+}
+
+#endif
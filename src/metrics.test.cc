@@ -0,0 +1,151 @@
+#include "metrics.hh"
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "nelder_mead.hh"
+#include "rastrigin.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include "tbb/global_control.h"
+#include "tbb/task_arena.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+  std::atomic<long> num_calls = 0;
+
+  double
+  counted_rastrigin(pfc::column_vector const& x)
+  {
+    num_calls.fetch_add(1);
+    return pfc::rastrigin_dlib(x);
+  }
+
+  // Fetch the metrics from a TCP port of the loopback interface, as a
+  // scraper would.
+  std::string
+  scrape(int port)
+  {
+    int const fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    std::string response;
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) ==
+        0) {
+      std::string const request = "GET /metrics HTTP/1.0\r\n\r\n";
+      ::send(fd, request.data(), request.size(), 0);
+      char buffer[4096];
+      ssize_t n = 0;
+      while ((n = ::recv(fd, buffer, sizeof(buffer), 0)) > 0)
+        response.append(buffer, n);
+    }
+    ::close(fd);
+    return response;
+  }
+}
+
+TEST_CASE("metered_minimizer counts attempts, calls and the best value")
+{
+  pfc::search_metrics metrics;
+  pfc::search_config config;
+  config.max_attempts = 50;
+  num_calls = 0;
+  auto [solutions, num_attempts] =
+    pfc::find_global_minimum(counted_rastrigin,
+                             pfc::make_box_in_n_dim(2, -5.0, 5.0),
+                             -std::numeric_limits<double>::infinity(),
+                             config,
+                             pfc::metered_minimizer{&metrics});
+  auto const sample = metrics.take_sample();
+  CHECK(sample.attempts == num_attempts);
+  CHECK(sample.calls == num_calls.load());
+  double best = std::numeric_limits<double>::infinity();
+  for (auto const& s : solutions)
+    best = std::min(best, s.value);
+  CHECK(sample.best_value == best);
+  REQUIRE(!sample.threads.empty());
+  long attempts = 0;
+  for (auto const& t : sample.threads) {
+    attempts += t.attempts;
+    CHECK(t.busy_seconds > 0.0);
+    CHECK(t.idle_seconds >= 0.0);
+  }
+  CHECK(attempts == sample.attempts);
+}
+
+TEST_CASE("metered_minimizer counts the parallel calls of nelder_mead")
+{
+  // nelder_mead_minimizer evaluates the vertices of its initial simplex in
+  // parallel, so the calls of one local minimization are made by several
+  // threads. Four threads are used even on a machine with fewer cores.
+  oneapi::tbb::global_control const parallelism(
+    oneapi::tbb::global_control::max_allowed_parallelism, 4);
+  oneapi::tbb::task_arena arena(4);
+  pfc::search_metrics metrics;
+  pfc::search_config config;
+  config.max_attempts = 50;
+  num_calls = 0;
+  pfc::minimization_results results;
+  arena.execute([&]() {
+    results = pfc::find_global_minimum(
+      counted_rastrigin,
+      pfc::make_box_in_n_dim(8, -5.0, 5.0),
+      -std::numeric_limits<double>::infinity(),
+      config,
+      pfc::metered_minimizer<pfc::nelder_mead_minimizer>{&metrics});
+  });
+  auto const num_attempts = results.num_attempts;
+  auto const sample = metrics.take_sample();
+  CHECK(sample.attempts == num_attempts);
+  CHECK(sample.calls == num_calls.load());
+  long calls = 0;
+  for (auto const& t : sample.threads)
+    calls += t.calls;
+  CHECK(calls == sample.calls);
+}
+
+TEST_CASE("metrics_publisher writes a file and serves TCP")
+{
+  auto const file =
+    std::filesystem::temp_directory_path() /
+    ("pfc_metrics_test_" + std::to_string(::getpid()) + ".prom");
+  pfc::search_metrics metrics;
+  auto m = metrics.local_meter();
+  m.count_calls(1);
+  m.record_attempt(1.5, 1000);
+
+  pfc::metrics_publisher_config config;
+  config.period = std::chrono::milliseconds(10);
+  config.file = file.string();
+  config.tcp_port = 0;
+  {
+    pfc::metrics_publisher publisher(metrics, config);
+    REQUIRE(publisher.tcp_port() > 0);
+    std::string const response = scrape(publisher.tcp_port());
+    CHECK(response.starts_with("HTTP/1.0 200 OK\r\n"));
+    CHECK(response.find("\npfc_attempts_total 1\n") != std::string::npos);
+    CHECK(response.find("\npfc_best_value 1.5\n") != std::string::npos);
+    CHECK(response.find("pfc_thread_busy_seconds_total{thread=\"0\"}") !=
+          std::string::npos);
+  }
+
+  // The final sample is written when the publisher is destroyed.
+  std::ifstream in(file);
+  std::string const text{std::istreambuf_iterator<char>(in), {}};
+  CHECK(text.find("# TYPE pfc_objective_calls_total counter\n"
+                  "pfc_objective_calls_total 1\n") != std::string::npos);
+  CHECK(text.find("\npfc_distinct_minima 0\n") != std::string::npos);
+  std::filesystem::remove(file);
+}
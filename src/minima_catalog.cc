@@ -0,0 +1,261 @@
+#include "minima_catalog.hh"
+
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <ostream>
+#include <vector>
+
+namespace pfc {
+
+  minima_catalog::minima_catalog(double distance, std::size_t max_minima)
+    : distance_(distance), max_minima_(max_minima)
+  {}
+
+  std::size_t
+  minima_catalog::cell_hash::operator()(cell const& c) const
+  {
+    // The combination step of boost::hash_combine.
+    std::size_t h = 0;
+    for (long i : c)
+      h ^= std::hash<long>{}(i) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h;
+  }
+
+  minima_catalog::cell
+  minima_catalog::cell_of(column_vector const& x) const
+  {
+    // The coordinates are clamped, so that huge ones do not overflow a long.
+    double const limit = 0x1p62;
+    cell c(x.size());
+    for (long i = 0; i != x.size(); ++i)
+      c[i] = static_cast<long>(
+        std::clamp(std::floor(x(i) / (2.0 * distance_)), -limit, limit));
+    return c;
+  }
+
+  minima_catalog::entry*
+  minima_catalog::find(column_vector const& location) const
+  {
+    entry* nearest = nullptr;
+    double nearest_distance = distance_;
+    auto consider = [&](entry* e) {
+      double const d = dlib::length(location - e->anchor);
+      if (d <= nearest_distance) {
+        nearest = e;
+        nearest_distance = d;
+      }
+    };
+
+    long const ndim = location.size();
+    if (!(distance_ > 0.0) || ndim >= 32 ||
+        (std::size_t{1} << ndim) > entries_.size()) {
+      for (auto const& e : entries_)
+        consider(e.get());
+      return nearest;
+    }
+
+    // Along axis i, the neighbouring cell to look in is the one on the side
+    // of the half of the cell that holds location(i).
+    cell const home = cell_of(location);
+    cell side(ndim);
+    for (long i = 0; i != ndim; ++i) {
+      double const t = location(i) / (2.0 * distance_);
+      side[i] = (t - std::floor(t) < 0.5) ? -1 : 1;
+    }
+    cell c(ndim);
+    for (unsigned long mask = 0; mask != (1UL << ndim); ++mask) {
+      for (long i = 0; i != ndim; ++i)
+        c[i] = home[i] + (((mask >> i) & 1) ? side[i] : 0);
+      auto const it = cells_.find(c);
+      if (it == cells_.end())
+        continue;
+      for (entry* e : it->second)
+        consider(e);
+    }
+    return nearest;
+  }
+
+  void
+  minima_catalog::erase(std::size_t pos)
+  {
+    entry* e = entries_[pos].get();
+    auto const it = cells_.find(e->home);
+    std::erase(it->second, e);
+    if (it->second.empty())
+      cells_.erase(it);
+    entries_[pos] = std::move(entries_.back());
+    entries_.pop_back();
+  }
+
+  void
+  minima_catalog::insert(column_vector const& location, double value)
+  {
+    if (!std::isfinite(value)) {
+      num_discarded_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    num_hits_.fetch_add(1, std::memory_order_relaxed);
+
+    // The common case: the location belongs to a known minimum.
+    {
+      std::shared_lock lock(guard_);
+      if (entry* e = find(location)) {
+        record_hit(*e);
+        std::scoped_lock entry_lock(e->guard);
+        if (value < e->value) {
+          e->value = value;
+          e->location = location;
+        }
+        return;
+      }
+    }
+
+    // Otherwise we need the exclusive lock. Another thread may have created
+    // the minimum since we looked, so we have to look again.
+    std::unique_lock lock(guard_);
+    if (entry* e = find(location)) {
+      record_hit(*e);
+      if (value < e->value) {
+        e->value = value;
+        e->location = location;
+      }
+      return;
+    }
+    if (entries_.size() == max_minima_) {
+      auto worst = std::max_element(
+        entries_.begin(), entries_.end(), [](auto const& a, auto const& b) {
+          return a->value < b->value;
+        });
+      if (worst == entries_.end() || !(value < (*worst)->value)) {
+        num_discarded_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      forget_counts(**worst);
+      erase(worst - entries_.begin());
+    }
+    num_found_.fetch_add(1, std::memory_order_relaxed);
+    num_singletons_.fetch_add(1, std::memory_order_relaxed);
+    auto e = std::make_unique<entry>();
+    e->anchor = location;
+    e->home = cell_of(location);
+    e->value = value;
+    e->location = location;
+    cells_[e->home].push_back(e.get());
+    entries_.push_back(std::move(e));
+  }
+
+  void
+  minima_catalog::record_hit(entry& e)
+  {
+    long const previous = e.hits.fetch_add(1, std::memory_order_relaxed);
+    if (previous == 1) {
+      num_singletons_.fetch_sub(1, std::memory_order_relaxed);
+      num_doubletons_.fetch_add(1, std::memory_order_relaxed);
+    } else if (previous == 2) {
+      num_doubletons_.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  void
+  minima_catalog::forget_counts(entry const& e)
+  {
+    long const hits = e.hits.load(std::memory_order_relaxed);
+    if (hits == 1)
+      num_singletons_.fetch_sub(1, std::memory_order_relaxed);
+    else if (hits == 2)
+      num_doubletons_.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  double
+  minima_catalog::expected_unseen(unseen_minima_estimator estimator) const
+  {
+    double const n = num_hits_.load(std::memory_order_relaxed);
+    double const w = num_found_.load(std::memory_order_relaxed);
+    switch (estimator) {
+      case unseen_minima_estimator::boender_rinnooy_kan:
+        if (n <= w + 2.0)
+          return std::numeric_limits<double>::infinity();
+        return w * (n - 1.0) / (n - w - 2.0) - w;
+      case unseen_minima_estimator::chao1: {
+        double const f1 = num_singletons_.load(std::memory_order_relaxed);
+        double const f2 = num_doubletons_.load(std::memory_order_relaxed);
+        return f1 * (f1 - 1.0) / (2.0 * (f2 + 1.0));
+      }
+    }
+    return std::numeric_limits<double>::infinity();
+  }
+
+  long
+  minima_catalog::num_hits() const
+  {
+    return num_hits_.load(std::memory_order_relaxed);
+  }
+
+  long
+  minima_catalog::num_found() const
+  {
+    return num_found_.load(std::memory_order_relaxed);
+  }
+
+  std::vector<minimum>
+  minima_catalog::minima() const
+  {
+    std::vector<minimum> result;
+    {
+      std::shared_lock lock(guard_);
+      result.reserve(entries_.size());
+      for (auto const& e : entries_) {
+        std::scoped_lock entry_lock(e->guard);
+        result.push_back(
+          {e->location, e->value, e->hits.load(std::memory_order_relaxed)});
+      }
+    }
+    std::sort(result.begin(), result.end(), [](auto const& a, auto const& b) {
+      return a.value < b.value;
+    });
+    return result;
+  }
+
+  std::size_t
+  minima_catalog::size() const
+  {
+    std::shared_lock lock(guard_);
+    return entries_.size();
+  }
+
+  long
+  minima_catalog::num_discarded() const
+  {
+    return num_discarded_.load(std::memory_order_relaxed);
+  }
+
+  double
+  minima_catalog::distance() const
+  {
+    return distance_;
+  }
+
+  void
+  print_minima(std::vector<minimum> const& minima, std::ostream& os)
+  {
+    if (minima.empty())
+      return;
+    auto const ndim = minima.front().location.size();
+    os << "idx\thits\tmin";
+    for (long i = 0; i != ndim; ++i)
+      os << "\tx" << i;
+    os << '\n';
+    long idx = 0;
+    for (auto const& m : minima) {
+      os << idx++ << '\t' << m.hits << '\t'
+         << fmt::format("{:.17e}", m.value);
+      for (long i = 0; i != ndim; ++i)
+        os << '\t' << fmt::format("{:.17e}", m.location(i));
+      os << '\n';
+    }
+  }
+}
@@ -0,0 +1,155 @@
+#ifndef PROFILED_FC_CPU_MINIMA_CATALOG_HH
+#define PROFILED_FC_CPU_MINIMA_CATALOG_HH
+
+#include "geometry.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace pfc {
+
+  // minimum describes one distinct minimum found by a search.
+  struct minimum {
+    column_vector location; // location of the best attempt that reached it
+    double value = 0.0;     // value at that location
+    long hits = 0;          // number of attempts that reached it
+  };
+
+  // Estimators of the number of minima not yet found, from the minima found
+  // so far and their hit counts:
+  //
+  //   boender_rinnooy_kan  the Bayesian estimate of Boender and Rinnooy Kan
+  //                        (1987), which, with N local minimizations having
+  //                        found W distinct minima, estimates the total
+  //                        number of minima as W (N - 1) / (N - W - 2).
+  //   chao1                the bias-corrected Chao1 estimate, based on the
+  //                        Good-Turing frequencies: with f1 minima hit
+  //                        exactly once and f2 hit exactly twice, the number
+  //                        not yet found is f1 (f1 - 1) / (2 (f2 + 1)).
+  //
+  // Both assume that each local minimization reaches a minimum with
+  // probability proportional to the size of its basin; both tend to zero as
+  // the search reaches every minimum repeatedly.
+  enum class unseen_minima_estimator { boender_rinnooy_kan, chao1 };
+
+  // minima_catalog clusters the locations reached by local minimizations into
+  // distinct minima. A location belongs to an existing minimum if it is
+  // within 'distance' (Euclidean) of the first location that was recorded for
+  // that minimum; otherwise it starts a new minimum. For each minimum the
+  // catalog keeps the number of hits, the best value and the location of
+  // that best value.
+  //
+  // At most 'max_minima' minima are kept. When the catalog is full, a new
+  // minimum replaces the kept minimum with the largest value, if the new one
+  // is better; otherwise it is discarded, and counted by num_discarded.
+  //
+  // The catalog is safe to use from multiple threads. Finding the minimum a
+  // location belongs to takes only a shared lock, and updating it locks only
+  // that minimum, so threads that find already-known minima (the common
+  // case, late in a search) do not serialize each other. Only the creation
+  // of a new minimum takes the exclusive lock.
+  //
+  // The minima are indexed by a hash of the cell of a grid, of spacing
+  // 2 * 'distance', that holds their first location. A location within
+  // 'distance' of that one is, along each axis, either in the same cell or
+  // in the neighbouring cell on the side of the half of the cell it is in,
+  // so only minima in those 2^n cells need to be compared. When there are
+  // fewer minima than that (or n is 32 or more), they are all compared
+  // instead.
+  class minima_catalog {
+  public:
+    minima_catalog(double distance, std::size_t max_minima);
+
+    minima_catalog(minima_catalog const&) = delete;
+    minima_catalog& operator=(minima_catalog const&) = delete;
+    minima_catalog(minima_catalog&&) = delete;
+    minima_catalog& operator=(minima_catalog&&) = delete;
+
+    // Record that a local minimization reached 'location', with the given
+    // value. Non-finite values are discarded.
+    void insert(column_vector const& location, double value);
+
+    // Return a copy of the minima, best value first.
+    std::vector<minimum> minima() const;
+
+    // Report the number of minima kept.
+    std::size_t size() const;
+
+    // Report the number of insertions that were discarded because the
+    // catalog was full or the value was not finite.
+    long num_discarded() const;
+
+    // Report the number of insertions with finite values, which is the
+    // number of local minimizations the catalog has seen.
+    long num_hits() const;
+
+    // Report the number of distinct minima found, including any that were
+    // later replaced because the catalog was full.
+    long num_found() const;
+
+    // Estimate the number of minima not yet found. This reads only atomic
+    // counters, without locking, so it is cheap enough to call after every
+    // local minimization. It is infinite (or large) until enough local
+    // minimizations have been done. The hit counts of minima replaced
+    // because the catalog was full are lost, so max_minima should be large
+    // enough to hold every minimum when this is used.
+    double expected_unseen(unseen_minima_estimator estimator) const;
+
+    double distance() const;
+
+  private:
+    // The coordinates of a cell of the grid.
+    using cell = std::vector<long>;
+
+    struct entry {
+      column_vector anchor; // first location; never modified
+      cell home;            // the cell of anchor
+      std::atomic<long> hits = 1;
+      std::mutex guard;     // protects value and location
+      double value;
+      column_vector location;
+    };
+
+    struct cell_hash {
+      std::size_t operator()(cell const& c) const;
+    };
+
+    // Return the cell that holds 'x'.
+    cell cell_of(column_vector const& x) const;
+
+    // Count a hit of 'e', keeping the counts of minima hit once and twice.
+    void record_hit(entry& e);
+
+    // Remove the contribution of 'e' to those counts, when it is replaced.
+    void forget_counts(entry const& e);
+
+    // Return the entry to which 'location' belongs, or nullptr if there is
+    // none. The caller must hold guard_, in either mode.
+    entry* find(column_vector const& location) const;
+
+    // Remove the entry at 'pos' in entries_, and from its cell.
+    void erase(std::size_t pos);
+
+    std::shared_mutex mutable guard_;
+    std::vector<std::unique_ptr<entry>> entries_;
+    std::unordered_map<cell, std::vector<entry*>, cell_hash> cells_;
+    double const distance_;
+    std::size_t const max_minima_;
+    std::atomic<long> num_discarded_ = 0;
+    std::atomic<long> num_hits_ = 0;
+    std::atomic<long> num_found_ = 0;
+    std::atomic<long> num_singletons_ = 0;
+    std::atomic<long> num_doubletons_ = 0;
+  };
+
+  // Print the minima as tab-separated values, with a header line.
+  void print_minima(std::vector<minimum> const& minima, std::ostream& os);
+}
+
+#endif
@@ -0,0 +1,115 @@
+#include "minima_catalog.hh"
+#include "geometry.hh"
+
+#include "catch2/catch_test_macros.hpp"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
+#include <cmath>
+
+using pfc::column_vector;
+using pfc::minima_catalog;
+
+TEST_CASE("nearby locations are the same minimum")
+{
+  minima_catalog catalog(0.1, 10);
+  catalog.insert(column_vector({1.0, 1.0}), 3.0);
+  catalog.insert(column_vector({1.05, 1.0}), 2.0);
+  catalog.insert(column_vector({0.98, 1.02}), 2.5);
+  catalog.insert(column_vector({-1.0, 1.0}), 1.0);
+  REQUIRE(catalog.size() == 2);
+
+  auto const minima = catalog.minima();
+  CHECK(minima[0].value == 1.0);
+  CHECK(minima[0].hits == 1);
+  CHECK(minima[1].value == 2.0);
+  CHECK(minima[1].hits == 3);
+  CHECK(minima[1].location(0) == 1.05);
+}
+
+TEST_CASE("a full catalog keeps the best minima")
+{
+  minima_catalog catalog(0.1, 2);
+  catalog.insert(column_vector({0.0}), 5.0);
+  catalog.insert(column_vector({1.0}), 4.0);
+  catalog.insert(column_vector({2.0}), 6.0);
+  catalog.insert(column_vector({3.0}), 1.0);
+  catalog.insert(column_vector({4.0}), std::nan(""));
+  CHECK(catalog.num_discarded() == 2);
+
+  auto const minima = catalog.minima();
+  REQUIRE(minima.size() == 2);
+  CHECK(minima[0].value == 1.0);
+  CHECK(minima[1].value == 4.0);
+}
+
+TEST_CASE("concurrent inserts count every hit")
+{
+  minima_catalog catalog(0.5, 100);
+  long const n = 10000;
+  oneapi::tbb::parallel_for(
+    oneapi::tbb::blocked_range<long>(0, n),
+    [&](oneapi::tbb::blocked_range<long> const& r) {
+      for (long i = r.begin(); i != r.end(); ++i) {
+        // Ten minima, at integer points, each reached with small offsets.
+        double const x = static_cast<double>(i % 10) + 1.0e-3 * (i % 7);
+        catalog.insert(column_vector({x, -x}), static_cast<double>(i % 10));
+      }
+    });
+  auto const minima = catalog.minima();
+  REQUIRE(minima.size() == 10);
+  long total = 0;
+  for (auto const& m : minima)
+    total += m.hits;
+  CHECK(total == n);
+}
+
+TEST_CASE("unseen minima estimates")
+{
+  using pfc::unseen_minima_estimator;
+  minima_catalog catalog(0.1, 100);
+  // Three minima, hit 1, 2 and 5 times: N = 8, W = 3, f1 = 1, f2 = 1.
+  catalog.insert(column_vector({0.0}), 0.0);
+  for (int i = 0; i != 2; ++i)
+    catalog.insert(column_vector({1.0}), 1.0);
+  for (int i = 0; i != 5; ++i)
+    catalog.insert(column_vector({2.0}), 2.0);
+  REQUIRE(catalog.num_hits() == 8);
+  REQUIRE(catalog.num_found() == 3);
+
+  CHECK(catalog.expected_unseen(unseen_minima_estimator::boender_rinnooy_kan) ==
+        3.0 * 7.0 / 3.0 - 3.0);
+  CHECK(catalog.expected_unseen(unseen_minima_estimator::chao1) == 0.0);
+
+  // With too few hits, Boender-Rinnooy Kan has no estimate.
+  minima_catalog sparse(0.1, 100);
+  sparse.insert(column_vector({0.0}), 0.0);
+  sparse.insert(column_vector({1.0}), 0.0);
+  CHECK(std::isinf(
+    sparse.expected_unseen(unseen_minima_estimator::boender_rinnooy_kan)));
+  CHECK(sparse.expected_unseen(unseen_minima_estimator::chao1) == 1.0);
+}
+
+TEST_CASE("lattice minima are told apart")
+{
+  // The minima of the Rastrigin function lie on the integer lattice; many
+  // of them have the same sum of coordinates.
+  minima_catalog catalog(0.25, 10000);
+  long num_points = 0;
+  for (int repeat = 0; repeat != 2; ++repeat) {
+    double const jitter = 0.1 * repeat;
+    for (int i = -3; i <= 3; ++i) {
+      for (int j = -3; j <= 3; ++j) {
+        for (int k = -3; k <= 3; ++k) {
+          catalog.insert(column_vector({i + jitter, j - jitter, k + jitter}),
+                         i * i + j * j + k * k);
+          ++num_points;
+        }
+      }
+    }
+  }
+  REQUIRE(catalog.size() == 343);
+  CHECK(catalog.num_hits() == num_points);
+  for (auto const& m : catalog.minima())
+    CHECK(m.hits == 2);
+}
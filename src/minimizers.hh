@@ -3,14 +3,23 @@
 
 #include "callable_traits.hh"
 #include "geometry.hh"
+#include "ndim_dispatch.hh"
 #include "protected_engine.hh"
 #include "shared_result.hh"
 #include "solution.hh"
+#include "time_budget.hh"
 
 #include "dlib/optimization.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
 #include "tbb/task_group.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <limits>
 
 namespace pfc {
 
@@ -18,24 +27,70 @@ namespace pfc {
   double now_in_milliseconds();
 
   struct minimization_results;
+  struct budgeted_minimization_results;
+  struct search_config;
 
-  template <typename FUNC>
+  class budget_stop_strategy;
+
+  template <typename FUNC, typename VEC>
+  solution do_one_minimization(FUNC const& f, VEC const& starting_point);
+
+  template <typename FUNC, typename VEC, typename STOP>
   solution do_one_minimization(FUNC const& f,
-                               column_vector const& starting_point);
+                               VEC const& starting_point,
+                               STOP stop_strategy);
+
+  struct bfgs_minimizer;
 
   template <std::uniform_random_bit_generator URBG,
             typename FUNC,
-            typename REGION>
+            typename REGION,
+            typename LOCAL = bfgs_minimizer>
   struct ParallelMinimizer;
 
-  template <typename FUNC>
+  template <typename FUNC,
+            typename REGION,
+            typename URBG,
+            typename LOCAL = bfgs_minimizer>
+  void run_parallel_attempts(FUNC& func,
+                             REGION const& starting_point_volume,
+                             shared_result& solutions,
+                             protected_engine<URBG>& engine,
+                             long max_attempts,
+                             long grain_size = 1,
+                             LOCAL local_minimizer = LOCAL());
+
+  template <typename FUNC,
+            typename REGION,
+            typename URBG,
+            typename LOCAL = bfgs_minimizer>
+  void run_parallel_minimizers(FUNC&& func,
+                               REGION const& starting_point_volume,
+                               shared_result& solutions,
+                               protected_engine<URBG>& engine,
+                               int num_tasks,
+                               long max_attempts,
+                               LOCAL local_minimizer = LOCAL());
+
+  template <typename FUNC, typename LOCAL = bfgs_minimizer>
   minimization_results find_global_minimum(
     FUNC&& func,
     long ndim,
     region<column_vector> const& starting_point_volume,
     int num_starting_points,
     double tolerance,
-    long max_attempts = 1000000);
+    long max_attempts = 1000000,
+    LOCAL local_minimizer = LOCAL());
+
+  // Search with the concurrency, the number of solutions kept and the number
+  // of attempts each set independently by 'config'; see search_config.
+  template <typename FUNC, typename LOCAL = bfgs_minimizer>
+  minimization_results find_global_minimum(
+    FUNC&& func,
+    region<column_vector> const& starting_point_volume,
+    double tolerance,
+    search_config const& config,
+    LOCAL local_minimizer = LOCAL());
 
   template <typename FUNC, typename REGION>
   minimization_results find_global_minimum_fixed(
@@ -45,6 +100,19 @@ namespace pfc {
     double tolerance,
     long max_attempts = 1000000);
 
+  // Search until 'budget' is used up (or 'max_attempts' local minimizations
+  // have been done), keeping the best 'num_starting_points' solutions. This
+  // is for functions whose minimum value is not known in advance. Local
+  // minimizations in progress when the budget runs out are stopped where
+  // they are, and their results are kept.
+  template <typename FUNC>
+  budgeted_minimization_results find_global_minimum_within(
+    FUNC&& func,
+    region<column_vector> const& starting_point_volume,
+    int num_starting_points,
+    time_budget const& budget,
+    long max_attempts = std::numeric_limits<long>::max());
+
   // Implementations below...
 
   // Return number of milliseconds since the epoch.
@@ -63,75 +131,271 @@ namespace pfc {
     long num_attempts; // The total number of local minimizations done
   };
 
-  template <typename FUNC>
+  // Struct representing the set of solutions from a search limited by a time
+  // budget.
+  struct budgeted_minimization_results {
+    std::vector<solution> best_solutions; // The best solutions found
+    long num_attempts; // The total number of local minimizations done
+    double percent_budget_used; // May be a little over 100
+  };
+
+  // search_config holds the independent settings of a multistart search.
+  struct search_config {
+    // The maximum number of threads to use; 0 means as many as TBB allows.
+    int concurrency = 0;
+    // The number of best solutions to keep.
+    std::size_t num_retained = 16;
+    // The maximum number of local minimizations to do.
+    long max_attempts = 1000000;
+    // The smallest number of attempts handed to a thread at once. TBB hands
+    // out larger chunks while the threads are balanced, and splits them when
+    // they are not, so 1 is a good choice unless the attempts are so cheap
+    // that the scheduling overhead matters.
+    long grain_size = 1;
+  };
+
+  // budget_stop_strategy is a dlib stop strategy that behaves like
+  // dlib::objective_delta_stop_strategy, except that it also stops the
+  // search when the time budget of a shared_result has been used up.
+  class budget_stop_strategy {
+  public:
+    budget_stop_strategy(double min_delta, shared_result const& solutions)
+      : delta_(min_delta), solutions_(solutions)
+    {}
+
+    template <typename T>
+    bool
+    should_continue_search(T const& x, double funct_value, T const& deriv)
+    {
+      if (solutions_.budget_expired())
+        return false;
+      return delta_.should_continue_search(x, funct_value, deriv);
+    }
+
+  private:
+    dlib::objective_delta_stop_strategy delta_;
+    shared_result const& solutions_;
+  };
+
+  template <typename FUNC, typename VEC>
   solution
-  do_one_minimization(FUNC const& f, column_vector const& starting_point)
+  do_one_minimization(FUNC const& f, VEC const& starting_point)
+  {
+    return do_one_minimization(
+      f, starting_point, dlib::objective_delta_stop_strategy(1.0e-6));
+  }
+
+  // VEC may be column_vector, or fixed_vector<N>; in the latter case, all the
+  // work of the minimization is done with fixed-size vectors and matrices,
+  // which need no heap allocation. The result is always stored as a
+  // column_vector.
+  template <typename FUNC, typename VEC, typename STOP>
+  solution
+  do_one_minimization(FUNC const& f,
+                      VEC const& starting_point,
+                      STOP stop_strategy)
   {
     solution result;
     result.start = starting_point;
     result.start_value = f(starting_point);
     result.tstart = now_in_milliseconds();
 
-    // the minimization routine will write the answer directly into
-    // result.location so no extra copying is needed.
-    result.location = starting_point;
+    VEC location = starting_point;
     auto [f_value, nsteps, steps] =
       dlib::find_min_using_approximate_derivatives(
         dlib::bfgs_search_strategy(),
-        dlib::objective_delta_stop_strategy(1.0e-6),
+        stop_strategy,
         f,
-        result.location,
+        location,
         -1.0); // we choose a negative value because our function is
                // non-negative
-    // result.location is the estimated location of the minimum.
+    // location is the estimated location of the minimum.
+    result.location = location;
     result.tstop = now_in_milliseconds();
     result.value = f_value;
     result.nsteps = nsteps;
     return result;
   }
 
-  // ParallelMinimizer is a callable object designed to be executed through
-  // tasks in a TBB task group. It works by:
-  //    1. calling the local minimization function for the given starting
-  //       point.
-  //    2. recording the resulting minimum in the shared solution.
-  //    3. if the shared solution says we are not done, generate a new
-  //       starting point keep trying.
+  // A local minimization policy is a callable object that is given the
+  // function to be minimized, the starting point, and the shared_result that
+  // will receive the result, and returns the solution it found. It should
+  // stop early if solutions.budget_expired() becomes true.
+  //
+  // bfgs_minimizer, the default policy, uses dlib's BFGS with numerically
+  // estimated derivatives. It is best suited to smooth functions. For
+  // functions that are not differentiable at their minima, see
+  // nelder_mead_minimizer in nelder_mead.hh.
+  struct bfgs_minimizer {
+    template <typename FUNC, typename VEC>
+    solution
+    operator()(FUNC const& f,
+               VEC const& starting_point,
+               shared_result const& solutions) const
+    {
+      return do_one_minimization(
+        f, starting_point, budget_stop_strategy(1.0e-6, solutions));
+    }
+  };
+
+  namespace detail {
+    // box_derivative estimates the gradient of f by central differences, as
+    // dlib::derivative does, except that the points are clamped to the box
+    // [lower, upper]. At a bound the difference becomes one-sided, so f is
+    // never called outside the box.
+    template <typename FUNC>
+    struct box_derivative {
+      FUNC const& f;
+      column_vector const& lower;
+      column_vector const& upper;
+      double eps = 1.0e-7;
+
+      column_vector
+      operator()(column_vector const& x) const
+      {
+        column_vector grad(x.size());
+        column_vector xx = x;
+        for (long i = 0; i != x.size(); ++i) {
+          double const h = eps * std::max(1.0, std::abs(x(i)));
+          double const hi = std::min(x(i) + h, upper(i));
+          double const lo = std::max(x(i) - h, lower(i));
+          if (hi <= lo) {
+            // A dimension of zero width can not be moved along.
+            grad(i) = 0.0;
+            continue;
+          }
+          xx(i) = hi;
+          double const f_hi = f(xx);
+          xx(i) = lo;
+          double const f_lo = f(xx);
+          xx(i) = x(i);
+          grad(i) = (f_hi - f_lo) / (hi - lo);
+        }
+        return grad;
+      }
+    };
+
+    // counting_stop_strategy passes the decisions of another stop strategy
+    // through, counting the iterations in *nsteps. dlib takes its stop
+    // strategy by value, so the count can not be kept in the object itself.
+    template <typename STOP>
+    struct counting_stop_strategy {
+      STOP stop;
+      long* nsteps;
+
+      template <typename T>
+      bool
+      should_continue_search(T const& x, double funct_value, T const& deriv)
+      {
+        if (!stop.should_continue_search(x, funct_value, deriv))
+          return false;
+        ++*nsteps;
+        return true;
+      }
+    };
+  }
+
+  // box_constrained_minimizer is a local minimization policy that keeps the
+  // search within a box, usually the region from which the starting points
+  // are drawn. It uses dlib's projected BFGS, with derivatives estimated by
+  // finite differences that are clamped to the box (one-sided at a bound).
+  // This avoids wasting function calls far outside the region of interest,
+  // and never calls the function outside the bounds (e.g. where the
+  // parameters are unphysical); a starting point outside the box is first
+  // moved to the nearest point inside it. The solution records whether any
+  // bound is active at the minimum found.
+  struct box_constrained_minimizer {
+    column_vector lower;
+    column_vector upper;
+
+    explicit box_constrained_minimizer(region<column_vector> const& bounds)
+      : lower(bounds.lower()), upper(bounds.upper())
+    {}
+
+    template <typename FUNC>
+    solution
+    operator()(FUNC const& f,
+               column_vector const& starting_point,
+               shared_result const& solutions) const
+    {
+      solution result;
+      result.start = dlib::clamp(starting_point, lower, upper);
+      result.start_value = f(result.start);
+      result.tstart = now_in_milliseconds();
+      result.location = result.start;
+      result.nsteps = 0;
+      result.value = dlib::find_min_box_constrained(
+        dlib::bfgs_search_strategy(),
+        detail::counting_stop_strategy<budget_stop_strategy>{
+          budget_stop_strategy(1.0e-6, solutions), &result.nsteps},
+        f,
+        detail::box_derivative<FUNC>{f, lower, upper},
+        result.location,
+        lower,
+        upper);
+      result.tstop = now_in_milliseconds();
+      // dlib projects the iterates onto the box, so a coordinate at a bound
+      // is exactly equal to it.
+      for (long i = 0; i != result.location.size(); ++i) {
+        if (result.location(i) <= lower(i) || result.location(i) >= upper(i))
+          result.bound_active = true;
+      }
+      return result;
+    }
+  };
+
+  // ParallelMinimizer does the local minimization attempts of a search. Each
+  // call to attempt:
+  //    1. generates a starting point within the starting point volume.
+  //    2. calls the local minimization function for that starting point.
+  //    3. records the resulting minimum in the shared solution.
+  // unless the shared solution says we are already done. Calling the object
+  // itself makes attempts until we are done.
+  // The local minimization is done by the policy LOCAL.
   template <std::uniform_random_bit_generator URBG,
             typename FUNC,
-            typename REGION>
+            typename REGION,
+            typename LOCAL>
   struct ParallelMinimizer {
     FUNC& func;
     shared_result& solutions;
     REGION const& starting_point_volume;
     protected_engine<URBG>& engine;
     long max_attempts;
+    LOCAL local_minimizer;
 
     ParallelMinimizer(FUNC& function_to_minimize,
                       shared_result& sol,
                       REGION const& spv,
                       protected_engine<URBG>& eng,
-                      long max_attempts = 1000000)
+                      long max_attempts = 1000000,
+                      LOCAL local = LOCAL())
       : func(function_to_minimize)
       , solutions(sol)
       , starting_point_volume(spv)
       , engine(eng)
       , max_attempts(max_attempts)
+      , local_minimizer(local)
     {}
 
+    // Make one attempt, and return true; or, if we are done, return false.
+    bool
+    attempt() const
+    {
+      if (solutions.is_done(max_attempts))
+        return false;
+      auto starting_point = random_point_within(starting_point_volume, engine);
+      solution result = local_minimizer(func, starting_point, solutions);
+      solutions.insert(result);
+      return true;
+    }
+
     void
     operator()() const
     {
       // Loop until we have a good enough solution, or until we've used all our
       // attempts.
-      // Note that if another task find a solution quickly enough, we may end
-      // never entering the loop.
-
-      while (!solutions.is_done(max_attempts)) {
-        auto starting_point =
-          random_point_within(starting_point_volume, engine);
-        solution result = do_one_minimization(func, starting_point);
-        solutions.insert(result);
+      while (attempt()) {
       }
     }
 
@@ -142,43 +406,162 @@ namespace pfc {
     }
   };
 
+  // Run 'func' in an arena limited to 'concurrency' threads, or in the
+  // current arena if that is no larger (so that any constraints of the
+  // current arena, such as a NUMA node, are kept). A concurrency of 0 means
+  // no limit.
+  template <typename FUNC>
+  void
+  run_with_concurrency(int concurrency, FUNC&& func)
+  {
+    if (concurrency <= 0 ||
+        concurrency >= oneapi::tbb::this_task_arena::max_concurrency()) {
+      func();
+      return;
+    }
+    oneapi::tbb::task_arena arena(concurrency);
+    arena.execute(func);
+  }
+
+  // This is the function that does all the parallel work of a search. The
+  // attempts are the index space [0, max_attempts), which is scheduled with
+  // tbb::parallel_for, so that threads that finish their attempts quickly
+  // take work from those that do not, whether the attempts are many and
+  // cheap or few and expensive. Each attempt records its result into
+  // 'solutions'. When 'solutions' says we are done, the remaining attempts
+  // are cancelled. This runs in the current task arena, and returns when all
+  // the attempts are done or cancelled.
+  template <typename FUNC, typename REGION, typename URBG, typename LOCAL>
+  void
+  run_parallel_attempts(FUNC& func,
+                        REGION const& starting_point_volume,
+                        shared_result& solutions,
+                        protected_engine<URBG>& engine,
+                        long max_attempts,
+                        long grain_size,
+                        LOCAL local_minimizer)
+  {
+    using range = oneapi::tbb::blocked_range<long>;
+    ParallelMinimizer minimizer(func,
+                                solutions,
+                                starting_point_volume,
+                                engine,
+                                max_attempts,
+                                local_minimizer);
+    oneapi::tbb::task_group_context context;
+    oneapi::tbb::parallel_for(
+      range(0, max_attempts, grain_size),
+      [&minimizer, &context](range const& r) {
+        for (long i = r.begin(); i != r.end(); ++i) {
+          if (!minimizer.attempt()) {
+            context.cancel_group_execution();
+            return;
+          }
+        }
+      },
+      oneapi::tbb::auto_partitioner(),
+      context);
+  }
+
+  // This runs the search for find_global_minimum and
+  // find_global_minimum_fixed, with at most 'num_tasks' threads working at
+  // once; see run_parallel_attempts. Callers that need more than the best
+  // solutions (e.g. the statistics kept by the shared_result) can call it
+  // directly.
+  template <typename FUNC, typename REGION, typename URBG, typename LOCAL>
+  void
+  run_parallel_minimizers(FUNC&& func,
+                          REGION const& starting_point_volume,
+                          shared_result& solutions,
+                          protected_engine<URBG>& engine,
+                          int num_tasks,
+                          long max_attempts,
+                          LOCAL local_minimizer)
+  {
+    run_with_concurrency(num_tasks, [&]() {
+      run_parallel_attempts(func,
+                            starting_point_volume,
+                            solutions,
+                            engine,
+                            max_attempts,
+                            1,
+                            local_minimizer);
+    });
+  }
+
   // This is the function that does all the minimization work.
   // It is a blocking function that schedules parallel work, and waits until
   // that work is done before returning.
-  template <typename FUNC>
+  //
+  // 'num_starting_points' is used both as the number of threads to use and as
+  // the number of best solutions to keep; the overload taking a
+  // search_config allows them to be set independently.
+  template <typename FUNC, typename LOCAL>
   minimization_results
   find_global_minimum(FUNC&& func,
                       long ndim,
                       region<column_vector> const& starting_point_volume,
                       int num_starting_points,
                       double tolerance,
-                      long max_attempts)
+                      long max_attempts,
+                      LOCAL local_minimizer)
   {
-    shared_result solutions(tolerance, num_starting_points);
-    // The task group is what we use to schedule tasks to run.
-    oneapi::tbb::task_group tasks;
+    search_config config;
+    config.concurrency = num_starting_points;
+    config.num_retained = num_starting_points;
+    config.max_attempts = max_attempts;
+    return find_global_minimum(
+      func, starting_point_volume, tolerance, config, local_minimizer);
+  }
 
-    // All our starting points will be generated within the region
-    // 'starting_point_volume'. They will be generated using random variates
-    // generated by 'engine'.
-    protected_engine<std::mt19937> engine(std::time(0));
+  // When the default local minimizer is used, and the function can be called
+  // with a fixed_vector<N> (see accepts_fixed_vectors), where N is the
+  // dimensionality of the region and is at most max_fixed_ndim, the work is
+  // done with fixed_vector<N>.
+  template <typename FUNC, typename LOCAL>
+  minimization_results
+  find_global_minimum(FUNC&& func,
+                      region<column_vector> const& starting_point_volume,
+                      double tolerance,
+                      search_config const& config,
+                      LOCAL local_minimizer)
+  {
+    auto search = [&](auto const& volume, auto local) -> minimization_results {
+      shared_result solutions(tolerance, config.num_retained);
 
-    ParallelMinimizer minimizer(std::forward<FUNC&&>(func),
-                                solutions,
-                                starting_point_volume,
-                                engine,
-                                max_attempts);
+      // All our starting points will be generated within the region
+      // 'volume'. They will be generated using random variates generated by
+      // 'engine'.
+      protected_engine<std::mt19937> engine(std::time(0));
 
-    for (int i = 0; i != num_starting_points; ++i) {
-      // We have to give a callable with no arguments to tasks.run, so we need
-      // a lambda expression that captures all the arguments to be used
-      // for the call to minimizer.
-      tasks.run([minimizer]() { minimizer(); });
-    }
-    // Wait for all the tasks in the group to finish.
-    tasks.wait();
+      run_with_concurrency(config.concurrency, [&]() {
+        run_parallel_attempts(func,
+                              volume,
+                              solutions,
+                              engine,
+                              config.max_attempts,
+                              config.grain_size,
+                              local);
+      });
+      return {solutions.solutions(), solutions.num_attempts()};
+    };
+    auto dynamic = [&]() -> minimization_results {
+      return search(starting_point_volume, local_minimizer);
+    };
 
-    return {solutions.solutions(), minimizer.num_attempts()};
+    if constexpr (std::is_same_v<LOCAL, bfgs_minimizer>) {
+      auto fixed = [&](auto n) -> minimization_results {
+        constexpr int N = decltype(n)::value;
+        if constexpr (accepts_fixed_vectors<FUNC, N>())
+          return search(to_fixed_region<N>(starting_point_volume),
+                        bfgs_minimizer());
+        else
+          return dynamic();
+      };
+      return dispatch_on_ndim(starting_point_volume.ndims(), fixed, dynamic);
+    } else {
+      return dynamic();
+    }
   }
 
   template <typename FUNC, typename REGION>
@@ -189,28 +572,45 @@ namespace pfc {
                             double tolerance,
                             long max_attempts)
   {
-    using tt = typename callable_traits<FUNC>::template arg_t<0>;
-    int const N = sizeof(tt) / sizeof(double);
     shared_result solutions(tolerance, num_starting_points);
-    // The task group is what we use to schedule tasks to run.
-    oneapi::tbb::task_group tasks;
 
     // All our starting points will be generated within the region
     // 'starting_point_volume'. They will be generated using random variates
     // generated by 'engine'.
     protected_engine<std::mt19937> engine(std::time(0));
-    ParallelMinimizer minimizer(
-      std::forward<FUNC&&>(func), solutions, starting_point_volume, engine);
-
-    for (int i = 0; i != num_starting_points; ++i) {
-      // We have to give a callable with no arguments to tasks.run, so we need
-      // a lambda expression that captures all the arguments to be used
-      // for the call to minimizer.
-      tasks.run([minimizer]() { minimizer(); });
-    }
-    // Wait for all the tasks in the group to finish.
-    tasks.wait();
-    return {solutions.solutions(), minimizer.num_attempts()};
+
+    run_parallel_minimizers(std::forward<FUNC&&>(func),
+                            starting_point_volume,
+                            solutions,
+                            engine,
+                            num_starting_points,
+                            max_attempts);
+    return {solutions.solutions(), solutions.num_attempts()};
+  }
+
+  template <typename FUNC>
+  budgeted_minimization_results
+  find_global_minimum_within(FUNC&& func,
+                             region<column_vector> const& starting_point_volume,
+                             int num_starting_points,
+                             time_budget const& budget,
+                             long max_attempts)
+  {
+    // No value is good enough to stop early.
+    shared_result solutions(-std::numeric_limits<double>::infinity(),
+                            num_starting_points);
+    solutions.set_time_budget(budget);
+    protected_engine<std::mt19937> engine(std::time(0));
+
+    run_parallel_minimizers(func,
+                            starting_point_volume,
+                            solutions,
+                            engine,
+                            num_starting_points,
+                            max_attempts);
+    return {solutions.solutions(),
+            solutions.num_attempts(),
+            solutions.percent_budget_used()};
   }
 }
 #endif
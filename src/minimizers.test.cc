@@ -0,0 +1,102 @@
+#include "minimizers.hh"
+#include "batch_minimizer.hh"
+#include "geometry.hh"
+#include "rastrigin.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+TEST_CASE("search settings are independent")
+{
+  pfc::search_config config;
+  config.concurrency = 1;
+  config.num_retained = 5;
+  config.max_attempts = 37;
+  // No value is good enough to stop early, so every attempt is made.
+  auto [solutions, num_attempts] =
+    pfc::find_global_minimum(pfc::rastrigin_dlib,
+                             pfc::make_box_in_n_dim(2, -5.0, 5.0),
+                             -std::numeric_limits<double>::infinity(),
+                             config);
+  CHECK(num_attempts == 37);
+  CHECK(solutions.size() == 5);
+}
+
+TEST_CASE("a search stops when a good enough solution is found")
+{
+  pfc::search_config config;
+  config.num_retained = 3;
+  config.max_attempts = 100000;
+  config.grain_size = 16;
+  auto [solutions, num_attempts] =
+    pfc::find_global_minimum(pfc::rastrigin_dlib,
+                             pfc::make_box_in_n_dim(1, -5.0, 5.0),
+                             1.0e-6,
+                             config);
+  CHECK(num_attempts < config.max_attempts);
+  REQUIRE(!solutions.empty());
+  // The solutions are only sorted once num_retained of them have been
+  // found, so the good enough one need not be first.
+  double best = std::numeric_limits<double>::infinity();
+  for (auto const& s : solutions)
+    best = std::min(best, s.value);
+  CHECK(best < 1.0e-6);
+}
+
+TEST_CASE("batch results are in the order of the problems")
+{
+  struct shifted_parabola {
+    double shift;
+    double
+    operator()(pfc::column_vector const& x) const
+    {
+      return (x(0) - shift) * (x(0) - shift);
+    }
+  };
+  std::vector<pfc::minimization_problem<shifted_parabola>> problems;
+  auto const volume = pfc::make_box_in_n_dim(1, -5.0, 5.0);
+  for (int i = 0; i != 20; ++i)
+    problems.push_back({shifted_parabola{0.1 * i}, volume, 1.0e-8});
+
+  pfc::batch_config config;
+  config.max_attempts = 50;
+  config.seed = 1;
+  auto const results = pfc::minimize_batch(problems, config);
+  REQUIRE(results.size() == problems.size());
+  for (std::size_t i = 0; i != results.size(); ++i) {
+    CHECK(results[i].converged);
+    CHECK(results[i].num_attempts <= config.max_attempts);
+    REQUIRE(!results[i].best_solutions.empty());
+    auto const& best = results[i].best_solutions.front();
+    CHECK(best.value < 1.0e-8);
+    CHECK(std::abs(best.location(0) - 0.1 * i) < 1.0e-3);
+  }
+}
+
+TEST_CASE("box_constrained_minimizer stays inside the box")
+{
+  auto const box = pfc::make_box_in_n_dim(2, -1.0, 1.0);
+  // The unconstrained minimum is at (2, 0.5), so the constrained one is at
+  // (1, 0.5), on the boundary.
+  long num_outside = 0;
+  auto f = [&](pfc::column_vector const& x) {
+    if (x(0) < -1.0 || x(0) > 1.0 || x(1) < -1.0 || x(1) > 1.0)
+      ++num_outside;
+    return (x(0) - 2.0) * (x(0) - 2.0) + (x(1) - 0.5) * (x(1) - 0.5);
+  };
+  pfc::shared_result solutions(-std::numeric_limits<double>::infinity(), 1);
+  for (double x0 : {-0.5, 0.9, 1.0}) {
+    auto const s = pfc::box_constrained_minimizer(box)(
+      f, pfc::column_vector({x0, 0.0}), solutions);
+    CHECK(num_outside == 0);
+    CHECK(s.bound_active);
+    CHECK(s.nsteps > 0);
+    CHECK(s.location(0) == 1.0);
+    CHECK(std::abs(s.location(1) - 0.5) < 1.0e-4);
+    CHECK(std::abs(s.value - 1.0) < 1.0e-8);
+  }
+}
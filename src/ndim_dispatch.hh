@@ -0,0 +1,102 @@
+#ifndef PROFILED_FC_CPU_NDIM_DISPATCH_HH
+#define PROFILED_FC_CPU_NDIM_DISPATCH_HH
+
+#include "callable_traits.hh"
+#include "geometry.hh"
+
+#include <type_traits>
+
+namespace pfc {
+
+  // The largest dimensionality for which dispatch_on_ndim uses a fixed-size
+  // vector type.
+  inline constexpr long max_fixed_ndim = 32;
+
+  // Call 'fixed(std::integral_constant<int, N>{})' if ndim is N, for N in
+  // [1, max_fixed_ndim], and 'dynamic()' otherwise. Both must return the same
+  // type. This lets code that is given a dimensionality at run time use
+  // fixed_vector<N>, for which dlib uses stack storage and unrolled loops.
+  // Every N in the range is instantiated, so this is expensive to compile.
+  template <typename FIXED, typename DYNAMIC>
+  decltype(auto) dispatch_on_ndim(long ndim, FIXED&& fixed, DYNAMIC&& dynamic);
+
+  // accepts_fixed_vectors<F, N> is true if F can be called with a
+  // fixed_vector<N> without first converting it to another vector type.
+  // This is so for generic callables (e.g. lambdas with 'auto' parameters,
+  // or class templates' call operators) that can be called with a
+  // fixed_vector<N>, for callables whose parameter is a fixed_vector<N>, and
+  // for callables whose parameter is not a dlib matrix (e.g. a std::span)
+  // but can be initialized from a fixed_vector<N>. It is false for callables
+  // whose parameter is a column_vector, or a fixed_vector of another size,
+  // because for those each call would need a conversion (and for a
+  // column_vector, a heap allocation).
+  template <typename F, int N>
+  constexpr bool accepts_fixed_vectors();
+
+  // Return a copy of 'r' that uses fixed_vector<N>. It is required that
+  // r.ndims() be N.
+  template <int N>
+  region<fixed_vector<N>> to_fixed_region(region<column_vector> const& r);
+
+  // Implementation details below.
+
+  namespace detail {
+    template <typename T>
+    inline constexpr bool is_dlib_matrix = false;
+
+    template <typename T, long NR, long NC>
+    inline constexpr bool is_dlib_matrix<dlib::matrix<T, NR, NC>> = true;
+
+    template <int N, typename FIXED, typename DYNAMIC>
+    decltype(auto)
+    dispatch_from(long ndim, FIXED& fixed, DYNAMIC& dynamic)
+    {
+      if constexpr (N > max_fixed_ndim) {
+        return dynamic();
+      } else {
+        if (ndim == N)
+          return fixed(std::integral_constant<int, N>{});
+        return dispatch_from<N + 1>(ndim, fixed, dynamic);
+      }
+    }
+  }
+
+  template <typename FIXED, typename DYNAMIC>
+  decltype(auto)
+  dispatch_on_ndim(long ndim, FIXED&& fixed, DYNAMIC&& dynamic)
+  {
+    return detail::dispatch_from<1>(ndim, fixed, dynamic);
+  }
+
+  template <typename F, int N>
+  constexpr bool
+  accepts_fixed_vectors()
+  {
+    using C = std::remove_cvref_t<F>;
+    if constexpr (!std::is_invocable_v<C const&, fixed_vector<N> const&>) {
+      return false;
+    } else if constexpr (std::is_class_v<C> && !requires { &C::operator(); }) {
+      // The call operator is a template (or overloaded), and it can be
+      // called with a fixed_vector<N>.
+      return true;
+    } else {
+      // dlib matrices of any size convert to each other, so being invocable
+      // is not enough: the parameter must be a fixed_vector<N> itself.
+      using arg = std::remove_cvref_t<
+        typename callable_traits<C>::template arg_t<0>>;
+      if constexpr (detail::is_dlib_matrix<arg>)
+        return std::is_same_v<arg, fixed_vector<N>>;
+      else
+        return true;
+    }
+  }
+
+  template <int N>
+  region<fixed_vector<N>>
+  to_fixed_region(region<column_vector> const& r)
+  {
+    return {fixed_vector<N>(r.lower()), fixed_vector<N>(r.upper())};
+  }
+}
+
+#endif
@@ -0,0 +1,88 @@
+#include "ndim_dispatch.hh"
+#include "geometry.hh"
+#include "minimizers.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <limits>
+#include <span>
+
+using pfc::column_vector;
+using pfc::fixed_vector;
+
+namespace {
+  double
+  bowl(std::span<double const> x)
+  {
+    double sum = 0.0;
+    for (double v : x)
+      sum += (v - 0.5) * (v - 0.5);
+    return sum;
+  }
+
+  double
+  bowl_dynamic(column_vector const& x)
+  {
+    return bowl(x);
+  }
+
+  double
+  bowl_3(fixed_vector<3> const& x)
+  {
+    return bowl(x);
+  }
+
+  struct generic_bowl {
+    template <typename VEC>
+    double
+    operator()(VEC const& x) const
+    {
+      return bowl(x);
+    }
+  };
+
+  // Search for the minimum of 'f' in the box [-1, 1]^ndim.
+  template <typename FUNC>
+  pfc::minimization_results
+  search(FUNC&& f, int ndim)
+  {
+    pfc::search_config config;
+    config.num_retained = 1;
+    config.max_attempts = 4;
+    return pfc::find_global_minimum(f,
+                                    pfc::make_box_in_n_dim(ndim, -1.0, 1.0),
+                                    -std::numeric_limits<double>::infinity(),
+                                    config);
+  }
+
+  void
+  check_search(pfc::minimization_results const& results, long ndim)
+  {
+    CHECK(results.num_attempts == 4);
+    REQUIRE(results.best_solutions.size() == 1);
+    CHECK(results.best_solutions.front().location.size() == ndim);
+    CHECK(results.best_solutions.front().value < 1.0e-8);
+  }
+}
+
+TEST_CASE("accepts_fixed_vectors looks at the parameter type")
+{
+  STATIC_REQUIRE(!pfc::accepts_fixed_vectors<decltype(bowl_dynamic), 3>());
+  STATIC_REQUIRE(pfc::accepts_fixed_vectors<decltype(bowl_3), 3>());
+  STATIC_REQUIRE(!pfc::accepts_fixed_vectors<decltype(bowl_3), 2>());
+  STATIC_REQUIRE(pfc::accepts_fixed_vectors<decltype(bowl), 2>());
+  STATIC_REQUIRE(pfc::accepts_fixed_vectors<generic_bowl, 2>());
+  auto lambda = [](column_vector const& x) { return bowl(x); };
+  STATIC_REQUIRE(!pfc::accepts_fixed_vectors<decltype(lambda), 2>());
+}
+
+TEST_CASE("find_global_minimum dispatches on the parameter type")
+{
+  for (int ndim : {1, 3, 5}) {
+    check_search(search(bowl_dynamic, ndim), ndim);
+    check_search(search(bowl, ndim), ndim);
+    check_search(search(generic_bowl(), ndim), ndim);
+  }
+  // A function of fixed_vector<3> can only be minimized in 3 dimensions.
+  check_search(search(bowl_3, 3), 3);
+}
@@ -0,0 +1,222 @@
+#ifndef PROFILED_FC_CPU_NELDER_MEAD_HH
+#define PROFILED_FC_CPU_NELDER_MEAD_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "tbb/parallel_for.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace pfc {
+
+  // nelder_mead_minimizer is a local minimization policy (see
+  // bfgs_minimizer in minimizers.hh) that uses the Nelder-Mead simplex
+  // method. It uses no derivatives, and so is suitable for functions that
+  // are not differentiable at their minima, such as the maximum absolute
+  // deviation of a fit.
+  //
+  // The expansion, contraction and shrink coefficients are the adaptive ones
+  // of Gao and Han (2012), which behave better than the classic ones in
+  // more than a few dimensions.
+  //
+  // The vertices of the initial simplex, and those of a shrink step, are
+  // evaluated in parallel. If 'parallel_steps' is true, each iteration also
+  // evaluates all four of its candidate points (the reflected, expanded,
+  // and outside and inside contracted points) at once, in parallel, before
+  // choosing among them as the serial method does; the simplices are the
+  // same as those of the serial method, but each iteration takes the wall
+  // time of about one call instead of up to three, at the cost of four
+  // calls instead of one to three. This pays when calls are expensive
+  // enough to outweigh the cost of the parallel_for. The function to be
+  // minimized must be safe to call from several threads at once, as it
+  // must be for any use with ParallelMinimizer.
+  struct nelder_mead_minimizer {
+    // Size of the initial simplex along each axis, relative to the magnitude
+    // of the starting point (or absolute, for coordinates smaller than 1).
+    double initial_step = 0.1;
+    // The search stops when the difference between the best and worst values
+    // in the simplex is no more than ftol, and no vertex is farther than xtol
+    // (in any coordinate) from the best vertex.
+    double ftol = 1.0e-12;
+    double xtol = 1.0e-10;
+    // The maximum number of function calls; zero means 200 times the
+    // number of dimensions.
+    long max_calls = 0;
+    // Evaluate the candidate points of each iteration speculatively, in
+    // parallel, as described above.
+    bool parallel_steps = true;
+
+    template <typename FUNC>
+    solution operator()(FUNC const& f,
+                        column_vector const& starting_point,
+                        shared_result const& solutions) const;
+  };
+
+  // Implementation details below.
+
+  namespace detail {
+    // Evaluate 'f' at the vertices vertices[order[k]] for k in [first,
+    // order.size()), in parallel, storing the results in values[order[k]].
+    template <typename FUNC>
+    void
+    evaluate_vertices(FUNC const& f,
+                      std::vector<column_vector> const& vertices,
+                      std::vector<std::size_t> const& order,
+                      std::size_t first,
+                      std::vector<double>& values)
+    {
+      oneapi::tbb::parallel_for(first, order.size(), [&](std::size_t k) {
+        values[order[k]] = f(vertices[order[k]]);
+      });
+    }
+
+    // Evaluate 'f' at each of 'points', in parallel, storing the results in
+    // 'values'.
+    template <typename FUNC, std::size_t N>
+    void
+    evaluate_points(FUNC const& f,
+                    std::array<column_vector, N> const& points,
+                    std::array<double, N>& values)
+    {
+      oneapi::tbb::parallel_for(std::size_t(0), N, [&](std::size_t k) {
+        values[k] = f(points[k]);
+      });
+    }
+  }
+
+  template <typename FUNC>
+  solution
+  nelder_mead_minimizer::operator()(FUNC const& f,
+                                    column_vector const& starting_point,
+                                    shared_result const& solutions) const
+  {
+    solution result;
+    result.start = starting_point;
+    result.start_value = f(starting_point);
+    result.tstart = now_in_milliseconds();
+
+    long const n = starting_point.size();
+    double const dn = static_cast<double>(n);
+    bool const adaptive = n > 1;
+    double const alpha = 1.0;
+    double const beta = adaptive ? 1.0 + 2.0 / dn : 2.0;
+    double const gamma = adaptive ? 0.75 - 0.5 / dn : 0.5;
+    double const delta = adaptive ? 1.0 - 1.0 / dn : 0.5;
+    long const call_limit = (max_calls > 0) ? max_calls : 200 * n;
+
+    // The initial simplex is the starting point, and one point displaced
+    // along each axis.
+    std::vector<column_vector> vertices(n + 1, starting_point);
+    std::vector<double> values(n + 1);
+    for (long i = 0; i != n; ++i)
+      vertices[i + 1](i) +=
+        initial_step * std::max(1.0, std::abs(starting_point(i)));
+    std::vector<std::size_t> order(n + 1);
+    std::iota(order.begin(), order.end(), 0);
+    values[0] = result.start_value;
+    detail::evaluate_vertices(f, vertices, order, 1, values);
+    long ncalls = n + 1;
+
+    long iteration = 0;
+    for (;; ++iteration) {
+      // Keep 'order' sorted from best vertex to worst.
+      std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return values[a] < values[b];
+      });
+      column_vector const& best = vertices[order.front()];
+      std::size_t const worst = order.back();
+
+      double max_dist = 0.0;
+      for (long k = 1; k <= n; ++k)
+        max_dist = std::max(
+          max_dist, dlib::max(dlib::abs(vertices[order[k]] - best)));
+      if ((values[worst] - values[order.front()] <= ftol &&
+           max_dist <= xtol) ||
+          ncalls >= call_limit || solutions.budget_expired())
+        break;
+
+      column_vector centroid = vertices[order[0]];
+      for (long k = 1; k != n; ++k)
+        centroid += vertices[order[k]];
+      centroid /= dn;
+
+      // The candidates for the new vertex: the reflected and expanded
+      // points, and the contractions outside and inside the simplex.
+      column_vector const reflected =
+        centroid + alpha * (centroid - vertices[worst]);
+      std::array<column_vector, 4> const candidates{
+        reflected,
+        centroid + beta * (reflected - centroid),
+        centroid + gamma * (reflected - centroid),
+        centroid + gamma * (vertices[worst] - centroid)};
+      std::array<double, 4> candidate_values;
+      if (parallel_steps) {
+        detail::evaluate_points(f, candidates, candidate_values);
+        ncalls += 4;
+      }
+      // Return the value of candidate k, calling f for it unless it has
+      // been evaluated already. Each candidate is asked for at most once.
+      auto value_of = [&](std::size_t k) {
+        if (!parallel_steps) {
+          candidate_values[k] = f(candidates[k]);
+          ++ncalls;
+        }
+        return candidate_values[k];
+      };
+
+      double const f_reflected = value_of(0);
+      if (f_reflected < values[order.front()]) {
+        double const f_expanded = value_of(1);
+        if (f_expanded < f_reflected) {
+          vertices[worst] = candidates[1];
+          values[worst] = f_expanded;
+        } else {
+          vertices[worst] = reflected;
+          values[worst] = f_reflected;
+        }
+        continue;
+      }
+
+      if (f_reflected < values[order[n - 1]]) {
+        vertices[worst] = reflected;
+        values[worst] = f_reflected;
+        continue;
+      }
+
+      // Contract, outside the simplex if the reflected point is better than
+      // the worst vertex, inside otherwise.
+      bool const outside = f_reflected < values[worst];
+      std::size_t const contracted = outside ? 2 : 3;
+      double const f_contracted = value_of(contracted);
+      if (f_contracted < (outside ? f_reflected : values[worst])) {
+        vertices[worst] = candidates[contracted];
+        values[worst] = f_contracted;
+        continue;
+      }
+
+      // Nothing worked; shrink the simplex towards the best vertex.
+      for (long k = 1; k <= n; ++k) {
+        auto& v = vertices[order[k]];
+        v = best + delta * (v - best);
+      }
+      detail::evaluate_vertices(f, vertices, order, 1, values);
+      ncalls += n;
+    }
+
+    result.location = vertices[order.front()];
+    result.value = values[order.front()];
+    result.tstop = now_in_milliseconds();
+    result.nsteps = iteration;
+    return result;
+  }
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "nelder_mead.hh"
+#include "geometry.hh"
+#include "helical_valley.hh"
+#include "rosenbrock.hh"
+#include "shared_result.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <span>
+
+using pfc::column_vector;
+
+namespace {
+  double
+  rosenbrock_2d(column_vector const& x)
+  {
+    std::span<double const> xx = x;
+    return pfc::vec_rosenbrock(xx);
+  }
+
+  // Minimize 'f' from 'start' and check the fields of the solution that do
+  // not depend on the function.
+  template <typename FUNC>
+  pfc::solution
+  check_minimization(FUNC const& f, column_vector const& start)
+  {
+    pfc::shared_result solutions(0.0, 1);
+    pfc::nelder_mead_minimizer minimizer;
+    minimizer.max_calls = 20000;
+    auto const result = minimizer(f, start, solutions);
+    CHECK(result.start(0) == start(0));
+    CHECK(result.start(1) == start(1));
+    CHECK(result.start_value == f(start));
+    CHECK(result.nsteps > 0);
+    CHECK(result.tstart <= result.tstop);
+    CHECK(result.value <= result.start_value);
+    return result;
+  }
+}
+
+TEST_CASE("nelder_mead_minimizer finds the minimum of the Rosenbrock function")
+{
+  auto const result =
+    check_minimization(rosenbrock_2d, column_vector({-1.2, 1.0}));
+  CHECK(result.value < 1.0e-10);
+  CHECK(std::abs(result.location(0) - 1.0) < 1.0e-4);
+  CHECK(std::abs(result.location(1) - 1.0) < 1.0e-4);
+}
+
+TEST_CASE("nelder_mead_minimizer finds the minimum of the helical valley")
+{
+  auto const result =
+    check_minimization(pfc::helical_valley, column_vector({0.5, 0.5, 0.5}));
+  CHECK(result.value < 1.0e-10);
+  CHECK(std::abs(result.location(0) - 1.0) < 1.0e-4);
+  CHECK(std::abs(result.location(1)) < 1.0e-4);
+  CHECK(std::abs(result.location(2)) < 1.0e-4);
+}
+
+TEST_CASE("nelder_mead_minimizer takes the same steps in parallel")
+{
+  std::atomic<long> ncalls = 0;
+  auto counted = [&ncalls](column_vector const& x) {
+    ncalls.fetch_add(1);
+    return rosenbrock_2d(x);
+  };
+  pfc::shared_result solutions(0.0, 1);
+  pfc::nelder_mead_minimizer minimizer;
+  minimizer.max_calls = 20000;
+  column_vector const start({-1.2, 1.0});
+
+  minimizer.parallel_steps = false;
+  auto const serial = minimizer(counted, start, solutions);
+  long const serial_calls = ncalls.exchange(0);
+  minimizer.parallel_steps = true;
+  auto const parallel = minimizer(counted, start, solutions);
+  long const parallel_calls = ncalls.load();
+
+  // The candidates are evaluated speculatively, so more calls are made, but
+  // the same ones are chosen.
+  CHECK(parallel.nsteps == serial.nsteps);
+  CHECK(parallel.value == serial.value);
+  CHECK(parallel.location(0) == serial.location(0));
+  CHECK(parallel.location(1) == serial.location(1));
+  CHECK(parallel_calls > serial_calls);
+  CHECK(parallel_calls <= 4 * serial_calls);
+}
@@ -0,0 +1,159 @@
+#ifndef PROFILED_FC_CPU_NUMA_MINIMIZER_HH
+#define PROFILED_FC_CPU_NUMA_MINIMIZER_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "protected_engine.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "tbb/info.h"
+#include "tbb/task_arena.h"
+#include "tbb/task_group.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <memory>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+namespace pfc {
+
+  // find_global_minimum_numa does the same work as find_global_minimum, but
+  // is aware of the NUMA topology of the machine.
+  //
+  // It creates one task_arena for each NUMA node, constrained to that node;
+  // when TBB is able to use hwloc (through the tbbbind library) the worker
+  // threads of each arena are pinned to the cores of its node. Each arena has
+  // its own copy of the function to be minimized, of the starting point
+  // volume, of the random engine and of the shared_result. These copies are
+  // made by a thread running in the arena, so that with the usual first-touch
+  // page placement policy their memory is local to the node. Starting points,
+  // solutions and objective data thus never need to cross between sockets
+  // during the search.
+  //
+  // The attempts allowed by 'max_attempts' are divided between the nodes in
+  // proportion to their number of threads. When any node finds a solution
+  // with value less than 'tolerance', all the other nodes are asked to stop.
+  // At the end the per-node results are merged: the best 'num_results'
+  // solutions of all the nodes are returned, and the attempts are summed.
+  //
+  // On a machine with a single NUMA node, or if TBB cannot determine the
+  // topology, this uses a single arena.
+  template <typename FUNC>
+  minimization_results find_global_minimum_numa(
+    FUNC const& func,
+    region<column_vector> const& starting_point_volume,
+    int num_results,
+    double tolerance,
+    long max_attempts = 1000000);
+
+  // Implementation details below.
+
+  namespace detail {
+    // The node-local state used by find_global_minimum_numa.
+    template <typename FUNC>
+    struct numa_node_state {
+      numa_node_state(FUNC const& f,
+                      region<column_vector> const& volume,
+                      double tolerance,
+                      std::size_t num_results,
+                      std::time_t seed)
+        : func(f)
+        , starting_point_volume(volume)
+        , solutions(tolerance, num_results)
+        , engine(seed)
+      {}
+
+      FUNC func;
+      region<column_vector> starting_point_volume;
+      shared_result solutions;
+      protected_engine<std::mt19937> engine;
+    };
+  }
+
+  template <typename FUNC>
+  minimization_results
+  find_global_minimum_numa(FUNC const& func,
+                           region<column_vector> const& starting_point_volume,
+                           int num_results,
+                           double tolerance,
+                           long max_attempts)
+  {
+    // FUNC may be a function type; we need something we can copy.
+    using func_t = std::decay_t<FUNC>;
+    using state_t = detail::numa_node_state<func_t>;
+
+    std::vector<oneapi::tbb::numa_node_id> const nodes =
+      oneapi::tbb::info::numa_nodes();
+    std::size_t const nnodes = nodes.size();
+
+    std::vector<int> concurrency(nnodes);
+    for (std::size_t i = 0; i != nnodes; ++i)
+      concurrency[i] = oneapi::tbb::info::default_concurrency(nodes[i]);
+    long total_concurrency = 0;
+    for (int c : concurrency)
+      total_concurrency += c;
+
+    std::vector<std::unique_ptr<oneapi::tbb::task_arena>> arenas;
+    std::vector<std::unique_ptr<state_t>> states(nnodes);
+    std::vector<oneapi::tbb::task_group> groups(nnodes);
+    std::time_t const seed = std::time(0);
+    for (std::size_t i = 0; i != nnodes; ++i) {
+      arenas.push_back(std::make_unique<oneapi::tbb::task_arena>(
+        oneapi::tbb::task_arena::constraints{}.set_numa_id(nodes[i])));
+      // Allocate the node-local state from within the arena, so that the
+      // memory is first touched by a thread on that node.
+      arenas[i]->execute([&, i]() {
+        states[i] = std::make_unique<state_t>(
+          func, starting_point_volume, tolerance, num_results, seed + i);
+      });
+    }
+
+    // Start the work in all the arenas, and only then wait for all of them,
+    // so that the nodes work concurrently.
+    for (std::size_t i = 0; i != nnodes; ++i) {
+      long const node_attempts =
+        std::max(1L, max_attempts * concurrency[i] / total_concurrency);
+      arenas[i]->execute([&, i, node_attempts]() {
+        groups[i].run([&, i, node_attempts]() {
+          state_t& s = *states[i];
+          run_parallel_minimizers(s.func,
+                                  s.starting_point_volume,
+                                  s.solutions,
+                                  s.engine,
+                                  concurrency[i],
+                                  node_attempts);
+          // If this node found a good enough solution, there is no reason
+          // for the other nodes to continue.
+          if (!std::isnan(s.solutions.first_success_time())) {
+            for (auto& other : states)
+              other->solutions.request_stop();
+          }
+        });
+      });
+    }
+    for (std::size_t i = 0; i != nnodes; ++i) {
+      arenas[i]->execute([&, i]() { groups[i].wait(); });
+    }
+
+    // Merge the results of all the nodes.
+    minimization_results result;
+    result.num_attempts = 0;
+    for (auto const& s : states) {
+      auto node_solutions = s->solutions.solutions();
+      result.best_solutions.insert(result.best_solutions.end(),
+                                   node_solutions.begin(),
+                                   node_solutions.end());
+      result.num_attempts += s->solutions.num_attempts();
+    }
+    std::sort(result.best_solutions.begin(), result.best_solutions.end());
+    if (result.best_solutions.size() > static_cast<std::size_t>(num_results))
+      result.best_solutions.resize(num_results);
+    return result;
+  }
+}
+
+#endif
@@ -0,0 +1,77 @@
+#include "async_minimizer.hh"
+#include "geometry.hh"
+#include "rastrigin.hh"
+#include "solution.hh"
+
+#include "tbb/task_arena.h" // for default_concurrency()
+
+#include <chrono>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// This program demonstrates the asynchronous interface to the global
+// minimizer. It starts one search of the Rastrigin function for each number
+// of dimensions from 2 to the given maximum, all running at the same time.
+// While they run, it reports their progress every 'interval' milliseconds,
+// and cancels any search that has not finished after 'timeout'
+// milliseconds. Each improvement found by any search is written to standard
+// error as it happens.
+
+int
+main(int argc, char** argv)
+{
+  if (argc < 2 || argc > 4) {
+    std::cerr << "Usage: pfc_async_example <max ndim> [timeout] [interval]\n";
+    return 1;
+  }
+  long const max_ndim = std::stol(argv[1]);
+  double const timeout = (argc > 2) ? std::stod(argv[2]) : 10000.0;
+  std::chrono::milliseconds const interval((argc > 3) ? std::stol(argv[3])
+                                                      : 500);
+  int const num_starting_points = oneapi::tbb::info::default_concurrency();
+  double const nan = std::numeric_limits<double>::quiet_NaN();
+
+  double const start = pfc::now_in_milliseconds();
+  std::vector<pfc::minimization_handle> searches;
+  for (long ndim = 2; ndim <= max_ndim; ++ndim) {
+    searches.push_back(pfc::start_global_minimization(
+      pfc::rastrigin_dlib,
+      pfc::make_box_in_n_dim(ndim, -10.0, 10.0),
+      num_starting_points,
+      1.e-6,
+      1000000,
+      [ndim, start](pfc::solution const& s) {
+        std::cerr << "ndim " << ndim << ": improved to " << s.value
+                  << " after " << s.tstop - start << " milliseconds\n";
+      }));
+  }
+
+  // We wait on the first unfinished search, so that no thread spins while
+  // waiting, and print a progress report each time the wait times out.
+  for (auto& search : searches) {
+    while (!search.wait_for(interval)) {
+      for (std::size_t i = 0; i != searches.size(); ++i) {
+        auto const best = searches[i].best();
+        std::cerr << "ndim " << i + 2 << ": "
+                  << searches[i].num_attempts() << " attempts, "
+                  << searches[i].attempt_rate() << " per millisecond, best "
+                  << (best ? best->value : nan) << '\n';
+      }
+      if (pfc::now_in_milliseconds() - start > timeout) {
+        for (auto& s : searches)
+          s.cancel();
+      }
+    }
+  }
+
+  std::cout << "ndim\tattempts\trate\tbest\n";
+  for (std::size_t i = 0; i != searches.size(); ++i) {
+    auto [solutions, num_attempts] = searches[i].results();
+    std::cout << i + 2 << '\t' << num_attempts << '\t'
+              << searches[i].attempt_rate() << '\t'
+              << (solutions.empty() ? nan : searches[i].best()->value)
+              << '\n';
+  }
+}
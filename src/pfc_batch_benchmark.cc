@@ -0,0 +1,120 @@
+#include "batch_minimizer.hh"
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "rastrigin.hh"
+
+#include "tbb/task_arena.h" // for default_concurrency()
+
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// This program compares two ways of minimizing many small, independent
+// problems, as in Feldman-Cousins or bootstrap studies with one problem per
+// toy dataset: calling find_global_minimum once per problem, and calling
+// minimize_batch once for all of them.
+//
+// Each problem is the 2-dimensional Rastrigin function, shifted by a random
+// offset of up to 1 in each coordinate (standing in for the fluctuations of
+// a toy dataset), with starting points in [-5, 5]^2, and stopping when a
+// value below 1e-6 is found or after 1000 attempts.
+//
+// The optional argument is the number of problems (default 1000). The
+// output is tab-separated values with a header line, on standard output.
+
+namespace {
+
+  struct shifted_rastrigin {
+    pfc::column_vector shift;
+
+    double
+    operator()(pfc::column_vector const& x) const
+    {
+      pfc::column_vector const y = x - shift;
+      std::span yy = y;
+      return pfc::rastrigin(yy);
+    }
+  };
+
+  struct totals {
+    long converged = 0;
+    long attempts = 0;
+  };
+
+  void
+  print_line(std::string const& method,
+             std::size_t nproblems,
+             totals const& t,
+             double wall_ms)
+  {
+    std::cout << method << '\t' << nproblems << '\t' << t.converged << '\t'
+              << t.attempts << '\t' << wall_ms << '\t'
+              << nproblems / (wall_ms * 1.0e-3) << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 2) {
+    std::cerr << "Usage: pfc_batch_benchmark [nproblems]\n";
+    return 1;
+  }
+  std::size_t const nproblems = (argc > 1) ? std::stoul(argv[1]) : 1000;
+
+  std::mt19937 engine(12345);
+  std::uniform_real_distribution offset(-1.0, 1.0);
+  auto const volume = pfc::make_box_in_n_dim(2, -5.0, 5.0);
+  std::vector<pfc::minimization_problem<shifted_rastrigin>> problems;
+  for (std::size_t i = 0; i != nproblems; ++i) {
+    pfc::column_vector const shift({offset(engine), offset(engine)});
+    problems.push_back({shifted_rastrigin{shift}, volume, 1.0e-6});
+  }
+
+  pfc::batch_config config;
+  config.max_attempts = 1000;
+  config.num_retained = 4;
+
+  std::cout << "method\tproblems\tconverged\tattempts\twall_ms\t"
+               "problems_per_second\n";
+
+  // One call of find_global_minimum per problem.
+  {
+    pfc::search_config search;
+    search.concurrency = oneapi::tbb::info::default_concurrency();
+    search.num_retained = config.num_retained;
+    search.max_attempts = config.max_attempts;
+    totals t;
+    double const start = pfc::now_in_milliseconds();
+    for (auto const& problem : problems) {
+      auto [solutions, num_attempts] =
+        pfc::find_global_minimum(problem.func,
+                                 problem.starting_point_volume,
+                                 problem.tolerance,
+                                 search);
+      t.attempts += num_attempts;
+      if (!solutions.empty() && solutions.front().value < problem.tolerance)
+        t.converged += 1;
+    }
+    print_line("find_global_minimum",
+               nproblems,
+               t,
+               pfc::now_in_milliseconds() - start);
+  }
+
+  // One call of minimize_batch for all the problems.
+  {
+    totals t;
+    double const start = pfc::now_in_milliseconds();
+    auto const results = pfc::minimize_batch(problems, config);
+    double const wall_ms = pfc::now_in_milliseconds() - start;
+    for (auto const& r : results) {
+      t.attempts += r.num_attempts;
+      if (r.converged)
+        t.converged += 1;
+    }
+    print_line("minimize_batch", nproblems, t, wall_ms);
+  }
+}
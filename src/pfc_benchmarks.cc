@@ -0,0 +1,292 @@
+#include "benchmark.hh"
+#include "fastmath.hh"
+#include "geometry.hh"
+#include "helical_valley.hh"
+#include "minimizers.hh"
+#include "protected_engine.hh"
+#include "rastrigin.hh"
+#include "region_tree.hh"
+#include "rosenbrock.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include "tbb/task_arena.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// This program runs microbenchmarks of the hot paths of the library. The
+// results are written to standard output in tab-separated format, one line
+// per benchmark, so that they can be read directly by the R tools in docs/.
+// Progress messages go to standard error.
+
+namespace {
+
+  std::string
+  ndim_param(long ndim)
+  {
+    return "ndim=" + std::to_string(ndim);
+  }
+
+  void
+  bench_objectives(pfc::benchmark_config const& cfg, std::ostream& os)
+  {
+    std::mt19937 engine(42);
+    for (long ndim : {2, 5, 20}) {
+      auto volume = pfc::make_box_in_n_dim(ndim, -10.0, 10.0);
+      pfc::column_vector const x = pfc::random_point_within(volume, engine);
+      std::span<double const> xx = x;
+      os << pfc::run_benchmark("rastrigin", ndim_param(ndim), cfg, [&]() {
+        pfc::do_not_optimize(pfc::rastrigin(xx));
+      }) << '\n';
+      os << pfc::run_benchmark("vec_rosenbrock", ndim_param(ndim), cfg, [&]() {
+        pfc::do_not_optimize(pfc::vec_rosenbrock(xx));
+      }) << '\n';
+    }
+    auto volume = pfc::make_box_in_n_dim(3, -10.0, 10.0);
+    pfc::column_vector const x = pfc::random_point_within(volume, engine);
+    os << pfc::run_benchmark("helical_valley", ndim_param(3), cfg, [&]() {
+      pfc::do_not_optimize(pfc::helical_valley(x));
+    }) << '\n';
+  }
+
+  // Compare the fastmath kernels with the C library, on arrays of arguments
+  // covering the domain of each function. Each call processes the whole
+  // array, so the time reported is per array.
+  void
+  bench_fastmath(pfc::benchmark_config const& cfg, std::ostream& os)
+  {
+    namespace fm = pfc::fastmath;
+    std::size_t const n = 1024;
+    std::string const size = "n=" + std::to_string(n);
+    std::mt19937 engine(42);
+    std::uniform_real_distribution unit(-1.0, 1.0);
+    std::uniform_real_distribution angle(-100.0, 100.0);
+    std::vector<double> x(n);
+    std::vector<double> y(n);
+    std::vector<double> a(n);
+    for (std::size_t i = 0; i != n; ++i) {
+      x[i] = unit(engine);
+      y[i] = unit(engine);
+      a[i] = angle(engine);
+    }
+    std::vector<double> out(n);
+
+    os << pfc::run_benchmark("acos_libm", size, cfg, [&]() {
+      for (std::size_t i = 0; i != n; ++i)
+        out[i] = std::acos(x[i]);
+      pfc::do_not_optimize(out.data());
+    }) << '\n';
+    os << pfc::run_benchmark("acos_fastmath", size, cfg, [&]() {
+      fm::acos(x, out);
+      pfc::do_not_optimize(out.data());
+    }) << '\n';
+    os << pfc::run_benchmark("atan2_libm", size, cfg, [&]() {
+      for (std::size_t i = 0; i != n; ++i)
+        out[i] = std::atan2(y[i], x[i]);
+      pfc::do_not_optimize(out.data());
+    }) << '\n';
+    os << pfc::run_benchmark("atan2_fastmath", size, cfg, [&]() {
+      fm::atan2(y, x, out);
+      pfc::do_not_optimize(out.data());
+    }) << '\n';
+    os << pfc::run_benchmark("cos_libm", size, cfg, [&]() {
+      for (std::size_t i = 0; i != n; ++i)
+        out[i] = std::cos(a[i]);
+      pfc::do_not_optimize(out.data());
+    }) << '\n';
+    os << pfc::run_benchmark("cos_fastmath", size, cfg, [&]() {
+      fm::cos(a, out);
+      pfc::do_not_optimize(out.data());
+    }) << '\n';
+
+    // The objective functions, with each math policy.
+    auto volume = pfc::make_box_in_n_dim(20, -10.0, 10.0);
+    pfc::column_vector const p = pfc::random_point_within(volume, engine);
+    std::span<double const> pp = p;
+    os << pfc::run_benchmark("rastrigin_fastmath", ndim_param(20), cfg, [&]() {
+      pfc::do_not_optimize(pfc::rastrigin_with<fm::fast_math>(pp));
+    }) << '\n';
+    pfc::column_vector const q = pfc::random_point_within(
+      pfc::make_box_in_n_dim(3, -10.0, 10.0), engine);
+    os << pfc::run_benchmark(
+            "helical_valley_fastmath", ndim_param(3), cfg, [&]() {
+              pfc::do_not_optimize(pfc::helical_valley_with<fm::fast_math>(q));
+            })
+       << '\n';
+  }
+
+  void
+  bench_random_points(pfc::benchmark_config const& cfg, std::ostream& os)
+  {
+    auto volume = pfc::make_box_in_n_dim(5, -10.0, 10.0);
+    std::mt19937 engine(42);
+    os << pfc::run_benchmark("random_point_within", "mt19937", cfg, [&]() {
+      pfc::do_not_optimize(pfc::random_point_within(volume, engine));
+    }) << '\n';
+    pfc::protected_engine<std::mt19937> protected_eng(42);
+    os << pfc::run_benchmark(
+            "random_point_within", "protected_engine", cfg, [&]() {
+              pfc::do_not_optimize(
+                pfc::random_point_within(volume, protected_eng));
+            })
+       << '\n';
+  }
+
+  void
+  bench_splitting(pfc::benchmark_config const& cfg, std::ostream& os)
+  {
+    auto volume = pfc::make_box_in_n_dim(5, -10.0, 10.0);
+    os << pfc::run_benchmark("region_split", ndim_param(5), cfg, [&]() {
+      pfc::do_not_optimize(volume.split());
+    }) << '\n';
+
+    // make_splits does 2^ngenerations work, so we run fewer iterations.
+    pfc::benchmark_config split_cfg = cfg;
+    split_cfg.iterations = 10;
+    std::vector<pfc::region<pfc::column_vector>> const regions{volume};
+    for (int ngen : {4, 8, 12}) {
+      os << pfc::run_benchmark("make_splits",
+                               "ngenerations=" + std::to_string(ngen),
+                               split_cfg,
+                               [&]() {
+                                 pfc::do_not_optimize(
+                                   pfc::make_splits(ngen, regions));
+                               })
+         << '\n';
+    }
+
+    // region_tree computes each region on demand, so it can visit far more
+    // regions than make_splits can store.
+    for (int ngen : {4, 8, 12, 20}) {
+      pfc::region_tree const tree(volume, ngen);
+      os << pfc::run_benchmark(
+              "region_tree_walk",
+              "ngenerations=" + std::to_string(ngen),
+              split_cfg,
+              [&]() {
+                oneapi::tbb::parallel_for(tree.cells(1024), [&](auto const& r) {
+                  pfc::region<pfc::column_vector> cell(volume.ndims());
+                  for (auto it = r.begin(); it != r.end(); ++it) {
+                    tree.cell(ngen, it.index(), cell);
+                    pfc::do_not_optimize(cell.lower(0));
+                  }
+                });
+              })
+         << '\n';
+    }
+  }
+
+  // Measure the cost of shared_result::insert when 'nthreads' threads are all
+  // inserting at the same time. Each repetition uses a fresh shared_result,
+  // so the timing includes both the unfilled and the filled (sorted) phases.
+  void
+  bench_insert(pfc::benchmark_config const& cfg, std::ostream& os)
+  {
+    using clock = std::chrono::steady_clock;
+    long const ninserts = 10 * cfg.iterations;
+    std::size_t const max_results = 16;
+
+    std::mt19937 engine(42);
+    std::uniform_real_distribution flat(0.0, 1.0);
+    auto volume = pfc::make_box_in_n_dim(5, -10.0, 10.0);
+    std::vector<pfc::solution> candidates(ninserts);
+    for (auto& s : candidates) {
+      s.start = pfc::random_point_within(volume, engine);
+      s.location = pfc::random_point_within(volume, engine);
+      s.start_value = flat(engine);
+      s.value = flat(engine);
+      s.tstart = 0.0;
+      s.tstop = 0.0;
+    }
+
+    // We use powers of two up to, and always including, the full machine.
+    int const max_threads = oneapi::tbb::info::default_concurrency();
+    std::vector<int> thread_counts;
+    for (int n = 1; n < max_threads; n *= 2)
+      thread_counts.push_back(n);
+    thread_counts.push_back(max_threads);
+
+    for (int nthreads : thread_counts) {
+      oneapi::tbb::task_arena arena(nthreads);
+      std::vector<double> times;
+      for (int rep = 0; rep != cfg.warmup + cfg.repetitions; ++rep) {
+        // A negative desired minimum means we are never 'done'.
+        pfc::shared_result results(-1.0, max_results);
+        auto const start = clock::now();
+        arena.execute([&]() {
+          oneapi::tbb::parallel_for(
+            oneapi::tbb::blocked_range<long>(0, ninserts),
+            [&](oneapi::tbb::blocked_range<long> const& r) {
+              for (long i = r.begin(); i != r.end(); ++i)
+                results.insert(candidates[i]);
+            });
+        });
+        auto const stop = clock::now();
+        if (rep >= cfg.warmup)
+          times.push_back(
+            std::chrono::duration<double, std::nano>(stop - start).count());
+      }
+      os << pfc::summarize("shared_result_insert",
+                           "threads=" + std::to_string(nthreads),
+                           times,
+                           ninserts)
+         << '\n';
+    }
+  }
+
+  void
+  bench_minimization(pfc::benchmark_config const& cfg, std::ostream& os)
+  {
+    // Each minimization is expensive compared to the other benchmarks, so we
+    // run fewer of them per repetition.
+    pfc::benchmark_config min_cfg = cfg;
+    min_cfg.iterations = 20;
+    std::mt19937 engine(42);
+    for (long ndim : {2, 5}) {
+      auto volume = pfc::make_box_in_n_dim(ndim, -10.0, 10.0);
+      os << pfc::run_benchmark(
+              "do_one_minimization", "rastrigin_" + ndim_param(ndim), min_cfg,
+              [&]() {
+                auto start = pfc::random_point_within(volume, engine);
+                pfc::do_not_optimize(
+                  pfc::do_one_minimization(pfc::rastrigin_dlib, start));
+              })
+         << '\n';
+    }
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  pfc::benchmark_config cfg;
+  if (argc > 2) {
+    std::cerr << "Usage: pfc_benchmarks [repetitions]\n";
+    return 1;
+  }
+  if (argc == 2)
+    cfg.repetitions = std::stoi(argv[1]);
+
+  pfc::print_benchmark_header(std::cout);
+  std::cerr << "Benchmarking objective functions\n";
+  bench_objectives(cfg, std::cout);
+  std::cerr << "Benchmarking fastmath kernels\n";
+  bench_fastmath(cfg, std::cout);
+  std::cerr << "Benchmarking random point generation\n";
+  bench_random_points(cfg, std::cout);
+  std::cerr << "Benchmarking region splitting\n";
+  bench_splitting(cfg, std::cout);
+  std::cerr << "Benchmarking shared_result::insert\n";
+  bench_insert(cfg, std::cout);
+  std::cerr << "Benchmarking do_one_minimization\n";
+  bench_minimization(cfg, std::cout);
+}
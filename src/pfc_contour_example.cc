@@ -0,0 +1,77 @@
+#include "contour.hh"
+#include "geometry.hh"
+#include "minimizers.hh"
+
+#include <iostream>
+#include <string>
+
+// This program traces a confidence contour of a toy chi-squared, with two
+// parameters of interest (a, b) and two nuisance parameters (n1, n2),
+// using trace_contour, and compares the number of profile minimizations
+// it used with the number a grid scan of the same resolution would use.
+//
+// The toy chi-squared has a curved valley in (a, b), so that its contours
+// are not ellipses:
+//
+//   ((a - 1) / 0.3)^2 + ((b - a^2 - n1) / 0.2)^2 + (n1 / 0.1)^2
+//     + ((n2 - a b) / 0.5)^2 + n2^2
+//
+// All four parameters are searched over [-5, 5].
+//
+// The optional arguments are the delta chi-squared of the contour (default
+// 2.30) and the step between contour points, as a fraction of the extent of
+// the region (default 0.005). The contour points are written as
+// tab-separated values with a header line on standard output, and the
+// summary on standard error.
+
+namespace {
+  double
+  toy_chi2(pfc::column_vector const& p)
+  {
+    double const a = p(0);
+    double const b = p(1);
+    double const n1 = p(2);
+    double const n2 = p(3);
+    double const t1 = (a - 1.0) / 0.3;
+    double const t2 = (b - a * a - n1) / 0.2;
+    double const t3 = n1 / 0.1;
+    double const t4 = (n2 - a * b) / 0.5;
+    return t1 * t1 + t2 * t2 + t3 * t3 + t4 * t4 + n2 * n2;
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 3) {
+    std::cerr << "Usage: pfc_contour_example [level [step]]\n";
+    return 1;
+  }
+  pfc::contour_config config;
+  config.level = (argc > 1) ? std::stod(argv[1]) : 2.30;
+  config.step = (argc > 2) ? std::stod(argv[2]) : 0.005;
+
+  pfc::search_config search;
+  search.max_attempts = 100;
+  auto const bounds = pfc::make_box_in_n_dim(4, -5.0, 5.0);
+
+  double const start = pfc::now_in_milliseconds();
+  auto const result =
+    pfc::trace_contour(toy_chi2, bounds, 1.0e-12, search, config);
+  double const wall_ms = pfc::now_in_milliseconds() - start;
+
+  std::cout << "a\tb\tn1\tn2\tdelta\n";
+  for (auto const& p : result.points)
+    std::cout << p.location(0) << '\t' << p.location(1) << '\t'
+              << p.location(2) << '\t' << p.location(3) << '\t' << p.delta
+              << '\n';
+
+  std::cerr << "best fit value: " << result.global_fit.value << '\n'
+            << "contour points: " << result.points.size()
+            << (result.closed ? " (closed)" : " (open)") << '\n'
+            << "profile minimizations: " << result.num_profile_minimizations
+            << '\n'
+            << "grid of equal resolution: "
+            << pfc::equivalent_grid_size(config) << '\n'
+            << "wall time (ms): " << wall_ms << '\n';
+}
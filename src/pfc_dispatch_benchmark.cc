@@ -0,0 +1,68 @@
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "rastrigin.hh"
+
+#include "tbb/task_arena.h" // for default_concurrency()
+
+#include <iostream>
+#include <limits>
+#include <span>
+#include <string>
+
+// This program measures the benefit of the dimension dispatch done by
+// find_global_minimum. For each dimensionality from 2 to 20, it minimizes the
+// Rastrigin function twice, with the same number of local minimizations:
+//
+//   dynamic   the function takes a column_vector, so the whole minimization
+//             works with heap-allocated vectors;
+//   fixed     the function accepts any vector type, so find_global_minimum
+//             dispatches to fixed_vector<N>.
+//
+// For each run we report the throughput, in local minimizations per
+// millisecond. The output is tab-separated values with a header line, on
+// standard output.
+
+namespace {
+  struct rastrigin_generic {
+    template <typename VEC>
+    double
+    operator()(VEC const& x) const
+    {
+      std::span xx = x;
+      return pfc::rastrigin(xx);
+    }
+  };
+
+  template <typename FUNC>
+  void
+  measure(std::string const& path, FUNC const& func, long ndim, long attempts)
+  {
+    int const nthreads = oneapi::tbb::info::default_concurrency();
+    auto const volume = pfc::make_box_in_n_dim(ndim, -10.0, 10.0);
+    // A desired minimum that can never be reached makes every run do exactly
+    // 'attempts' minimizations.
+    double const never = -std::numeric_limits<double>::infinity();
+    double const start = pfc::now_in_milliseconds();
+    auto [solutions, num_attempts] =
+      pfc::find_global_minimum(func, ndim, volume, nthreads, never, attempts);
+    double const wall = pfc::now_in_milliseconds() - start;
+    std::cout << ndim << '\t' << path << '\t' << num_attempts << '\t' << wall
+              << '\t' << num_attempts / wall << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 2) {
+    std::cerr << "Usage: pfc_dispatch_benchmark [attempts]\n";
+    return 1;
+  }
+  long const attempts = (argc > 1) ? std::stol(argv[1]) : 2000;
+
+  std::cout << "ndim\tpath\tattempts\twall\tthroughput\n";
+  for (long ndim = 2; ndim <= 20; ++ndim) {
+    measure("dynamic", pfc::rastrigin_dlib, ndim, attempts);
+    measure("fixed", rastrigin_generic(), ndim, attempts);
+  }
+}
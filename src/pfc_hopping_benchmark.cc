@@ -0,0 +1,101 @@
+#include "basin_hopping.hh"
+#include "geometry.hh"
+#include "helical_valley.hh"
+#include "minimizers.hh"
+#include "rastrigin.hh"
+
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// This program compares the time to solution of basin hopping
+// (find_global_minimum_hopping) with that of the plain multistart search
+// (find_global_minimum), on the functions of the existing examples: the
+// Rastrigin function in 2 and 5 dimensions (starting points in [-10, 10]^n,
+// as in dlib_parallel_rastrigin_example_5d) and in 10 dimensions, and the
+// helical valley function (starting points in [-10, 10]^3). Each search
+// stops when a value below 1e-6 is found, or after the maximum number of
+// attempts.
+//
+// The optional arguments are the number of runs of each search (default
+// 10) and the maximum number of attempts (default 100000). For each search,
+// the number of runs that converged and the medians of the attempts and of
+// the wall time are written as tab-separated values on standard output.
+
+namespace {
+
+  double const tolerance = 1.0e-6;
+
+  double
+  median(std::vector<double> v)
+  {
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+  }
+
+  template <typename SEARCH>
+  void
+  run(std::string const& function_name,
+      long ndim,
+      std::string const& method,
+      int nruns,
+      SEARCH search)
+  {
+    int converged = 0;
+    std::vector<double> attempts;
+    std::vector<double> times;
+    for (int r = 0; r != nruns; ++r) {
+      double const start = pfc::now_in_milliseconds();
+      auto [solutions, num_attempts] = search();
+      times.push_back(pfc::now_in_milliseconds() - start);
+      attempts.push_back(num_attempts);
+      double best = std::numeric_limits<double>::infinity();
+      for (auto const& s : solutions)
+        best = std::min(best, s.value);
+      if (best < tolerance)
+        converged += 1;
+    }
+    std::cout << function_name << '\t' << ndim << '\t' << method << '\t'
+              << nruns << '\t' << converged << '\t' << median(attempts)
+              << '\t' << median(times) << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 3) {
+    std::cerr << "Usage: pfc_hopping_benchmark [nruns [max_attempts]]\n";
+    return 1;
+  }
+  int const nruns = (argc > 1) ? std::stoi(argv[1]) : 10;
+  long const max_attempts = (argc > 2) ? std::stol(argv[2]) : 100000;
+
+  pfc::search_config config;
+  config.max_attempts = max_attempts;
+
+  auto compare = [&](std::string const& name,
+                     auto const& func,
+                     pfc::region<pfc::column_vector> const& volume) {
+    long const ndim = volume.ndims();
+    run(name, ndim, "multistart", nruns, [&]() {
+      return pfc::find_global_minimum(func, volume, tolerance, config);
+    });
+    run(name, ndim, "basin_hopping", nruns, [&]() {
+      return pfc::find_global_minimum_hopping(func, volume, tolerance, config);
+    });
+  };
+
+  std::cout << "function\tndim\tmethod\truns\tconverged\tmedian_attempts\t"
+               "median_wall_ms\n";
+  for (int ndim : {2, 5, 10})
+    compare("rastrigin",
+            pfc::rastrigin_dlib,
+            pfc::make_box_in_n_dim(ndim, -10.0, 10.0));
+  compare("helical_valley",
+          pfc::helical_valley,
+          pfc::make_box_in_n_dim(3, -10.0, 10.0));
+}
@@ -0,0 +1,118 @@
+#include "fastmath.hh"
+#include "minimizers.hh"
+#include "poisson_likelihood.hh"
+
+#include "tbb/task_arena.h" // for default_concurrency()
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// This program measures the throughput of the binned Poisson likelihood
+// kernels of poisson_likelihood.hh: the -2 ln L kernel, with the libm and
+// the fast_math log, in bins per second; and the generation of Poisson toy
+// datasets, serially and in parallel, in toys per second.
+//
+// The expected counts are an exponentially falling spectrum on a flat
+// background, from about 1000 counts in the first bin to about 1 in the
+// last, so that both the inversion and the rejection methods of the toy
+// generator are exercised.
+//
+// The optional arguments are the number of bins (default 5000) and the
+// number of toys (default 10000). The output is tab-separated values with a
+// header line, on standard output.
+
+namespace {
+
+  void
+  print_line(std::string const& kernel,
+             std::size_t nbins,
+             long ncalls,
+             double wall_ms,
+             std::string const& unit,
+             double rate,
+             double check)
+  {
+    std::cout << kernel << '\t' << nbins << '\t' << ncalls << '\t' << wall_ms
+              << '\t' << unit << '\t' << rate << '\t' << check << '\n';
+  }
+
+  template <typename MATH>
+  void
+  time_m2lnl(std::string const& kernel,
+             std::vector<double> const& expected,
+             std::vector<pfc::binned_data> const& toys)
+  {
+    double sum = 0.0;
+    double const start = pfc::now_in_milliseconds();
+    for (auto const& toy : toys)
+      sum += pfc::poisson_m2lnl<MATH>(expected, toy);
+    double const wall_ms = pfc::now_in_milliseconds() - start;
+    double const nbins = static_cast<double>(expected.size()) * toys.size();
+    print_line(kernel,
+               expected.size(),
+               static_cast<long>(toys.size()),
+               wall_ms,
+               "bins_per_second",
+               nbins / (wall_ms * 1.0e-3),
+               sum / toys.size());
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 3) {
+    std::cerr << "Usage: pfc_likelihood_benchmark [nbins [ntoys]]\n";
+    return 1;
+  }
+  std::size_t const nbins = (argc > 1) ? std::stoul(argv[1]) : 5000;
+  std::size_t const ntoys = (argc > 2) ? std::stoul(argv[2]) : 10000;
+  std::uint64_t const seed = 20240601;
+
+  std::vector<double> expected(nbins);
+  for (std::size_t i = 0; i != nbins; ++i)
+    expected[i] = 1.0 + 1000.0 * std::exp(-7.0 * i / nbins);
+
+  std::cout << "kernel\tbins\tcalls\twall_ms\tunit\trate\tcheck\n";
+
+  // Serial toy generation.
+  {
+    std::vector<double> counts(nbins);
+    double sum = 0.0;
+    double const start = pfc::now_in_milliseconds();
+    for (std::size_t t = 0; t != ntoys; ++t) {
+      pfc::generate_poisson_toy(expected, seed, t, counts);
+      sum += counts.front();
+    }
+    double const wall_ms = pfc::now_in_milliseconds() - start;
+    print_line("toys_serial",
+               nbins,
+               static_cast<long>(ntoys),
+               wall_ms,
+               "toys_per_second",
+               ntoys / (wall_ms * 1.0e-3),
+               sum / ntoys);
+  }
+
+  // Parallel toy generation; the toys are the same as the serial ones.
+  double const start = pfc::now_in_milliseconds();
+  auto const toys = pfc::generate_poisson_toys(expected, seed, 0, ntoys);
+  double const wall_ms = pfc::now_in_milliseconds() - start;
+  double sum = 0.0;
+  for (auto const& toy : toys)
+    sum += toy.counts().front();
+  print_line("toys_parallel_" +
+               std::to_string(oneapi::tbb::info::default_concurrency()),
+             nbins,
+             static_cast<long>(ntoys),
+             wall_ms,
+             "toys_per_second",
+             ntoys / (wall_ms * 1.0e-3),
+             sum / ntoys);
+
+  time_m2lnl<pfc::fastmath::libm_math>("m2lnl_libm", expected, toys);
+  time_m2lnl<pfc::fastmath::fast_math>("m2lnl_fast", expected, toys);
+}
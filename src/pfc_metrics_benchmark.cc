@@ -0,0 +1,103 @@
+#include "geometry.hh"
+#include "metrics.hh"
+#include "minimizers.hh"
+#include "rastrigin.hh"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+// This program measures the cost of the live metrics of metrics.hh. It runs
+// the same multistart search of the 5-dimensional Rastrigin function
+// (starting points in [-10, 10]^5, every attempt made) several times without
+// metrics, and with metered_minimizer recording into a search_metrics that a
+// metrics_publisher samples every 100 ms, publishing to a file and to a TCP
+// port of the loopback interface.
+//
+// The optional arguments are the number of attempts per search (default
+// 20000), the number of runs of each kind (default 5), and the file to which
+// the metrics are written (default pfc_metrics.prom). The TCP port is
+// written on standard error; the median wall times are written as
+// tab-separated values on standard output.
+
+namespace {
+
+  double
+  median(std::vector<double> v)
+  {
+    std::sort(v.begin(), v.end());
+    return v[v.size() / 2];
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 4) {
+    std::cerr
+      << "Usage: pfc_metrics_benchmark [max_attempts [nruns [metrics_file]]]\n";
+    return 1;
+  }
+  long const max_attempts = (argc > 1) ? std::stol(argv[1]) : 20000;
+  int const nruns = (argc > 2) ? std::stoi(argv[2]) : 5;
+  std::string const file = (argc > 3) ? argv[3] : "pfc_metrics.prom";
+
+  auto const volume = pfc::make_box_in_n_dim(5, -10.0, 10.0);
+  pfc::search_config config;
+  config.max_attempts = max_attempts;
+  double const never = -std::numeric_limits<double>::infinity();
+
+  // The plain search wraps bfgs_minimizer too, so that both searches take
+  // the same (dynamic-size) path through find_global_minimum.
+  auto run_plain = [&]() {
+    double const start = pfc::now_in_milliseconds();
+    pfc::find_global_minimum(pfc::rastrigin_dlib,
+                             volume,
+                             never,
+                             config,
+                             [](auto const& f, auto const& x, auto const& r) {
+                               return pfc::bfgs_minimizer()(f, x, r);
+                             });
+    return pfc::now_in_milliseconds() - start;
+  };
+  auto run_metered = [&](int r) {
+    pfc::search_metrics metrics;
+    pfc::metrics_publisher_config publishing;
+    publishing.period = std::chrono::milliseconds(100);
+    publishing.file = file;
+    publishing.tcp_port = 0;
+    pfc::metrics_publisher publisher(metrics, publishing);
+    if (r == 0)
+      std::cerr << "Serving metrics on port " << publisher.tcp_port() << '\n';
+    double const start = pfc::now_in_milliseconds();
+    pfc::find_global_minimum(pfc::rastrigin_dlib,
+                             volume,
+                             never,
+                             config,
+                             pfc::metered_minimizer{&metrics});
+    return pfc::now_in_milliseconds() - start;
+  };
+
+  // The order of the two kinds of run alternates, so that neither always
+  // follows the other.
+  std::vector<double> plain;
+  std::vector<double> metered;
+  for (int r = 0; r != nruns; ++r) {
+    if (r % 2 == 0) {
+      plain.push_back(run_plain());
+      metered.push_back(run_metered(r));
+    } else {
+      metered.push_back(run_metered(r));
+      plain.push_back(run_plain());
+    }
+  }
+
+  double const plain_ms = median(plain);
+  double const metered_ms = median(metered);
+  std::cout << "attempts\truns\tplain_ms\tmetered_ms\toverhead_percent\n"
+            << max_attempts << '\t' << nruns << '\t' << plain_ms << '\t'
+            << metered_ms << '\t' << 100.0 * (metered_ms / plain_ms - 1.0)
+            << '\n';
+}
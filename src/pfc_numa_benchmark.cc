@@ -0,0 +1,221 @@
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "numa_minimizer.hh"
+
+#include "tbb/info.h"
+#include "tbb/task_scheduler_observer.h"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// This program compares find_global_minimum, which runs in the default TBB
+// arena, with find_global_minimum_numa, which uses one arena per NUMA node
+// with node-local copies of the objective and its data.
+//
+// The objective is a least-squares fit of a quadratic to a large dataset, so
+// that every function call streams through memory; this is the situation in
+// which remote-memory traffic matters. For each run we report the throughput
+// (local minimizations per millisecond) and, on Linux, the number of
+// last-level cache read misses that were served by a remote NUMA node, as
+// counted by the hardware performance counters. If the counters are not
+// available (e.g. because of perf_event_paranoid, or on other platforms)
+// that column is NA.
+//
+// The output is tab-separated values with a header line, on standard output.
+
+namespace {
+
+  // A least-squares objective with a dataset that is large compared to the
+  // caches.
+  class quadratic_fit {
+  public:
+    explicit quadratic_fit(std::size_t npoints) : x_(npoints), y_(npoints)
+    {
+      std::mt19937 engine(12345);
+      std::normal_distribution<double> noise(0.0, 0.1);
+      for (std::size_t i = 0; i != npoints; ++i) {
+        x_[i] = static_cast<double>(i) / npoints;
+        y_[i] = 1.0 - 2.0 * x_[i] + 3.0 * x_[i] * x_[i] + noise(engine);
+      }
+    }
+
+    double
+    operator()(pfc::column_vector const& p) const
+    {
+      double sum = 0.0;
+      for (std::size_t i = 0; i != x_.size(); ++i) {
+        double const x = x_[i];
+        double const r = y_[i] - (p(0) + p(1) * x + p(2) * x * x);
+        sum += r * r;
+      }
+      return sum / x_.size();
+    }
+
+  private:
+    std::vector<double> x_;
+    std::vector<double> y_;
+  };
+
+#ifdef __linux__
+  // remote_miss_counter opens, for every thread that joins any TBB arena
+  // (and for the thread that creates it), a hardware counter of cache read
+  // misses served by a remote NUMA node. total() sums the counts of all the
+  // threads.
+  class remote_miss_counter : public oneapi::tbb::task_scheduler_observer {
+  public:
+    remote_miss_counter()
+    {
+      open_for_this_thread();
+      observe(true);
+    }
+
+    ~remote_miss_counter() override
+    {
+      observe(false);
+      for (int fd : fds_)
+        close(fd);
+    }
+
+    void
+    on_scheduler_entry(bool) override
+    {
+      open_for_this_thread();
+    }
+
+    bool
+    available() const
+    {
+      std::scoped_lock lock(m_);
+      return !fds_.empty();
+    }
+
+    double
+    total() const
+    {
+      std::scoped_lock lock(m_);
+      if (fds_.empty())
+        return std::numeric_limits<double>::quiet_NaN();
+      double sum = 0.0;
+      for (int fd : fds_) {
+        std::uint64_t count = 0;
+        if (read(fd, &count, sizeof(count)) == sizeof(count))
+          sum += count;
+      }
+      return sum;
+    }
+
+  private:
+    void
+    open_for_this_thread()
+    {
+      thread_local bool opened = false;
+      if (opened)
+        return;
+      opened = true;
+
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_NODE |
+                    (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      // pid == 0 and cpu == -1 means: this thread, on any CPU.
+      int const fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+      if (fd < 0)
+        return;
+      std::scoped_lock lock(m_);
+      fds_.push_back(fd);
+    }
+
+    std::mutex mutable m_;
+    std::vector<int> fds_;
+  };
+#else
+  class remote_miss_counter {
+  public:
+    bool
+    available() const
+    {
+      return false;
+    }
+    double
+    total() const
+    {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+  };
+#endif
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 4) {
+    std::cerr
+      << "Usage: pfc_numa_benchmark [npoints] [attempts] [repetitions]\n";
+    return 1;
+  }
+  std::size_t const npoints = (argc > 1) ? std::stoul(argv[1]) : (1UL << 20);
+  long const max_attempts = (argc > 2) ? std::stol(argv[2]) : 200;
+  int const repetitions = (argc > 3) ? std::stoi(argv[3]) : 5;
+
+  // The counter must be created before TBB starts any worker threads, so
+  // that it observes all of them.
+  remote_miss_counter counter;
+  if (!counter.available())
+    std::cerr << "Hardware counters are not available; remote_misses will be "
+                 "reported as NA\n";
+
+  std::cerr << "This machine has " << oneapi::tbb::info::numa_nodes().size()
+            << " NUMA node(s) and "
+            << oneapi::tbb::info::default_concurrency() << " threads\n";
+
+  quadratic_fit const objective(npoints);
+  auto const volume = pfc::make_box_in_n_dim(3, -10.0, 10.0);
+  int const num_results = oneapi::tbb::info::default_concurrency();
+  // A desired minimum that can never be reached makes every run do exactly
+  // the same amount of work.
+  double const never = -std::numeric_limits<double>::infinity();
+
+  std::cout << "mode\trep\tattempts\twall\tthroughput\tremote_misses\n";
+  for (std::string const mode : {"default", "numa"}) {
+    for (int rep = 0; rep != repetitions; ++rep) {
+      double const misses_before = counter.total();
+      double const start = pfc::now_in_milliseconds();
+      pfc::minimization_results results;
+      if (mode == "default") {
+        results = pfc::find_global_minimum(
+          objective, 3, volume, num_results, never, max_attempts);
+      } else {
+        results = pfc::find_global_minimum_numa(
+          objective, volume, num_results, never, max_attempts);
+      }
+      double const stop = pfc::now_in_milliseconds();
+      double const misses = counter.total() - misses_before;
+      double const wall = stop - start;
+
+      std::cout << mode << '\t' << rep << '\t' << results.num_attempts << '\t'
+                << wall << '\t' << results.num_attempts / wall << '\t';
+      if (std::isnan(misses))
+        std::cout << "NA";
+      else
+        std::cout << misses;
+      std::cout << '\n';
+    }
+  }
+}
@@ -0,0 +1,103 @@
+#include "geometry.hh"
+#include "helical_valley.hh"
+#include "minimizers.hh"
+#include "population.hh"
+#include "rastrigin.hh"
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+
+// This program compares the population-based searches of population.hh,
+// minimize_cmaes (with BIPOP restarts) and minimize_de, with the multistart
+// search of find_global_minimum, on the Rastrigin function in 5, 10 and 20
+// dimensions (starting points in [-5, 5]^n), and on the helical valley
+// function (starting points in [-10, 10]^3). Each search stops when a value
+// below 1e-6 is found, or when its budget is used up.
+//
+// The optional arguments are the maximum number of function calls for the
+// population-based searches (default 1000000), and the maximum number of
+// local minimizations for the multistart search (default 10000). The output
+// is tab-separated values with a header line, on standard output.
+
+namespace {
+
+  // counted wraps a function, counting its calls.
+  struct counted {
+    std::function<double(pfc::column_vector const&)> func;
+    std::atomic<long> mutable ncalls = 0;
+
+    double
+    operator()(pfc::column_vector const& x) const
+    {
+      ncalls.fetch_add(1, std::memory_order_relaxed);
+      return func(x);
+    }
+  };
+
+  double const tolerance = 1.0e-6;
+
+  template <typename SEARCH>
+  void
+  run(std::string const& function_name,
+      std::function<double(pfc::column_vector const&)> const& func,
+      pfc::region<pfc::column_vector> const& bounds,
+      std::string const& method,
+      SEARCH search)
+  {
+    counted f{func};
+    double const start = pfc::now_in_milliseconds();
+    auto [solutions, num_attempts] = search(f, bounds);
+    double const wall_ms = pfc::now_in_milliseconds() - start;
+    double best = std::numeric_limits<double>::infinity();
+    for (auto const& s : solutions)
+      best = std::min(best, s.value);
+    std::cout << function_name << '\t' << bounds.ndims() << '\t' << method
+              << '\t' << (best < tolerance) << '\t' << best << '\t'
+              << f.ncalls.load() << '\t' << wall_ms << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 3) {
+    std::cerr
+      << "Usage: pfc_population_benchmark [max_evaluations [max_attempts]]\n";
+    return 1;
+  }
+  long const max_evaluations = (argc > 1) ? std::stol(argv[1]) : 1000000;
+  long const max_attempts = (argc > 2) ? std::stol(argv[2]) : 10000;
+
+  pfc::search_config multistart;
+  multistart.max_attempts = max_attempts;
+  pfc::cmaes_config cmaes;
+  cmaes.max_evaluations = max_evaluations;
+  pfc::de_config de;
+  de.max_evaluations = max_evaluations;
+
+  auto compare = [&](std::string const& name,
+                     std::function<double(pfc::column_vector const&)> func,
+                     pfc::region<pfc::column_vector> const& bounds) {
+    run(name, func, bounds, "multistart", [&](auto& f, auto const& b) {
+      return pfc::find_global_minimum(f, b, tolerance, multistart);
+    });
+    run(name, func, bounds, "cmaes", [&](auto& f, auto const& b) {
+      return pfc::minimize_cmaes(f, b, tolerance, cmaes);
+    });
+    run(name, func, bounds, "de", [&](auto& f, auto const& b) {
+      return pfc::minimize_de(f, b, tolerance, de);
+    });
+  };
+
+  std::cout << "function\tndim\tmethod\tconverged\tbest\tcalls\twall_ms\n";
+  for (int ndim : {5, 10, 20})
+    compare("rastrigin",
+            pfc::rastrigin_dlib,
+            pfc::make_box_in_n_dim(ndim, -5.0, 5.0));
+  compare("helical_valley",
+          pfc::helical_valley,
+          pfc::make_box_in_n_dim(3, -10.0, 10.0));
+}
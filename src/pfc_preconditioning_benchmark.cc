@@ -0,0 +1,131 @@
+#include "benchmark.hh"
+#include "geometry.hh"
+#include "helical_valley.hh"
+#include "minimizers.hh"
+#include "rosenbrock.hh"
+#include "scaled_minimizer.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// This program measures the effect of scaled_minimizer on badly scaled
+// problems. For each problem, it does the same set of local minimizations
+// (from the same random starting points) with bfgs_minimizer and with
+// scaled_minimizer<bfgs_minimizer>, and reports the number of successes (a
+// value less than 1e-6), and the medians of the number of steps, the number
+// of function calls and the value reached.
+//
+// The problems are:
+//   helical_valley   the helical valley, with starting points in a box of
+//                    half-width 1e6, while the minimum is at unit scale.
+//   scaled_rosenbrock  the 4-dimensional Rosenbrock function with its
+//                    coordinates scaled by 1, 1e3, 1e-3 and 1e2, with
+//                    starting points in the correspondingly scaled box.
+//
+// The output is tab-separated values with a header line, on standard output.
+
+namespace {
+
+  double const SUCCESS = 1.0e-6;
+
+  // Rosenbrock's function, of coordinates that have very different scales.
+  struct scaled_rosenbrock {
+    pfc::column_vector scales;
+
+    double
+    operator()(pfc::column_vector const& x) const
+    {
+      pfc::column_vector const y = dlib::pointwise_multiply(x, scales);
+      std::span yy = y;
+      return pfc::vec_rosenbrock(yy);
+    }
+  };
+
+  template <typename FUNC, typename LOCAL>
+  void
+  run(std::string const& problem,
+      std::string const& method,
+      FUNC const& f,
+      std::vector<pfc::column_vector> const& starts,
+      LOCAL local_minimizer)
+  {
+    long ncalls = 0;
+    auto counted = [&f, &ncalls](pfc::column_vector const& x) {
+      ++ncalls;
+      return f(x);
+    };
+    // No budget, and nothing to stop for; the shared_result is only needed
+    // by the policy interface.
+    pfc::shared_result solutions(-std::numeric_limits<double>::infinity(), 1);
+
+    std::vector<double> nsteps;
+    std::vector<double> calls;
+    std::vector<double> values;
+    int successes = 0;
+    for (auto const& start : starts) {
+      ncalls = 0;
+      auto const s = local_minimizer(counted, start, solutions);
+      nsteps.push_back(s.nsteps);
+      calls.push_back(ncalls);
+      values.push_back(s.value);
+      if (s.value < SUCCESS)
+        ++successes;
+    }
+    std::cout << problem << '\t' << method << '\t' << starts.size() << '\t'
+              << successes << '\t' << pfc::median(nsteps) << '\t'
+              << pfc::median(calls) << '\t' << pfc::median(values) << '\n';
+  }
+
+  template <typename FUNC>
+  void
+  compare(std::string const& problem,
+          FUNC const& f,
+          pfc::region<pfc::column_vector> const& volume,
+          int nstarts,
+          std::mt19937& engine)
+  {
+    std::vector<pfc::column_vector> starts;
+    for (int i = 0; i != nstarts; ++i)
+      starts.push_back(pfc::random_point_within(volume, engine));
+    run(problem, "bfgs", f, starts, pfc::bfgs_minimizer());
+    run(problem, "scaled_bfgs", f, starts, pfc::scaled_minimizer(volume));
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 2) {
+    std::cerr << "Usage: pfc_preconditioning_benchmark [nstarts]\n";
+    return 1;
+  }
+  int const nstarts = (argc > 1) ? std::stoi(argv[1]) : 50;
+  std::mt19937 engine(12345);
+
+  std::cout << "problem\tmethod\tstarts\tsuccesses\tmedian_nsteps\t"
+               "median_calls\tmedian_value\n";
+
+  compare("helical_valley",
+          pfc::helical_valley,
+          pfc::make_box_in_n_dim(3, -1.0e6, 1.0e6),
+          nstarts,
+          engine);
+
+  pfc::column_vector const scales({1.0, 1.0e3, 1.0e-3, 1.0e2});
+  auto const unscaled_volume = pfc::make_box_in_n_dim(4, -2.0, 2.0);
+  pfc::region<pfc::column_vector> const rosenbrock_volume(
+    dlib::pointwise_divide(unscaled_volume.lower(), scales),
+    dlib::pointwise_divide(unscaled_volume.upper(), scales));
+  compare("scaled_rosenbrock",
+          scaled_rosenbrock{scales},
+          rosenbrock_volume,
+          nstarts,
+          engine);
+}
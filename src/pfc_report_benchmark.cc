@@ -0,0 +1,81 @@
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "report_writer.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "tbb/task_arena.h" // for default_concurrency()
+
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// This program compares the time to write a report of many solutions with
+// print_report, through an std::ofstream, and with write_report (in
+// report_writer.hh), which formats chunks of solutions in parallel and
+// writes each with one write(2). The solutions are random, in 5 dimensions.
+//
+// The optional arguments are the number of solutions (default 1000000) and
+// the file to write (default /dev/null, which measures only the
+// formatting). The output is tab-separated values with a header line, on
+// standard output.
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 3) {
+    std::cerr << "Usage: pfc_report_benchmark [nsolutions [output_file]]\n";
+    return 1;
+  }
+  std::size_t const nsolutions = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+  std::string const path = (argc > 2) ? argv[2] : "/dev/null";
+
+  auto const volume = pfc::make_box_in_n_dim(5, -10.0, 10.0);
+  std::mt19937 engine(42);
+  std::uniform_real_distribution<double> flat(0.0, 100.0);
+  std::vector<pfc::solution> results(nsolutions);
+  for (std::size_t i = 0; i != nsolutions; ++i) {
+    pfc::solution& s = results[i];
+    s.start = pfc::random_point_within(volume, engine);
+    s.location = pfc::random_point_within(volume, engine);
+    s.index = static_cast<long>(i);
+    s.start_value = flat(engine);
+    s.value = flat(engine);
+    s.tstart = pfc::now_in_milliseconds();
+    s.tstop = s.tstart + flat(engine);
+    s.nsteps = 100;
+  }
+
+  std::cout << "writer\tthreads\tsolutions\twall_ms\tsolutions_per_second\n";
+  auto report = [&](std::string const& writer, int threads, double wall_ms) {
+    std::cout << writer << '\t' << threads << '\t' << nsolutions << '\t'
+              << wall_ms << '\t' << nsolutions / (wall_ms * 1.0e-3) << '\n';
+  };
+
+  {
+    double const start = pfc::now_in_milliseconds();
+    std::ofstream out(path);
+    pfc::print_report(results, out);
+    out.close();
+    report("print_report", 1, pfc::now_in_milliseconds() - start);
+  }
+
+  {
+    double const start = pfc::now_in_milliseconds();
+    int const fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      std::cerr << "Unable to open " << path << '\n';
+      return 1;
+    }
+    pfc::write_report(results, fd);
+    ::close(fd);
+    report("write_report",
+           oneapi::tbb::info::default_concurrency(),
+           pfc::now_in_milliseconds() - start);
+  }
+}
@@ -0,0 +1,183 @@
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "protected_engine.hh"
+#include "rastrigin.hh"
+#include "shared_result.hh"
+
+#include "tbb/global_control.h"
+#include "tbb/task_arena.h" // for default_concurrency()
+
+#include <cmath>
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// This program measures the strong and weak scaling of the multistart
+// minimization done by find_global_minimum (runtime-sized vectors) and
+// find_global_minimum_fixed (compile-time-sized vectors). The number of
+// threads TBB may use is limited with tbb::global_control, from 1 up to all
+// the cores of the machine.
+//
+// Three kinds of run are done for each engine and thread count:
+//
+//   strong: a fixed total number of local minimizations, independent of the
+//           number of threads. The search never stops early.
+//   weak:   a number of local minimizations proportional to the number of
+//           threads. The search never stops early.
+//   solve:  the search stops as soon as a solution with a value less than
+//           the tolerance is found; this measures time-to-solution.
+//
+// The results are written to standard output as tab-separated values with a
+// header line, suitable for reading with data.table::fread in the R tools in
+// docs/. Times are in milliseconds. Efficiency is T(1)/(n*T(n)) for strong
+// and solve runs, and T(1)/T(n) for weak runs. 'first_success' is the time
+// from the start of the run until the first solution with value less than
+// the tolerance was found, or NA if there was none.
+
+namespace {
+
+  int const NDIM = 5;
+
+  inline double
+  rastrigin_fixed_wrapper(pfc::fixed_vector<NDIM> const& x)
+  {
+    std::span xx = x;
+    return pfc::rastrigin(xx);
+  }
+
+  struct scaling_measurement {
+    long num_attempts = 0;
+    double wall_ms = 0.0;
+    double lock_wait_ms = 0.0;
+    double first_success_ms = std::numeric_limits<double>::quiet_NaN();
+  };
+
+  // Run one search, using the engine named by 'engine_name', and collect the
+  // statistics. If 'stop_on_success' is false, the search runs all of
+  // 'max_attempts' local minimizations.
+  scaling_measurement
+  run_one(std::string const& engine_name,
+          int nthreads,
+          long max_attempts,
+          double tolerance,
+          bool stop_on_success)
+  {
+    double const desired_min =
+      stop_on_success ? tolerance : -std::numeric_limits<double>::infinity();
+    pfc::shared_result solutions(desired_min, nthreads);
+    pfc::protected_engine<std::mt19937> engine(std::time(0));
+
+    double const start = pfc::now_in_milliseconds();
+    if (engine_name == "dynamic") {
+      auto volume = pfc::make_box_in_n_dim(NDIM, -10.0, 10.0);
+      pfc::run_parallel_minimizers(pfc::rastrigin_dlib,
+                                   volume,
+                                   solutions,
+                                   engine,
+                                   nthreads,
+                                   max_attempts);
+    } else {
+      auto volume = pfc::make_box_in_dim<NDIM>(-10.0, 10.0);
+      pfc::run_parallel_minimizers(rastrigin_fixed_wrapper,
+                                   volume,
+                                   solutions,
+                                   engine,
+                                   nthreads,
+                                   max_attempts);
+    }
+    double const stop = pfc::now_in_milliseconds();
+
+    scaling_measurement result;
+    result.num_attempts = solutions.num_attempts();
+    result.wall_ms = stop - start;
+    result.lock_wait_ms = solutions.lock_wait_ms() + engine.lock_wait_ms();
+    if (stop_on_success)
+      result.first_success_ms = solutions.first_success_time() - start;
+    return result;
+  }
+
+  void
+  print_header(std::ostream& os)
+  {
+    os << "engine\tmode\tthreads\tattempts\twall\tthroughput\tefficiency"
+          "\tlock_wait\tfirst_success\n";
+  }
+
+  void
+  print_row(std::ostream& os,
+            std::string const& engine_name,
+            std::string const& mode,
+            int nthreads,
+            scaling_measurement const& m,
+            double efficiency)
+  {
+    os << engine_name << '\t' << mode << '\t' << nthreads << '\t'
+       << m.num_attempts << '\t' << m.wall_ms << '\t'
+       << m.num_attempts / m.wall_ms << '\t' << efficiency << '\t'
+       << m.lock_wait_ms << '\t';
+    if (std::isnan(m.first_success_ms))
+      os << "NA";
+    else
+      os << m.first_success_ms;
+    os << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 4) {
+    std::cerr << "Usage: pfc_scaling [strong_attempts]"
+                 " [weak_attempts_per_thread] [tolerance]\n";
+    return 1;
+  }
+  long const strong_attempts = (argc > 1) ? std::stol(argv[1]) : 2000;
+  long const weak_attempts = (argc > 2) ? std::stol(argv[2]) : 200;
+  double const tolerance = (argc > 3) ? std::stod(argv[3]) : 1.0e-6;
+  long const solve_max_attempts = 1000 * 1000;
+
+  int const max_threads = oneapi::tbb::info::default_concurrency();
+  std::cerr << "Measuring scaling for 1 to " << max_threads << " threads\n";
+
+  print_header(std::cout);
+  for (std::string const engine_name : {"dynamic", "fixed"}) {
+    double strong_t1 = 0.0;
+    double weak_t1 = 0.0;
+    double solve_t1 = 0.0;
+    for (int nthreads = 1; nthreads <= max_threads; ++nthreads) {
+      oneapi::tbb::global_control limit(
+        oneapi::tbb::global_control::max_allowed_parallelism, nthreads);
+      std::cerr << engine_name << ": " << nthreads << " threads\n";
+
+      auto strong =
+        run_one(engine_name, nthreads, strong_attempts, tolerance, false);
+      auto weak = run_one(
+        engine_name, nthreads, weak_attempts * nthreads, tolerance, false);
+      auto solve =
+        run_one(engine_name, nthreads, solve_max_attempts, tolerance, true);
+      if (nthreads == 1) {
+        strong_t1 = strong.wall_ms;
+        weak_t1 = weak.wall_ms;
+        solve_t1 = solve.wall_ms;
+      }
+      print_row(std::cout,
+                engine_name,
+                "strong",
+                nthreads,
+                strong,
+                strong_t1 / (nthreads * strong.wall_ms));
+      print_row(
+        std::cout, engine_name, "weak", nthreads, weak, weak_t1 / weak.wall_ms);
+      print_row(std::cout,
+                engine_name,
+                "solve",
+                nthreads,
+                solve,
+                solve_t1 / (nthreads * solve.wall_ms));
+    }
+  }
+}
@@ -0,0 +1,231 @@
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "rastrigin.hh"
+#include "shard_queue.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "tbb/parallel_for.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// This program demonstrates sharded execution of many minimizations by
+// several processes. It has two modes:
+//
+//   pfc_sharded coordinator <dir> <nworkers> [ngrid] [attempts] [nshards]
+//   pfc_sharded worker <dir>
+//
+// The coordinator creates a shard_queue in <dir> with 'ngrid' grid points,
+// each of which gets 'attempts' local minimizations split into 'nshards'
+// shards. It then starts 'nworkers' local worker processes, and waits until
+// all shards are complete. Shards held by a local worker that dies, or by
+// any worker (possibly on another machine) whose heartbeat is older than
+// HEARTBEAT_TIMEOUT, are put back in the queue, and dead local workers are
+// replaced. Finally the coordinator merges the results and prints the best
+// solutions for each grid point.
+//
+// A coordinator can be started with zero local workers, and workers started
+// on other machines sharing the filesystem that holds <dir>.
+//
+// The function minimized for grid point g is the 2-dimensional Rastrigin
+// function with its global minimum moved to (g/10, 0); in a real analysis,
+// it would be the likelihood at the grid point.
+
+namespace {
+
+  long const NDIM = 2;
+  std::size_t const MAX_RESULTS = 10;
+  std::chrono::seconds const HEARTBEAT_TIMEOUT(60);
+  std::chrono::milliseconds const POLL_INTERVAL(200);
+
+  struct shifted_rastrigin {
+    double shift;
+
+    double
+    operator()(pfc::column_vector const& x) const
+    {
+      pfc::column_vector y = x;
+      y(0) -= shift;
+      std::span yy = y;
+      return pfc::rastrigin(yy);
+    }
+  };
+
+  int
+  run_worker(std::filesystem::path const& dir)
+  {
+    pfc::shard_queue queue(dir);
+    auto const worker = pfc::shard_queue::this_worker_name();
+    auto const volume = pfc::make_box_in_n_dim(NDIM, -10.0, 10.0);
+    // We never stop early; each shard does all its attempts.
+    double const never = -std::numeric_limits<double>::infinity();
+
+    while (!std::filesystem::exists(dir / "manifest"))
+      std::this_thread::sleep_for(POLL_INTERVAL);
+
+    while (!queue.is_done()) {
+      auto s = queue.claim(worker);
+      if (!s) {
+        // Other workers may yet die and have their shards requeued, so we
+        // wait until the coordinator says we are done.
+        std::this_thread::sleep_for(POLL_INTERVAL);
+        continue;
+      }
+      shifted_rastrigin const objective{s->grid_point / 10.0};
+      // We do the shard's attempts in several chunks, streaming the results
+      // of each chunk back (which also serves as a heartbeat). Each attempt
+      // seeds its own engine from the shard id and the attempt number,
+      // rather than from the time, so that workers started at the same
+      // moment do not repeat each other's work, and so that the starting
+      // points of a requeued shard do not depend on how its attempts are
+      // scheduled among the threads.
+      long const nchunks = 10;
+      long const chunk = std::max(1L, s->num_attempts / nchunks);
+      // If we are so slow that the coordinator has given the shard to
+      // another worker, we abandon it.
+      bool abandoned = false;
+      for (long done = 0; done < s->num_attempts && !abandoned;
+           done += chunk) {
+        long const last = std::min(done + chunk, s->num_attempts);
+        // Each chunk keeps the best MAX_RESULTS solutions, which are all
+        // that the coordinator can keep of them, whatever the number of
+        // threads of this worker.
+        pfc::shared_result solutions(never, MAX_RESULTS);
+        oneapi::tbb::parallel_for(done, last, [&](long attempt) {
+          std::seed_seq seeds{static_cast<unsigned>(s->id),
+                              static_cast<unsigned>(attempt)};
+          std::mt19937 engine(seeds);
+          auto const start = pfc::random_point_within(volume, engine);
+          solutions.insert(pfc::bfgs_minimizer()(objective, start, solutions));
+        });
+        abandoned = !queue.append_results(*s, worker, solutions.solutions());
+      }
+      if (!abandoned)
+        queue.complete(*s, worker);
+    }
+    return 0;
+  }
+
+  pid_t
+  start_worker(char const* program, std::filesystem::path const& dir)
+  {
+    pid_t const pid = fork();
+    if (pid == 0) {
+      execl(program, program, "worker", dir.c_str(), nullptr);
+      // We only get here if exec failed.
+      _exit(127);
+    }
+    return pid;
+  }
+
+  int
+  run_coordinator(char const* program,
+                  std::filesystem::path const& dir,
+                  int nworkers,
+                  long ngrid,
+                  long attempts,
+                  long nshards)
+  {
+    if (std::filesystem::exists(dir)) {
+      std::cerr << "The queue directory " << dir << " already exists\n";
+      return 1;
+    }
+    std::vector<pfc::shard> shards;
+    for (long g = 0; g != ngrid; ++g) {
+      for (long i = 0; i != nshards; ++i) {
+        pfc::shard s;
+        s.id = shards.size();
+        s.grid_point = g;
+        s.num_attempts = attempts / nshards + (i < attempts % nshards);
+        shards.push_back(s);
+      }
+    }
+    pfc::shard_queue queue(dir);
+    queue.create(shards, NDIM);
+
+    // Worker names are the host name and process id; for the local workers
+    // we know the host name is our own.
+    auto const host_prefix = [] {
+      auto const name = pfc::shard_queue::this_worker_name();
+      return name.substr(0, name.rfind('-') + 1);
+    }();
+    std::map<pid_t, std::string> workers;
+    for (int i = 0; i != nworkers; ++i) {
+      pid_t const pid = start_worker(program, dir);
+      workers[pid] = host_prefix + std::to_string(pid);
+    }
+
+    auto const start = pfc::now_in_milliseconds();
+    while (queue.num_complete() < queue.num_shards()) {
+      std::this_thread::sleep_for(POLL_INTERVAL);
+      int status = 0;
+      pid_t pid = 0;
+      while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        auto const n = queue.requeue_worker(workers[pid]);
+        std::cerr << "Worker " << workers[pid] << " exited; requeued " << n
+                  << " shard(s)\n";
+        workers.erase(pid);
+        if (queue.num_complete() < queue.num_shards()) {
+          pid_t const replacement = start_worker(program, dir);
+          workers[replacement] = host_prefix + std::to_string(replacement);
+        }
+      }
+      auto const nstale = queue.requeue_stale(HEARTBEAT_TIMEOUT);
+      if (nstale != 0)
+        std::cerr << "Requeued " << nstale << " stale shard(s)\n";
+    }
+    queue.mark_done();
+    for (auto const& [pid, name] : workers)
+      waitpid(pid, nullptr, 0);
+    auto const stop = pfc::now_in_milliseconds();
+    std::cerr << queue.num_shards() << " shards were completed in "
+              << stop - start << " milliseconds\n";
+
+    auto const merged = queue.merged_results(MAX_RESULTS);
+    std::cout << "grid\tidx\ttstart\t";
+    for (long i = 0; i != NDIM; ++i)
+      std::cout << 's' << i << '\t';
+    std::cout << "fs\ttstop\t";
+    for (long i = 0; i != NDIM; ++i)
+      std::cout << 'x' << i << '\t';
+    std::cout << "min\tdist\tnsteps\n";
+    for (auto const& [grid_point, solutions] : merged) {
+      for (auto const& sol : solutions)
+        std::cout << grid_point << '\t' << sol << '\n';
+    }
+    return 0;
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  std::vector<std::string> args(argv + 1, argv + argc);
+  if (args.size() == 2 && args[0] == "worker")
+    return run_worker(args[1]);
+  if (args.size() >= 3 && args.size() <= 6 && args[0] == "coordinator") {
+    int const nworkers = std::stoi(args[2]);
+    long const ngrid = (args.size() > 3) ? std::stol(args[3]) : 10;
+    long const attempts = (args.size() > 4) ? std::stol(args[4]) : 1000;
+    long const nshards = (args.size() > 5) ? std::stol(args[5]) : 4;
+    return run_coordinator(
+      argv[0], args[1], nworkers, ngrid, attempts, nshards);
+  }
+  std::cerr << "Usage:\n"
+               "  pfc_sharded coordinator <dir> <nworkers> [ngrid] "
+               "[attempts] [nshards]\n"
+               "  pfc_sharded worker <dir>\n";
+  return 1;
+}
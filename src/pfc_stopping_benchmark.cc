@@ -0,0 +1,129 @@
+#include "geometry.hh"
+#include "minima_catalog.hh"
+#include "minimizers.hh"
+#include "protected_engine.hh"
+#include "rastrigin.hh"
+#include "rosenbrock.hh"
+#include "shared_result.hh"
+
+#include "tbb/task_arena.h" // for default_concurrency()
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <utility>
+
+// This program measures how many local minimizations the unseen-minima
+// stopping rules of shared_result save, compared to running a fixed number
+// of them. For each problem and each fixed budget of attempts, it does one
+// search that uses the whole budget, and one search for each estimator
+// (see minima_catalog.hh) that stops when fewer than 0.5 minima are
+// expected to be unseen, once at least 100 attempts have been made, or when
+// the budget is used up. Neither search knows the value of the global
+// minimum.
+//
+// The problems are:
+//   rastrigin_1d  the Rastrigin function on [-2.5, 2.5], with 5 minima in
+//                 the box, and a few more outside it that local
+//                 minimizations can reach.
+//   rastrigin_2d  the Rastrigin function on [-2.5, 2.5]^2, with 25 minima in
+//                 the box, and many more outside it.
+//   rosenbrock_2d  Rosenbrock's function on [-2, 2]^2, with one minimum.
+//
+// The output is tab-separated values with a header line, on standard output.
+
+namespace {
+
+  struct rosenbrock_dlib_wrapper {
+    double
+    operator()(pfc::column_vector const& x) const
+    {
+      std::span xx = x;
+      return pfc::vec_rosenbrock(xx);
+    }
+  };
+
+  struct search_summary {
+    long attempts = 0;
+    long minima_found = 0;
+    double best = 0.0;
+  };
+
+  // Do one search of at most 'budget' attempts, using the given estimator
+  // to stop early if 'use_rule' is true.
+  template <typename FUNC>
+  search_summary
+  search(FUNC& f,
+         pfc::region<pfc::column_vector> const& volume,
+         long budget,
+         bool use_rule,
+         pfc::unseen_minima_estimator estimator)
+  {
+    int const num_tasks = oneapi::tbb::info::default_concurrency();
+    pfc::shared_result solutions(-std::numeric_limits<double>::infinity(),
+                                 num_tasks);
+    solutions.enable_minima_catalog(0.1, 10000);
+    if (use_rule)
+      solutions.set_unseen_minima_stop(estimator, 0.5, 100);
+    pfc::protected_engine<std::mt19937> engine(12345);
+    pfc::run_parallel_minimizers(f,
+                                 volume,
+                                 solutions,
+                                 engine,
+                                 num_tasks,
+                                 budget,
+                                 pfc::bfgs_minimizer());
+    auto const minima = solutions.minima();
+    return {solutions.num_attempts(),
+            static_cast<long>(minima.size()),
+            minima.empty() ? std::numeric_limits<double>::quiet_NaN()
+                           : minima.front().value};
+  }
+
+  template <typename FUNC>
+  void
+  compare(std::string const& problem,
+          FUNC f,
+          pfc::region<pfc::column_vector> const& volume)
+  {
+    using pfc::unseen_minima_estimator;
+    for (long budget : {1000L, 10000L, 100000L}) {
+      auto const fixed = search(
+        f, volume, budget, false, unseen_minima_estimator::boender_rinnooy_kan);
+      for (auto [name, estimator] :
+           {std::pair{"boender_rinnooy_kan",
+                      unseen_minima_estimator::boender_rinnooy_kan},
+            std::pair{"chao1", unseen_minima_estimator::chao1}}) {
+        auto const ruled = search(f, volume, budget, true, estimator);
+        std::cout << problem << '\t' << name << '\t' << budget << '\t'
+                  << ruled.attempts << '\t'
+                  << std::max(0L, budget - ruled.attempts) << '\t'
+                  << ruled.minima_found << '\t' << fixed.minima_found << '\t'
+                  << ruled.best << '\t' << fixed.best << '\n';
+      }
+    }
+  }
+}
+
+int
+main(int argc, char**)
+{
+  if (argc > 1) {
+    std::cerr << "Usage: pfc_stopping_benchmark\n";
+    return 1;
+  }
+  std::cout << "problem\testimator\tbudget\tattempts\tattempts_saved\t"
+               "minima_found\tfixed_minima_found\tbest\tfixed_best\n";
+  compare("rastrigin_1d",
+          pfc::rastrigin_dlib,
+          pfc::make_box_in_n_dim(1, -2.5, 2.5));
+  compare("rastrigin_2d",
+          pfc::rastrigin_dlib,
+          pfc::make_box_in_n_dim(2, -2.5, 2.5));
+  compare("rosenbrock_2d",
+          rosenbrock_dlib_wrapper(),
+          pfc::make_box_in_n_dim(2, -2.0, 2.0));
+}
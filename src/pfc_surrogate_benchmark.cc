@@ -0,0 +1,109 @@
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "rastrigin.hh"
+#include "surrogate.hh"
+
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+// This program compares the number of function calls needed by
+// find_global_minimum, with random starting points, and by
+// find_global_minimum_guided, with starting points chosen by a surrogate
+// model, for functions for which each call is expensive enough that the
+// number of calls is what matters.
+//
+// Each problem is the 2-dimensional Rastrigin function, shifted by a random
+// offset of up to 1 in each coordinate, with starting points in [-5, 5]^2,
+// and stopping when a value below 1e-6 is found or after the given number
+// of attempts.
+//
+// The optional arguments are the number of problems (default 20) and the
+// maximum number of attempts per problem (default 1000). The output is
+// tab-separated values with a header line, on standard output.
+
+namespace {
+
+  // counted_rastrigin counts its calls; the count stands in for the cost of
+  // an expensive function.
+  struct counted_rastrigin {
+    pfc::column_vector shift;
+    std::atomic<long> mutable ncalls = 0;
+
+    double
+    operator()(pfc::column_vector const& x) const
+    {
+      ncalls.fetch_add(1, std::memory_order_relaxed);
+      pfc::column_vector const y = x - shift;
+      std::span yy = y;
+      return pfc::rastrigin(yy);
+    }
+  };
+
+  struct totals {
+    long converged = 0;
+    long attempts = 0;
+    long calls = 0;
+  };
+
+  void
+  print_line(std::string const& method, std::size_t nproblems, totals const& t)
+  {
+    std::cout << method << '\t' << nproblems << '\t' << t.converged << '\t'
+              << t.attempts << '\t' << t.calls << '\t'
+              << static_cast<double>(t.calls) / nproblems << '\n';
+  }
+}
+
+int
+main(int argc, char** argv)
+{
+  if (argc > 3) {
+    std::cerr << "Usage: pfc_surrogate_benchmark [nproblems [max_attempts]]\n";
+    return 1;
+  }
+  std::size_t const nproblems = (argc > 1) ? std::stoul(argv[1]) : 20;
+  long const max_attempts = (argc > 2) ? std::stol(argv[2]) : 1000;
+  double const tolerance = 1.0e-6;
+
+  std::mt19937 engine(12345);
+  std::uniform_real_distribution offset(-1.0, 1.0);
+  std::vector<pfc::column_vector> shifts;
+  for (std::size_t i = 0; i != nproblems; ++i)
+    shifts.push_back(pfc::column_vector({offset(engine), offset(engine)}));
+  auto const volume = pfc::make_box_in_n_dim(2, -5.0, 5.0);
+
+  pfc::search_config config;
+  config.max_attempts = max_attempts;
+
+  std::cout << "method\tproblems\tconverged\tattempts\tcalls\t"
+               "calls_per_problem\n";
+
+  totals random;
+  totals guided;
+  for (auto const& shift : shifts) {
+    {
+      counted_rastrigin func{shift};
+      auto [solutions, num_attempts] =
+        pfc::find_global_minimum(func, volume, tolerance, config);
+      random.attempts += num_attempts;
+      random.calls += func.ncalls.load();
+      if (!solutions.empty() && solutions.front().value < tolerance)
+        random.converged += 1;
+    }
+    {
+      counted_rastrigin func{shift};
+      auto [solutions, num_attempts] =
+        pfc::find_global_minimum_guided(func, volume, tolerance, config);
+      guided.attempts += num_attempts;
+      guided.calls += func.ncalls.load();
+      if (!solutions.empty() && solutions.front().value < tolerance)
+        guided.converged += 1;
+    }
+  }
+  print_line("find_global_minimum", nproblems, random);
+  print_line("find_global_minimum_guided", nproblems, guided);
+}
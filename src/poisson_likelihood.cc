@@ -0,0 +1,190 @@
+#include "poisson_likelihood.hh"
+
+#include "tbb/parallel_for.h"
+
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+  // Return a double uniform on (0, 1) from the high 52 of 64 random bits.
+  // The bits are placed in the mantissa of a double in [1, 2), rather than
+  // converted from an integer, because AVX2 has no vector conversion from
+  // 64-bit integers; subtracting 1 - 2^-53 then centres the values in their
+  // intervals of width 2^-52, exactly.
+  double
+  to_unit_interval(std::uint32_t hi, std::uint32_t lo)
+  {
+    std::uint64_t const bits = (static_cast<std::uint64_t>(hi) << 20) |
+                               (lo >> 12) | 0x3ff0000000000000ULL;
+    return std::bit_cast<double>(bits) - (1.0 - 0x1.0p-53);
+  }
+
+  // Return a Poisson variate of mean mu < 10 by inversion of the uniform u.
+  double
+  poisson_by_inversion(double mu, double u)
+  {
+    double k = 0.0;
+    double p = std::exp(-mu);
+    double cdf = p;
+    // The bound guards against u so close to 1 that rounding keeps cdf
+    // below it; the probability of more than 100 is negligible for mu < 10.
+    while (u > cdf && k < 100.0) {
+      k += 1.0;
+      p *= mu / k;
+      cdf += p;
+    }
+    return k;
+  }
+
+  // Return a Poisson variate of mean mu >= 10 by the PTRS method of
+  // Hormann, "The transformed rejection method for generating Poisson
+  // random variables" (1993), drawing pairs of variates for (bin, draw)
+  // with draw = 1, 2, ...
+  double
+  poisson_by_ptrs(double mu, pfc::toy_stream const& stream, std::uint32_t bin)
+  {
+    double const slam = std::sqrt(mu);
+    double const loglam = std::log(mu);
+    double const b = 0.931 + 2.53 * slam;
+    double const a = -0.059 + 0.02483 * b;
+    double const invalpha = 1.1239 + 1.1328 / (b - 3.4);
+    double const vr = 0.9277 - 3.6224 / (b - 2.0);
+    for (std::uint32_t draw = 1;; ++draw) {
+      auto const [u0, v] = stream.uniforms(bin, draw);
+      double const u = u0 - 0.5;
+      double const us = 0.5 - std::abs(u);
+      double const k = std::floor((2.0 * a / us + b) * u + mu + 0.43);
+      if (us >= 0.07 && v <= vr)
+        return k;
+      if (k < 0.0 || (us < 0.013 && v > us))
+        continue;
+      if (std::log(v) + std::log(invalpha) - std::log(a / (us * us) + b) <=
+          -mu + k * loglam - std::lgamma(k + 1.0))
+        return k;
+    }
+  }
+}
+
+namespace pfc {
+
+  PFC_FASTMATH_TARGETS double
+  detail::poisson_sum_fast(std::span<double const> expected,
+                           std::span<double const> counts)
+  {
+    // Eight partial sums fill two AVX2 vectors, and so hide some of the
+    // latency of the additions.
+    constexpr std::size_t width = 8;
+    std::size_t const nblocks = counts.size() / width;
+    double sums[width] = {};
+    long num_special = 0;
+    for (std::size_t b = 0; b != nblocks; ++b) {
+      for (std::size_t j = 0; j != width; ++j) { // vectorized
+        double const mu = expected[width * b + j];
+        double const n = counts[width * b + j];
+        sums[j] += mu - n * fastmath::detail::log_kernel(mu);
+        num_special += fastmath::detail::is_log_special(mu);
+      }
+    }
+    double sum = ((sums[0] + sums[1]) + (sums[2] + sums[3])) +
+                 ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+    for (std::size_t i = width * nblocks; i != counts.size(); ++i)
+      sum += expected[i] - counts[i] * fastmath::log(expected[i]);
+    if (num_special == 0)
+      return sum;
+
+    sum = 0.0;
+    for (std::size_t i = 0; i != counts.size(); ++i)
+      sum += expected[i] - counts[i] * fastmath::log(expected[i]);
+    return sum;
+  }
+
+  binned_data::binned_data(std::vector<double> counts)
+    : counts_(std::move(counts))
+    , log_factorial_sum_(std::transform_reduce(
+        counts_.begin(),
+        counts_.end(),
+        0.0,
+        std::plus<>(),
+        [](double n) { return std::lgamma(n + 1.0); }))
+  {}
+
+  std::span<double const>
+  binned_data::counts() const
+  {
+    return counts_;
+  }
+
+  std::size_t
+  binned_data::size() const
+  {
+    return counts_.size();
+  }
+
+  double
+  binned_data::log_factorial_sum() const
+  {
+    return log_factorial_sum_;
+  }
+
+  toy_stream::toy_stream(std::uint64_t seed, std::uint64_t toy)
+    : key_{static_cast<std::uint32_t>(seed),
+           static_cast<std::uint32_t>(seed >> 32)}
+    , toy_lo_(static_cast<std::uint32_t>(toy))
+    , toy_hi_(static_cast<std::uint32_t>(toy >> 32))
+  {}
+
+  std::array<double, 2>
+  toy_stream::uniforms(std::uint32_t bin, std::uint32_t draw) const
+  {
+    auto const r = philox4x32({bin, draw, toy_lo_, toy_hi_}, key_);
+    return {to_unit_interval(r[0], r[1]), to_unit_interval(r[2], r[3])};
+  }
+
+  PFC_FASTMATH_TARGETS void
+  toy_stream::fill(std::uint32_t draw, std::span<double> out) const
+  {
+    for (std::size_t i = 0; i != out.size(); ++i) { // vectorized
+      auto const r = philox4x32(
+        {static_cast<std::uint32_t>(i), draw, toy_lo_, toy_hi_}, key_);
+      out[i] = to_unit_interval(r[0], r[1]);
+    }
+  }
+
+  void
+  generate_poisson_toy(std::span<double const> expected,
+                       std::uint64_t seed,
+                       std::uint64_t toy,
+                       std::span<double> counts)
+  {
+    toy_stream const stream(seed, toy);
+    stream.fill(0, counts);
+    for (std::size_t i = 0; i != expected.size(); ++i) {
+      double const mu = expected[i];
+      counts[i] =
+        (mu < 10.0)
+          ? poisson_by_inversion(mu, counts[i])
+          : poisson_by_ptrs(mu, stream, static_cast<std::uint32_t>(i));
+    }
+  }
+
+  std::vector<binned_data>
+  generate_poisson_toys(std::span<double const> expected,
+                        std::uint64_t seed,
+                        std::uint64_t first_toy,
+                        std::size_t ntoys)
+  {
+    std::vector<std::vector<double>> counts(ntoys);
+    oneapi::tbb::parallel_for(std::size_t(0), ntoys, [&](std::size_t t) {
+      counts[t].resize(expected.size());
+      generate_poisson_toy(expected, seed, first_toy + t, counts[t]);
+    });
+    std::vector<binned_data> toys;
+    toys.reserve(ntoys);
+    for (auto& c : counts)
+      toys.emplace_back(std::move(c));
+    return toys;
+  }
+}
@@ -0,0 +1,194 @@
+#ifndef PROFILED_FC_CPU_POISSON_LIKELIHOOD_HH
+#define PROFILED_FC_CPU_POISSON_LIKELIHOOD_HH
+
+#include "fastmath.hh"
+#include "geometry.hh"
+
+#include "tbb/enumerable_thread_specific.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace pfc {
+
+  // binned_data holds the observed counts of a binned dataset, with the
+  // constant term of the Poisson log-likelihood, the sum of lgamma(n + 1)
+  // over the bins, computed once when the dataset is made.
+  class binned_data {
+  public:
+    explicit binned_data(std::vector<double> counts);
+
+    std::span<double const> counts() const;
+    std::size_t size() const;
+    double log_factorial_sum() const;
+
+  private:
+    std::vector<double> counts_;
+    double log_factorial_sum_;
+  };
+
+  // Return -2 ln L = 2 sum_i (mu_i - n_i ln mu_i + ln n_i!) for the expected
+  // counts 'expected' (mu_i) and the observed counts of 'data' (n_i). Every
+  // expected count must be positive. When MATH is fastmath::fast_math, the
+  // sum is done by detail::poisson_sum_fast, which is vectorized.
+  template <typename MATH = fastmath::libm_math>
+  double poisson_m2lnl(std::span<double const> expected,
+                       binned_data const& data);
+
+  // binned_poisson_likelihood is the -2 ln L of a binned dataset as a
+  // function of the parameters of a model, in the style of rastrigin. MODEL
+  // is a callable with the signature
+  //
+  //   void(std::span<double const> parameters, std::span<double> expected)
+  //
+  // that fills 'expected' with the expected count in each bin. The expected
+  // counts are written to a buffer per thread, so an object can be called
+  // from several threads at once, as ParallelMinimizer does. The dataset is
+  // not copied, and must outlive the object.
+  template <typename MODEL, typename MATH = fastmath::libm_math>
+  class binned_poisson_likelihood {
+  public:
+    binned_poisson_likelihood(MODEL model, binned_data const& data);
+
+    double operator()(std::span<double const> parameters) const;
+    double operator()(column_vector const& parameters) const;
+
+  private:
+    MODEL model_;
+    binned_data const& data_;
+    mutable oneapi::tbb::enumerable_thread_specific<std::vector<double>>
+      expected_;
+  };
+
+  // philox4x32 is the Philox4x32-10 counter-based random number generator of
+  // Salmon et al. (2011): a keyed bijection of a 128-bit counter, so that the
+  // variates for any counter can be computed directly, in any order, on any
+  // thread.
+  inline std::array<std::uint32_t, 4> philox4x32(
+    std::array<std::uint32_t, 4> counter,
+    std::array<std::uint32_t, 2> key);
+
+  // toy_stream provides the uniform variates for one toy dataset: the pair of
+  // variates for (bin, draw) is a pure function of the seed, the toy number,
+  // the bin and the draw, computed with philox4x32. So a toy depends only
+  // on its number and the seed, not on which thread generates it, or on
+  // which other toys are generated.
+  class toy_stream {
+  public:
+    toy_stream(std::uint64_t seed, std::uint64_t toy);
+
+    // Return two independent variates uniform on (0, 1).
+    std::array<double, 2> uniforms(std::uint32_t bin, std::uint32_t draw) const;
+
+    // Fill out[i] with the first variate of uniforms(i, draw), for every i.
+    // Each lane of the vectorized loop runs philox4x32 for one bin.
+    void fill(std::uint32_t draw, std::span<double> out) const;
+
+  private:
+    std::array<std::uint32_t, 2> key_;
+    std::uint32_t toy_lo_;
+    std::uint32_t toy_hi_;
+  };
+
+  // Fill 'counts' with a Poisson variate for each of the expected counts in
+  // 'expected', for toy number 'toy' of the stream of toys with the given
+  // seed. The uniform variates for all the bins are generated in one
+  // vectorized pass, by toy_stream::fill; they are turned into counts by
+  // inversion for expected counts below 10, and by the PTRS transformed
+  // rejection method of Hormann (1993), which draws more variates as
+  // needed, for larger ones.
+  void generate_poisson_toy(std::span<double const> expected,
+                            std::uint64_t seed,
+                            std::uint64_t toy,
+                            std::span<double> counts);
+
+  // Generate the toys numbered [first_toy, first_toy + ntoys), in parallel.
+  std::vector<binned_data> generate_poisson_toys(
+    std::span<double const> expected,
+    std::uint64_t seed,
+    std::uint64_t first_toy,
+    std::size_t ntoys);
+
+  // Implementation details below.
+
+  namespace detail {
+    // Return sum_i (mu_i - n_i ln mu_i), using fastmath::log. The bins are
+    // summed into several partial sums, each of every so many bins, which
+    // are added at the end; so the loop is vectorized without reordering
+    // the additions of any one sum, but the result can differ in the last
+    // bits from that of a single sum. Expected counts that fastmath::log
+    // would pass to std::log are counted in that loop, and if there are
+    // any, the sum is done again with fastmath::log.
+    double poisson_sum_fast(std::span<double const> expected,
+                            std::span<double const> counts);
+  }
+
+  template <typename MATH>
+  double
+  poisson_m2lnl(std::span<double const> expected, binned_data const& data)
+  {
+    std::span<double const> const n = data.counts();
+    double sum = 0.0;
+    if constexpr (std::is_same_v<MATH, fastmath::fast_math>) {
+      sum = detail::poisson_sum_fast(expected, n);
+    } else {
+      for (std::size_t i = 0; i != n.size(); ++i)
+        sum += expected[i] - n[i] * MATH::log(expected[i]);
+    }
+    return 2.0 * (sum + data.log_factorial_sum());
+  }
+
+  inline std::array<std::uint32_t, 4>
+  philox4x32(std::array<std::uint32_t, 4> counter,
+             std::array<std::uint32_t, 2> key)
+  {
+    std::uint64_t const m0 = 0xD2511F53;
+    std::uint64_t const m1 = 0xCD9E8D57;
+    for (int round = 0; round != 10; ++round) {
+      std::uint64_t const p0 = m0 * counter[0];
+      std::uint64_t const p1 = m1 * counter[2];
+      counter = {static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ key[0],
+                 static_cast<std::uint32_t>(p1),
+                 static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ key[1],
+                 static_cast<std::uint32_t>(p0)};
+      key[0] += 0x9E3779B9;
+      key[1] += 0xBB67AE85;
+    }
+    return counter;
+  }
+
+  template <typename MODEL, typename MATH>
+  binned_poisson_likelihood<MODEL, MATH>::binned_poisson_likelihood(
+    MODEL model,
+    binned_data const& data)
+    : model_(std::move(model))
+    , data_(data)
+    , expected_(std::vector<double>(data.size()))
+  {}
+
+  template <typename MODEL, typename MATH>
+  double
+  binned_poisson_likelihood<MODEL, MATH>::operator()(
+    std::span<double const> parameters) const
+  {
+    std::vector<double>& expected = expected_.local();
+    model_(parameters, std::span<double>(expected));
+    return poisson_m2lnl<MATH>(expected, data_);
+  }
+
+  template <typename MODEL, typename MATH>
+  double
+  binned_poisson_likelihood<MODEL, MATH>::operator()(
+    column_vector const& parameters) const
+  {
+    std::span<double const> p = parameters;
+    return (*this)(p);
+  }
+}
+
+#endif
@@ -0,0 +1,113 @@
+#include "poisson_likelihood.hh"
+#include "fastmath.hh"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+using Catch::Matchers::WithinRel;
+
+TEST_CASE("philox4x32 reproduces the known-answer vectors")
+{
+  using counter = std::array<std::uint32_t, 4>;
+  CHECK(pfc::philox4x32({0, 0, 0, 0}, {0, 0}) ==
+        counter{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8});
+  CHECK(pfc::philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                        {0xffffffff, 0xffffffff}) ==
+        counter{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd});
+  CHECK(pfc::philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                        {0xa4093822, 0x299f31d0}) ==
+        counter{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1});
+}
+
+TEST_CASE("poisson_m2lnl agrees with the textbook formula")
+{
+  std::vector<double> const mu{0.5, 3.0, 12.5, 200.0};
+  pfc::binned_data const data({0.0, 4.0, 10.0, 215.0});
+  double expected = 0.0;
+  for (std::size_t i = 0; i != mu.size(); ++i) {
+    double const n = data.counts()[i];
+    expected +=
+      -2.0 * (n * std::log(mu[i]) - mu[i] - std::lgamma(n + 1.0));
+  }
+  CHECK_THAT(pfc::poisson_m2lnl(mu, data), WithinRel(expected, 1.0e-14));
+  CHECK_THAT(pfc::poisson_m2lnl<pfc::fastmath::fast_math>(mu, data),
+             WithinRel(expected, 1.0e-14));
+}
+
+TEST_CASE("the vectorized poisson_m2lnl agrees with the scalar one")
+{
+  // Enough bins for the vectorized loop and the remainder, with and without
+  // an expected count that fastmath::log passes to std::log.
+  std::vector<double> mu;
+  std::vector<double> counts;
+  for (int i = 0; i != 37; ++i) {
+    mu.push_back(0.25 + 1.5 * i);
+    counts.push_back(i);
+  }
+  pfc::binned_data const data(counts);
+  CHECK_THAT(pfc::poisson_m2lnl<pfc::fastmath::fast_math>(mu, data),
+             WithinRel(pfc::poisson_m2lnl(mu, data), 1.0e-14));
+  mu[1] = 1.0e-310; // subnormal
+  CHECK_THAT(pfc::poisson_m2lnl<pfc::fastmath::fast_math>(mu, data),
+             WithinRel(pfc::poisson_m2lnl(mu, data), 1.0e-14));
+}
+
+TEST_CASE("binned_poisson_likelihood evaluates its model")
+{
+  // Expected counts a + b * i in bin i.
+  auto model = [](std::span<double const> p, std::span<double> expected) {
+    for (std::size_t i = 0; i != expected.size(); ++i)
+      expected[i] = p[0] + p[1] * i;
+  };
+  pfc::binned_data const data({3.0, 5.0, 6.0});
+  pfc::binned_poisson_likelihood likelihood(model, data);
+  std::vector<double> const mu{2.0, 3.5, 5.0};
+  CHECK(likelihood(pfc::column_vector({2.0, 1.5})) ==
+        pfc::poisson_m2lnl(mu, data));
+}
+
+TEST_CASE("toys depend only on the seed and the toy number")
+{
+  std::vector<double> const expected{0.1, 2.0, 9.9, 10.0, 55.0, 1000.0};
+  auto const toys = pfc::generate_poisson_toys(expected, 42, 100, 8);
+  std::vector<double> counts(expected.size());
+  pfc::generate_poisson_toy(expected, 42, 105, counts);
+  for (std::size_t i = 0; i != expected.size(); ++i)
+    CHECK(toys[5].counts()[i] == counts[i]);
+  pfc::generate_poisson_toy(expected, 43, 105, counts);
+  bool differ = false;
+  for (std::size_t i = 0; i != expected.size(); ++i)
+    differ = differ || toys[5].counts()[i] != counts[i];
+  CHECK(differ);
+}
+
+TEST_CASE("toy counts have the Poisson mean and variance")
+{
+  std::vector<double> const expected{0.5, 4.0, 25.0, 400.0};
+  std::size_t const ntoys = 40000;
+  auto const toys = pfc::generate_poisson_toys(expected, 7, 0, ntoys);
+  for (std::size_t i = 0; i != expected.size(); ++i) {
+    double sum = 0.0;
+    double sum2 = 0.0;
+    bool integral = true;
+    for (auto const& toy : toys) {
+      double const n = toy.counts()[i];
+      integral = integral && n == std::floor(n);
+      sum += n;
+      sum2 += n * n;
+    }
+    CHECK(integral);
+    double const mean = sum / ntoys;
+    double const variance = sum2 / ntoys - mean * mean;
+    // Allow 5 standard errors of the mean, and 5% in the variance.
+    double const mu = expected[i];
+    CHECK(std::abs(mean - mu) < 5.0 * std::sqrt(mu / ntoys));
+    CHECK_THAT(variance, WithinRel(mu, 0.05));
+  }
+}
@@ -0,0 +1,265 @@
+#include "population.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace {
+
+  // Stop a run when sigma times the largest standard deviation falls below
+  // this fraction of the initial sigma.
+  double const CMAES_TOLX = 1.0e-12;
+  // Stop a run when the best values of recent generations span no more than
+  // this.
+  double const CMAES_TOLFUN = 1.0e-12;
+  // Stop a run when the condition number of C exceeds this.
+  double const CMAES_MAX_CONDITION = 1.0e14;
+
+  // Diagonalize the symmetric n x n matrix 'a' (row-major) with the cyclic
+  // Jacobi method. On return, 'values' holds the eigenvalues, and the
+  // columns of 'vectors' (row-major) the corresponding eigenvectors. 'a' is
+  // overwritten.
+  void
+  symmetric_eigen(std::vector<double>& a,
+                  std::size_t n,
+                  std::vector<double>& values,
+                  std::vector<double>& vectors)
+  {
+    vectors.assign(n * n, 0.0);
+    for (std::size_t i = 0; i != n; ++i)
+      vectors[i * n + i] = 1.0;
+
+    for (int sweep = 0; sweep != 100; ++sweep) {
+      double off = 0.0;
+      for (std::size_t p = 0; p != n; ++p)
+        for (std::size_t q = p + 1; q != n; ++q)
+          off += a[p * n + q] * a[p * n + q];
+      if (off == 0.0)
+        break;
+      for (std::size_t p = 0; p != n; ++p) {
+        for (std::size_t q = p + 1; q != n; ++q) {
+          double const apq = a[p * n + q];
+          if (apq == 0.0)
+            continue;
+          double const theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+          double const t = std::copysign(1.0, theta) /
+                           (std::abs(theta) + std::hypot(theta, 1.0));
+          double const c = 1.0 / std::hypot(t, 1.0);
+          double const s = t * c;
+          for (std::size_t k = 0; k != n; ++k) {
+            double const akp = a[k * n + p];
+            double const akq = a[k * n + q];
+            a[k * n + p] = c * akp - s * akq;
+            a[k * n + q] = s * akp + c * akq;
+          }
+          for (std::size_t k = 0; k != n; ++k) {
+            double const apk = a[p * n + k];
+            double const aqk = a[q * n + k];
+            a[p * n + k] = c * apk - s * aqk;
+            a[q * n + k] = s * apk + c * aqk;
+          }
+          for (std::size_t k = 0; k != n; ++k) {
+            double const vkp = vectors[k * n + p];
+            double const vkq = vectors[k * n + q];
+            vectors[k * n + p] = c * vkp - s * vkq;
+            vectors[k * n + q] = s * vkp + c * vkq;
+          }
+        }
+      }
+    }
+    values.resize(n);
+    for (std::size_t i = 0; i != n; ++i)
+      values[i] = a[i * n + i];
+  }
+}
+
+namespace pfc {
+
+  cmaes_state::cmaes_state(column_vector const& mean,
+                           double sigma,
+                           std::size_t lambda)
+    : n_(mean.size())
+    , lambda_(std::max<std::size_t>(lambda, 2))
+    , mu_(lambda_ / 2)
+    , mean_(mean)
+    , sigma_(sigma)
+    , sigma0_(sigma)
+    , pc_(n_, 0.0)
+    , ps_(n_, 0.0)
+    , c_(n_ * n_, 0.0)
+    , b_(n_ * n_, 0.0)
+    , d_(n_, 1.0)
+  {
+    // The default strategy parameters of Hansen's tutorial.
+    weights_.resize(mu_);
+    for (std::size_t i = 0; i != mu_; ++i)
+      weights_[i] = std::log(mu_ + 0.5) - std::log(i + 1.0);
+    double const sum = std::accumulate(weights_.begin(), weights_.end(), 0.0);
+    double sum_squares = 0.0;
+    for (auto& w : weights_) {
+      w /= sum;
+      sum_squares += w * w;
+    }
+    mueff_ = 1.0 / sum_squares;
+
+    double const n = static_cast<double>(n_);
+    cc_ = (4.0 + mueff_ / n) / (n + 4.0 + 2.0 * mueff_ / n);
+    cs_ = (mueff_ + 2.0) / (n + mueff_ + 5.0);
+    c1_ = 2.0 / ((n + 1.3) * (n + 1.3) + mueff_);
+    cmu_ = std::min(1.0 - c1_,
+                    2.0 * (mueff_ - 2.0 + 1.0 / mueff_) /
+                      ((n + 2.0) * (n + 2.0) + mueff_));
+    damps_ =
+      1.0 + 2.0 * std::max(0.0, std::sqrt((mueff_ - 1.0) / (n + 1.0)) - 1.0) +
+      cs_;
+    chin_ = std::sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+
+    for (std::size_t i = 0; i != n_; ++i)
+      c_[i * n_ + i] = b_[i * n_ + i] = 1.0;
+  }
+
+  std::size_t
+  cmaes_state::lambda() const
+  {
+    return lambda_;
+  }
+
+  std::size_t
+  cmaes_state::dimension() const
+  {
+    return n_;
+  }
+
+  column_vector
+  cmaes_state::candidate(std::vector<double> const& z) const
+  {
+    column_vector x = mean_;
+    for (std::size_t i = 0; i != n_; ++i) {
+      double y = 0.0;
+      for (std::size_t j = 0; j != n_; ++j)
+        y += b_[i * n_ + j] * d_[j] * z[j];
+      x(i) += sigma_ * y;
+    }
+    return x;
+  }
+
+  void
+  cmaes_state::update(std::vector<column_vector> const& candidates,
+                      std::vector<double> const& values)
+  {
+    ++generation_;
+    std::vector<std::size_t> order(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return values[a] < values[b];
+    });
+    // If the best 70% of the candidates have the same value, the function
+    // gives the distribution nothing to adapt to.
+    std::size_t const flat_index = std::min(
+      order.size() - 1, static_cast<std::size_t>(std::ceil(0.7 * lambda_)));
+    flat_ = values[order.front()] == values[order[flat_index]];
+
+    // The steps y_k = (x_k - mean) / sigma of the mu best candidates, and
+    // their weighted mean.
+    std::vector<std::vector<double>> y(mu_, std::vector<double>(n_));
+    std::vector<double> ymean(n_, 0.0);
+    for (std::size_t k = 0; k != mu_; ++k) {
+      auto const& x = candidates[order[k]];
+      for (std::size_t i = 0; i != n_; ++i) {
+        y[k][i] = (x(i) - mean_(i)) / sigma_;
+        ymean[i] += weights_[k] * y[k][i];
+      }
+    }
+    for (std::size_t i = 0; i != n_; ++i)
+      mean_(i) += sigma_ * ymean[i];
+
+    // C^(-1/2) ymean = B D^-1 B^T ymean.
+    std::vector<double> bt_y(n_, 0.0);
+    for (std::size_t j = 0; j != n_; ++j) {
+      for (std::size_t i = 0; i != n_; ++i)
+        bt_y[j] += b_[i * n_ + j] * ymean[i];
+      bt_y[j] /= d_[j];
+    }
+    double const ps_scale = std::sqrt(cs_ * (2.0 - cs_) * mueff_);
+    double ps_norm2 = 0.0;
+    for (std::size_t i = 0; i != n_; ++i) {
+      double w = 0.0;
+      for (std::size_t j = 0; j != n_; ++j)
+        w += b_[i * n_ + j] * bt_y[j];
+      ps_[i] = (1.0 - cs_) * ps_[i] + ps_scale * w;
+      ps_norm2 += ps_[i] * ps_[i];
+    }
+    double const ps_norm = std::sqrt(ps_norm2);
+    bool const hsig =
+      ps_norm / std::sqrt(1.0 - std::pow(1.0 - cs_, 2.0 * generation_)) /
+        chin_ <
+      1.4 + 2.0 / (n_ + 1.0);
+
+    double const pc_scale = std::sqrt(cc_ * (2.0 - cc_) * mueff_);
+    for (std::size_t i = 0; i != n_; ++i)
+      pc_[i] = (1.0 - cc_) * pc_[i] + (hsig ? pc_scale * ymean[i] : 0.0);
+
+    double const keep = 1.0 - c1_ - cmu_ +
+                        (hsig ? 0.0 : c1_ * cc_ * (2.0 - cc_));
+    for (std::size_t i = 0; i != n_; ++i) {
+      for (std::size_t j = 0; j <= i; ++j) {
+        double rank_mu = 0.0;
+        for (std::size_t k = 0; k != mu_; ++k)
+          rank_mu += weights_[k] * y[k][i] * y[k][j];
+        double const cij =
+          keep * c_[i * n_ + j] + c1_ * pc_[i] * pc_[j] + cmu_ * rank_mu;
+        c_[i * n_ + j] = c_[j * n_ + i] = cij;
+      }
+    }
+
+    sigma_ *= std::exp((cs_ / damps_) * (ps_norm / chin_ - 1.0));
+    // C changes slowly, so as in the tutorial we decompose it only every
+    // lambda / ((c1 + cmu) n 10) generations, keeping the work per
+    // generation O(n^2).
+    if (generation_ - decomposed_at_ >
+        lambda_ / ((c1_ + cmu_) * n_ * 10.0)) {
+      decompose();
+      decomposed_at_ = generation_;
+    }
+
+    recent_best_.push_back(values[order.front()]);
+    std::size_t const history =
+      10 + static_cast<std::size_t>(std::ceil(30.0 * n_ / lambda_));
+    if (recent_best_.size() > history)
+      recent_best_.pop_front();
+  }
+
+  void
+  cmaes_state::decompose()
+  {
+    std::vector<double> a = c_;
+    std::vector<double> eigenvalues;
+    symmetric_eigen(a, n_, eigenvalues, b_);
+    for (std::size_t i = 0; i != n_; ++i)
+      d_[i] = std::sqrt(
+        std::max(eigenvalues[i], std::numeric_limits<double>::min()));
+  }
+
+  bool
+  cmaes_state::stalled() const
+  {
+    if (flat_)
+      return true;
+    auto const [dmin, dmax] = std::minmax_element(d_.begin(), d_.end());
+    if ((*dmax) * (*dmax) > CMAES_MAX_CONDITION * (*dmin) * (*dmin))
+      return true;
+    if (sigma_ * (*dmax) < CMAES_TOLX * sigma0_)
+      return true;
+    std::size_t const history =
+      10 + static_cast<std::size_t>(std::ceil(30.0 * n_ / lambda_));
+    if (recent_best_.size() == history) {
+      auto const [lo, hi] =
+        std::minmax_element(recent_best_.begin(), recent_best_.end());
+      if (*hi - *lo <= CMAES_TOLFUN)
+        return true;
+    }
+    return !std::isfinite(sigma_);
+  }
+}
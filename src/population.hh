@@ -0,0 +1,382 @@
+#ifndef PROFILED_FC_CPU_POPULATION_HH
+#define PROFILED_FC_CPU_POPULATION_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "tbb/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <ctime>
+#include <deque>
+#include <random>
+#include <vector>
+
+namespace pfc {
+
+  // population_config holds the settings shared by the population-based
+  // searches, minimize_cmaes and minimize_de.
+  struct population_config {
+    // The number of candidates in each generation; 0 means the default of
+    // the method.
+    std::size_t population_size = 0;
+    // The maximum number of function calls, not counting those made in
+    // polishing.
+    long max_evaluations = 1000000;
+    // The maximum number of threads to use; 0 means as many as TBB allows.
+    int concurrency = 0;
+    // The number of best solutions to keep.
+    std::size_t num_retained = 16;
+    // The number of the best solutions found that are polished, at the end
+    // of the search, by a local minimization with do_one_minimization.
+    std::size_t num_polished = 0;
+    // The seed of the random number engine; 0 means use the time.
+    unsigned seed = 0;
+  };
+
+  // How minimize_cmaes restarts a run of CMA-ES that has stalled.
+  enum class cmaes_restarts {
+    none, // stop the search
+    ipop, // restart with twice the population size
+    bipop // alternate between large and small populations
+  };
+
+  struct cmaes_config : population_config {
+    // The initial step size, as a fraction of the widest extent of the
+    // region.
+    double initial_sigma = 0.3;
+    cmaes_restarts restarts = cmaes_restarts::bipop;
+  };
+
+  struct de_config : population_config {
+    // The differential weight F, which scales the difference vector added to
+    // the base vector.
+    double weight = 0.8;
+    // The crossover probability CR.
+    double crossover = 0.9;
+    // The search stops when the values of the population span no more than
+    // this.
+    double value_spread = 1.0e-12;
+  };
+
+  // cmaes_state is the state of one run of the covariance matrix adaptation
+  // evolution strategy (CMA-ES), as described in Hansen, "The CMA Evolution
+  // Strategy: A Tutorial" (2016). It only does the arithmetic of the method;
+  // sampling the standard normal vectors and calling the function are left
+  // to the caller (see minimize_cmaes).
+  class cmaes_state {
+  public:
+    // Start a run with the given mean, step size and number of candidates
+    // per generation.
+    cmaes_state(column_vector const& mean, double sigma, std::size_t lambda);
+
+    std::size_t lambda() const;
+    std::size_t dimension() const;
+
+    // Return the candidate mean + sigma * B D z, where z is a vector of
+    // standard normal variates, and C = B D^2 B^T is the covariance matrix.
+    column_vector candidate(std::vector<double> const& z) const;
+
+    // Update the distribution from a generation of lambda candidates and
+    // their function values.
+    void update(std::vector<column_vector> const& candidates,
+                std::vector<double> const& values);
+
+    // Return true if the run has stopped making progress: the step size has
+    // collapsed, the best values of recent generations are all equal, or
+    // the covariance matrix is too badly conditioned to continue.
+    bool stalled() const;
+
+  private:
+    void decompose();
+
+    std::size_t n_;
+    std::size_t lambda_;
+    std::size_t mu_;
+    std::vector<double> weights_;
+    double mueff_;
+    double cc_, cs_, c1_, cmu_, damps_, chin_;
+
+    column_vector mean_;
+    double sigma_;
+    double sigma0_;
+    std::vector<double> pc_;
+    std::vector<double> ps_;
+    std::vector<double> c_;     // covariance matrix, row-major
+    std::vector<double> b_;     // eigenvectors of C, as columns, row-major
+    std::vector<double> d_;     // square roots of the eigenvalues of C
+    long generation_ = 0;
+    long decomposed_at_ = 0;
+    std::deque<double> recent_best_;
+    bool flat_ = false;
+  };
+
+  // Minimize 'func' over 'bounds' with CMA-ES, restarting stalled runs as
+  // chosen by config.restarts, from a random mean within 'bounds'. The
+  // search stops when a value less than 'tolerance' is found, when
+  // config.max_evaluations function calls have been made, or when a run
+  // stalls and there are no restarts.
+  //
+  // Each generation is evaluated as one batch with tbb::parallel_for, so
+  // the function must be safe to call from several threads at once.
+  // Candidates are clamped to 'bounds' before they are evaluated.
+  //
+  // The best candidate of each generation is recorded as a solution whose
+  // start and location are the candidate; num_attempts is the number of
+  // generations, plus the number of polishing minimizations.
+  template <typename FUNC>
+  minimization_results minimize_cmaes(FUNC const& func,
+                                      region<column_vector> const& bounds,
+                                      double tolerance,
+                                      cmaes_config const& config = {});
+
+  // Minimize 'func' over 'bounds' with differential evolution, using the
+  // DE/rand/1/bin scheme of Storn and Price (1997). The search stops when a
+  // value less than 'tolerance' is found, when config.max_evaluations
+  // function calls have been made, or when the values of the population
+  // span no more than config.value_spread. The default population size is
+  // 10 times the dimension.
+  //
+  // The trial vectors of each generation are evaluated as one batch with
+  // tbb::parallel_for. Trial vectors are clamped to 'bounds'. The solutions
+  // and num_attempts are reported as for minimize_cmaes.
+  template <typename FUNC>
+  minimization_results minimize_de(FUNC const& func,
+                                   region<column_vector> const& bounds,
+                                   double tolerance,
+                                   de_config const& config = {});
+
+  // Implementation details below.
+
+  namespace detail {
+
+    inline column_vector
+    clamp_to(region<column_vector> const& bounds, column_vector x)
+    {
+      for (long i = 0; i != x.size(); ++i)
+        x(i) = std::clamp(x(i), bounds.lower(i), bounds.upper(i));
+      return x;
+    }
+
+    // Evaluate 'func' at each of 'points', in parallel.
+    template <typename FUNC>
+    void
+    evaluate_generation(FUNC const& func,
+                        std::vector<column_vector> const& points,
+                        std::vector<double>& values)
+    {
+      values.resize(points.size());
+      oneapi::tbb::parallel_for(
+        std::size_t(0), points.size(), [&](std::size_t i) {
+          values[i] = func(points[i]);
+        });
+    }
+
+    // Record the best of a generation in 'solutions'.
+    inline void
+    record_generation(std::vector<column_vector> const& points,
+                      std::vector<double> const& values,
+                      double tstart,
+                      shared_result& solutions)
+    {
+      std::size_t const best =
+        std::min_element(values.begin(), values.end()) - values.begin();
+      solution s;
+      s.start = s.location = points[best];
+      s.start_value = s.value = values[best];
+      s.tstart = tstart;
+      s.tstop = now_in_milliseconds();
+      s.nsteps = 0;
+      solutions.insert(s);
+    }
+
+    // Polish the best 'count' solutions in 'solutions' with
+    // do_one_minimization, in parallel.
+    template <typename FUNC>
+    void
+    polish_best(FUNC const& func, std::size_t count, shared_result& solutions)
+    {
+      if (count == 0 || solutions.empty())
+        return;
+      solutions.sort();
+      auto starts = solutions.solutions();
+      starts.resize(std::min(count, starts.size()));
+      oneapi::tbb::parallel_for(
+        std::size_t(0), starts.size(), [&](std::size_t i) {
+          solutions.insert(do_one_minimization(func, starts[i].location));
+        });
+    }
+
+    inline unsigned
+    seed_or_time(unsigned seed)
+    {
+      return (seed == 0) ? static_cast<unsigned>(std::time(0)) : seed;
+    }
+  }
+
+  template <typename FUNC>
+  minimization_results
+  minimize_cmaes(FUNC const& func,
+                 region<column_vector> const& bounds,
+                 double tolerance,
+                 cmaes_config const& config)
+  {
+    shared_result solutions(tolerance, config.num_retained);
+    std::mt19937 engine(detail::seed_or_time(config.seed));
+    std::normal_distribution<double> normal;
+
+    std::size_t const n = bounds.ndims();
+    double widest = 0.0;
+    for (std::size_t i = 0; i != n; ++i)
+      widest = std::max(widest, bounds.width(i));
+    double const sigma0 = config.initial_sigma * widest;
+    std::size_t const default_lambda =
+      (config.population_size != 0)
+        ? config.population_size
+        : 4 + static_cast<std::size_t>(3.0 * std::log(static_cast<double>(n)));
+
+    // For BIPOP, the evaluations used by each regime decide which runs next.
+    std::size_t large_lambda = default_lambda;
+    long large_evaluations = 0;
+    long small_evaluations = 0;
+    long evaluations = 0;
+    bool first_run = true;
+
+    run_with_concurrency(config.concurrency, [&]() {
+      std::vector<column_vector> points;
+      std::vector<double> values;
+      std::vector<double> z(n);
+      while (!solutions.is_done() && evaluations < config.max_evaluations) {
+        std::size_t lambda = default_lambda;
+        double sigma = sigma0;
+        bool large = true;
+        if (!first_run) {
+          if (config.restarts == cmaes_restarts::none)
+            break;
+          if (config.restarts == cmaes_restarts::bipop &&
+              small_evaluations < large_evaluations) {
+            // A small population, and a step size drawn log-uniformly
+            // between sigma0 and sigma0 / 100.
+            std::uniform_real_distribution<double> uniform;
+            double const u = uniform(engine);
+            double const ratio =
+              0.5 * static_cast<double>(large_lambda) / default_lambda;
+            lambda = std::max<std::size_t>(
+              default_lambda,
+              static_cast<std::size_t>(default_lambda *
+                                       std::pow(ratio, u * u)));
+            sigma = sigma0 * std::pow(10.0, -2.0 * uniform(engine));
+            large = false;
+          } else {
+            large_lambda *= 2;
+            lambda = large_lambda;
+          }
+        }
+        first_run = false;
+
+        cmaes_state state(random_point_within(bounds, engine), sigma, lambda);
+        long const run_start = evaluations;
+        while (!state.stalled() && !solutions.is_done() &&
+               evaluations < config.max_evaluations) {
+          double const tstart = now_in_milliseconds();
+          points.clear();
+          for (std::size_t k = 0; k != state.lambda(); ++k) {
+            for (auto& zi : z)
+              zi = normal(engine);
+            points.push_back(detail::clamp_to(bounds, state.candidate(z)));
+          }
+          detail::evaluate_generation(func, points, values);
+          evaluations += static_cast<long>(state.lambda());
+          state.update(points, values);
+          detail::record_generation(points, values, tstart, solutions);
+        }
+        (large ? large_evaluations : small_evaluations) +=
+          evaluations - run_start;
+      }
+      detail::polish_best(func, config.num_polished, solutions);
+    });
+    solutions.sort();
+    return {solutions.solutions(), solutions.num_attempts()};
+  }
+
+  template <typename FUNC>
+  minimization_results
+  minimize_de(FUNC const& func,
+              region<column_vector> const& bounds,
+              double tolerance,
+              de_config const& config)
+  {
+    shared_result solutions(tolerance, config.num_retained);
+    std::mt19937 engine(detail::seed_or_time(config.seed));
+    std::uniform_real_distribution<double> uniform;
+
+    std::size_t const n = bounds.ndims();
+    std::size_t const np = (config.population_size != 0)
+                             ? std::max<std::size_t>(config.population_size, 4)
+                             : std::max<std::size_t>(10 * n, 4);
+    std::uniform_int_distribution<std::size_t> pick(0, np - 1);
+    std::uniform_int_distribution<std::size_t> pick_dim(0, n - 1);
+
+    run_with_concurrency(config.concurrency, [&]() {
+      double tstart = now_in_milliseconds();
+      std::vector<column_vector> population;
+      for (std::size_t i = 0; i != np; ++i)
+        population.push_back(random_point_within(bounds, engine));
+      std::vector<double> values;
+      detail::evaluate_generation(func, population, values);
+      long evaluations = static_cast<long>(np);
+      detail::record_generation(population, values, tstart, solutions);
+
+      std::vector<column_vector> trials(np);
+      std::vector<double> trial_values;
+      while (!solutions.is_done() && evaluations < config.max_evaluations) {
+        auto const [lo, hi] = std::minmax_element(values.begin(), values.end());
+        if (*hi - *lo <= config.value_spread)
+          break;
+        tstart = now_in_milliseconds();
+        for (std::size_t i = 0; i != np; ++i) {
+          std::size_t r1, r2, r3;
+          do
+            r1 = pick(engine);
+          while (r1 == i);
+          do
+            r2 = pick(engine);
+          while (r2 == i || r2 == r1);
+          do
+            r3 = pick(engine);
+          while (r3 == i || r3 == r1 || r3 == r2);
+          // Binomial crossover, with at least one coordinate (jrand) taken
+          // from the mutant.
+          column_vector trial = population[i];
+          std::size_t const jrand = pick_dim(engine);
+          for (std::size_t j = 0; j != n; ++j) {
+            if (j == jrand || uniform(engine) < config.crossover)
+              trial(j) =
+                population[r1](j) +
+                config.weight * (population[r2](j) - population[r3](j));
+          }
+          trials[i] = detail::clamp_to(bounds, trial);
+        }
+        detail::evaluate_generation(func, trials, trial_values);
+        evaluations += static_cast<long>(np);
+        for (std::size_t i = 0; i != np; ++i) {
+          if (trial_values[i] <= values[i]) {
+            population[i] = trials[i];
+            values[i] = trial_values[i];
+          }
+        }
+        detail::record_generation(population, values, tstart, solutions);
+      }
+      detail::polish_best(func, config.num_polished, solutions);
+    });
+    solutions.sort();
+    return {solutions.solutions(), solutions.num_attempts()};
+  }
+}
+
+#endif
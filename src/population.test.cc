@@ -0,0 +1,79 @@
+#include "population.hh"
+#include "geometry.hh"
+#include "helical_valley.hh"
+#include "rastrigin.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <vector>
+
+namespace {
+  double
+  sphere(pfc::column_vector const& x)
+  {
+    double sum = 0.0;
+    for (long i = 0; i != x.size(); ++i)
+      sum += (x(i) - 1.0) * (x(i) - 1.0);
+    return sum;
+  }
+
+}
+
+TEST_CASE("a CMA-ES candidate with z = 0 is the mean")
+{
+  pfc::column_vector const mean({1.0, -2.0, 3.0});
+  pfc::cmaes_state state(mean, 0.5, 7);
+  CHECK(state.lambda() == 7);
+  CHECK(state.dimension() == 3);
+  auto const x = state.candidate(std::vector<double>(3, 0.0));
+  for (long i = 0; i != 3; ++i)
+    CHECK(x(i) == mean(i));
+}
+
+TEST_CASE("CMA-ES and DE find the minimum of a sphere")
+{
+  auto const bounds = pfc::make_box_in_n_dim(5, -5.0, 5.0);
+
+  pfc::cmaes_config cmaes;
+  cmaes.seed = 17;
+  cmaes.concurrency = 1;
+  cmaes.max_evaluations = 20000;
+  auto [cbest, cgenerations] =
+    pfc::minimize_cmaes(sphere, bounds, 1.0e-8, cmaes);
+  REQUIRE(!cbest.empty());
+  CHECK(cbest.front().value < 1.0e-8);
+  CHECK(cgenerations > 0);
+
+  pfc::de_config de;
+  de.seed = 17;
+  de.concurrency = 1;
+  de.max_evaluations = 100000;
+  auto [dbest, dgenerations] = pfc::minimize_de(sphere, bounds, 1.0e-8, de);
+  REQUIRE(!dbest.empty());
+  CHECK(dbest.front().value < 1.0e-8);
+}
+
+TEST_CASE("polishing improves the best solution")
+{
+  auto const bounds = pfc::make_box_in_n_dim(3, -10.0, 10.0);
+  pfc::de_config config;
+  config.seed = 5;
+  config.max_evaluations = 300;
+  config.num_polished = 2;
+  auto [solutions, num_attempts] =
+    pfc::minimize_de(pfc::helical_valley, bounds, 1.0e-10, config);
+  REQUIRE(!solutions.empty());
+  CHECK(solutions.front().nsteps > 0);
+  CHECK(solutions.front().value < 1.0e-6);
+}
+
+TEST_CASE("BIPOP CMA-ES finds the global minimum of Rastrigin in 5 dimensions")
+{
+  pfc::cmaes_config config;
+  config.seed = 3;
+  config.max_evaluations = 200000;
+  auto [solutions, num_attempts] = pfc::minimize_cmaes(
+    pfc::rastrigin_dlib, pfc::make_box_in_n_dim(5, -5.0, 5.0), 1.0e-6, config);
+  REQUIRE(!solutions.empty());
+  CHECK(solutions.front().value < 1.0e-6);
+}
@@ -1,7 +1,10 @@
 #ifndef PROFILED_FC_CPU_PROTECTED_ENGINE_HH
 #define PROFILED_FC_CPU_PROTECTED_ENGINE_HH
 
+#include "timed_lock.hh"
+
 #include <ctime>
+#include <mutex>
 #include <random>
 
 namespace pfc {
@@ -23,11 +26,16 @@ namespace pfc {
     static constexpr result_type min();
     static constexpr result_type max();
 
+    // Report the total time, in milliseconds, that callers of operator() have
+    // spent blocked waiting for another thread to finish using the engine.
+    double lock_wait_ms();
+
   private:
     using engine_type = URBG;
 
     std::mutex m_;
     engine_type e_;
+    long lock_wait_ns_ = 0;
   };
 
   template <std::uniform_random_bit_generator URBG>
@@ -38,10 +46,18 @@ namespace pfc {
   typename protected_engine<URBG>::result_type
   protected_engine<URBG>::operator()()
   {
-    std::scoped_lock lock(m_);
+    auto lock = lock_and_count_wait(m_, lock_wait_ns_);
     return e_();
   }
 
+  template <std::uniform_random_bit_generator URBG>
+  double
+  protected_engine<URBG>::lock_wait_ms()
+  {
+    std::scoped_lock lock(m_);
+    return lock_wait_ns_ * 1.0e-6;
+  }
+
   template <std::uniform_random_bit_generator URBG>
   constexpr typename protected_engine<URBG>::result_type
   protected_engine<URBG>::min()
@@ -11,4 +11,11 @@ namespace pfc {
       sum += val * val - 10 * cos(2. * M_PI * val);
     return sum;
   }
+
+  double
+  rastrigin_dlib(column_vector const& x)
+  {
+    std::span xx = x;
+    return rastrigin(xx);
+  }
 }
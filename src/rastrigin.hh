@@ -1,6 +1,10 @@
 #ifndef PROFILE_FC_CPU_RASTRIGIN_HH
 #define PROFILE_FC_CPU_RASTRIGIN_HH
 
+#include "fastmath.hh"
+#include "geometry.hh"
+
+#include <numbers>
 #include <span>
 
 namespace pfc {
@@ -8,6 +12,23 @@ namespace pfc {
   // rastrigin is the standard Rastring function, in as many dimenions as
   // the length of 'x'.
   double rastrigin(std::span<double const> x);
+
+  // rastrigin_dlib is the Rastrigin function of a column_vector, the type of
+  // point the minimizers pass to the function being minimized. It has no
+  // overloads, so that it can be passed to them by name.
+  double rastrigin_dlib(column_vector const& x);
+
+  // rastrigin_with<MATH> is the Rastrigin function, using the math policy
+  // MATH (fastmath::libm_math or fastmath::fast_math) for cos.
+  template <typename MATH>
+  double
+  rastrigin_with(std::span<double const> x)
+  {
+    double sum = 10.0 * x.size();
+    for (auto val : x)
+      sum += val * val - 10 * MATH::cos(2. * std::numbers::pi * val);
+    return sum;
+  }
 }
 
 #endif
@@ -0,0 +1,383 @@
+#ifndef PROFILED_FC_CPU_REGION_TREE_HH
+#define PROFILED_FC_CPU_REGION_TREE_HH
+
+#include "geometry.hh"
+
+#include "tbb/blocked_range.h" // for tbb::split
+
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace pfc {
+
+  // region_tree is the tree of regions made by splitting a root region
+  // 'ngenerations' times, as make_splits does, but without storing the
+  // regions. Every region of a generation is split along the same
+  // dimension; the tree stores only that dimension for each generation. The
+  // region with a given generation and index is computed on demand, in
+  // O(generation) time.
+  //
+  // The split dimension is chosen by the rule of region::split, the widest
+  // dimension with the lowest index among equals, applied exactly: the width
+  // of a dimension is taken to be its width in the root, divided by 2 for
+  // each time it has been split. make_splits instead compares the widths of
+  // each region, which are rounded differently in different regions; when
+  // some widths of the root are equal and not dyadic, as for the cube
+  // make_box_in_n_dim(2, -0.3, 0.4), the regions it makes of one generation
+  // can be split along different dimensions. The regions of a region_tree
+  // are then not those of make_splits. They are the same whenever the
+  // widths of the root are distinct and not in a ratio that is a power of 2,
+  // or are dyadic, so that no rounding is done.
+  //
+  // The regions of generation g are numbered [0, 2^g), in the order that
+  // make_splits(g, {root}) returns them: the children of region i are 2i and
+  // 2i + 1, the lower half first. So the bits of an index, from the most
+  // significant, say which half to take at each split.
+  template <typename VEC = pfc::column_vector>
+  class region_tree {
+  public:
+    class iterator;
+    class range;
+
+    // Create the tree for 'ngenerations' splits of 'root'. It is required
+    // that ngenerations be in [0, 64).
+    region_tree(region<VEC> const& root, int ngenerations);
+
+    region<VEC> const& root() const;
+    int generations() const;
+
+    // Return the number of regions in the last generation, 2^generations().
+    std::size_t size() const;
+
+    // Return the dimension along which the regions of 'generation' are split
+    // to make those of generation + 1. It is required that generation be
+    // less than generations().
+    std::size_t split_dimension(int generation) const;
+
+    // Return region 'index' of 'generation'; generation defaults to the
+    // last.
+    region<VEC> cell(std::size_t index) const;
+    region<VEC> cell(int generation, std::size_t index) const;
+
+    // Set 'out', which must have the dimensionality of the root, to region
+    // 'index' of 'generation'. This does no allocation, so it suits loops
+    // over many regions.
+    void cell(int generation, std::size_t index, region<VEC>& out) const;
+
+    // Iterate over the regions of the last generation.
+    iterator begin() const;
+    iterator end() const;
+
+    // Return a TBB range over the regions of the last generation, for use
+    // with tbb::parallel_for. A range is split into the halves of the
+    // index range, which are whole subtrees when the range is.
+    range cells(std::size_t grain_size = 1) const;
+
+  private:
+    region<VEC> root_;
+    std::vector<std::size_t> split_dimensions_;
+  };
+
+  // iterator is an input iterator over the regions of the last generation
+  // of a region_tree, with the index arithmetic of a random-access iterator.
+  // Dereferencing it computes the region, and returns it by value.
+  template <typename VEC>
+  class region_tree<VEC>::iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = region<VEC>;
+    using difference_type = std::ptrdiff_t;
+    using reference = region<VEC>;
+
+    iterator() = default;
+    iterator(region_tree const* tree, std::size_t index);
+
+    region<VEC> operator*() const;
+    std::size_t index() const;
+
+    iterator& operator++();
+    iterator operator++(int);
+    iterator& operator+=(difference_type n);
+    iterator operator+(difference_type n) const;
+    difference_type operator-(iterator const& other) const;
+    bool operator==(iterator const& other) const;
+
+  private:
+    region_tree const* tree_ = nullptr;
+    std::size_t index_ = 0;
+  };
+
+  // range models the TBB Range concept over a contiguous block of regions
+  // of the last generation of a region_tree.
+  template <typename VEC>
+  class region_tree<VEC>::range {
+  public:
+    range(region_tree const& tree,
+          std::size_t first,
+          std::size_t last,
+          std::size_t grain_size = 1);
+
+    // Split 'other' in half, taking the upper half.
+    range(range& other, oneapi::tbb::split);
+
+    bool empty() const;
+    bool is_divisible() const;
+    std::size_t size() const;
+
+    region_tree const& tree() const;
+    iterator begin() const;
+    iterator end() const;
+
+  private:
+    region_tree const* tree_;
+    std::size_t first_;
+    std::size_t last_;
+    std::size_t grain_size_;
+  };
+
+  // Implementation details below.
+
+  template <typename VEC>
+  region_tree<VEC>::region_tree(region<VEC> const& root, int ngenerations)
+    : root_(root)
+  {
+    if (ngenerations < 0 || ngenerations >= 64)
+      throw std::logic_error("region_tree needs 0 <= ngenerations < 64");
+    // Scaling by a power of 2 is exact, so widths that are equal in the
+    // root stay equal when they have been halved equally often.
+    std::vector<int> halvings(root.ndims(), 0);
+    auto width = [&](std::size_t i) {
+      return std::ldexp(root.width(i), -halvings[i]);
+    };
+    split_dimensions_.reserve(ngenerations);
+    for (int g = 0; g != ngenerations; ++g) {
+      std::size_t d = 0;
+      for (std::size_t i = 1; i < root.ndims(); ++i)
+        if (width(i) > width(d))
+          d = i;
+      split_dimensions_.push_back(d);
+      ++halvings[d];
+    }
+  }
+
+  template <typename VEC>
+  region<VEC> const&
+  region_tree<VEC>::root() const
+  {
+    return root_;
+  }
+
+  template <typename VEC>
+  int
+  region_tree<VEC>::generations() const
+  {
+    return static_cast<int>(split_dimensions_.size());
+  }
+
+  template <typename VEC>
+  std::size_t
+  region_tree<VEC>::size() const
+  {
+    return std::size_t{1} << split_dimensions_.size();
+  }
+
+  template <typename VEC>
+  std::size_t
+  region_tree<VEC>::split_dimension(int generation) const
+  {
+    return split_dimensions_[generation];
+  }
+
+  template <typename VEC>
+  region<VEC>
+  region_tree<VEC>::cell(std::size_t index) const
+  {
+    return cell(generations(), index);
+  }
+
+  template <typename VEC>
+  region<VEC>
+  region_tree<VEC>::cell(int generation, std::size_t index) const
+  {
+    region<VEC> result(root_);
+    cell(generation, index, result);
+    return result;
+  }
+
+  template <typename VEC>
+  void
+  region_tree<VEC>::cell(int generation,
+                         std::size_t index,
+                         region<VEC>& out) const
+  {
+    for (std::size_t i = 0; i != root_.ndims(); ++i) {
+      out.lower(i) = root_.lower(i);
+      out.upper(i) = root_.upper(i);
+    }
+    // Repeat the midpoint arithmetic of region::split, so that the bounds
+    // are exactly those make_splits gives.
+    for (int g = 0; g != generation; ++g) {
+      std::size_t const d = split_dimensions_[g];
+      double const middle = (out.lower(d) + out.upper(d)) / 2.0;
+      if ((index >> (generation - 1 - g)) & 1)
+        out.lower(d) = middle;
+      else
+        out.upper(d) = middle;
+    }
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::iterator
+  region_tree<VEC>::begin() const
+  {
+    return iterator(this, 0);
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::iterator
+  region_tree<VEC>::end() const
+  {
+    return iterator(this, size());
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::range
+  region_tree<VEC>::cells(std::size_t grain_size) const
+  {
+    return range(*this, 0, size(), grain_size);
+  }
+
+  template <typename VEC>
+  region_tree<VEC>::iterator::iterator(region_tree const* tree,
+                                       std::size_t index)
+    : tree_(tree), index_(index)
+  {}
+
+  template <typename VEC>
+  region<VEC>
+  region_tree<VEC>::iterator::operator*() const
+  {
+    return tree_->cell(index_);
+  }
+
+  template <typename VEC>
+  std::size_t
+  region_tree<VEC>::iterator::index() const
+  {
+    return index_;
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::iterator&
+  region_tree<VEC>::iterator::operator++()
+  {
+    ++index_;
+    return *this;
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::iterator
+  region_tree<VEC>::iterator::operator++(int)
+  {
+    iterator result(*this);
+    ++index_;
+    return result;
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::iterator&
+  region_tree<VEC>::iterator::operator+=(difference_type n)
+  {
+    index_ += n;
+    return *this;
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::iterator
+  region_tree<VEC>::iterator::operator+(difference_type n) const
+  {
+    iterator result(*this);
+    result += n;
+    return result;
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::iterator::difference_type
+  region_tree<VEC>::iterator::operator-(iterator const& other) const
+  {
+    return static_cast<difference_type>(index_) -
+           static_cast<difference_type>(other.index_);
+  }
+
+  template <typename VEC>
+  bool
+  region_tree<VEC>::iterator::operator==(iterator const& other) const
+  {
+    return tree_ == other.tree_ && index_ == other.index_;
+  }
+
+  template <typename VEC>
+  region_tree<VEC>::range::range(region_tree const& tree,
+                                 std::size_t first,
+                                 std::size_t last,
+                                 std::size_t grain_size)
+    : tree_(&tree), first_(first), last_(last), grain_size_(grain_size)
+  {}
+
+  template <typename VEC>
+  region_tree<VEC>::range::range(range& other, oneapi::tbb::split)
+    : tree_(other.tree_)
+    , first_(other.first_ + other.size() / 2)
+    , last_(other.last_)
+    , grain_size_(other.grain_size_)
+  {
+    other.last_ = first_;
+  }
+
+  template <typename VEC>
+  bool
+  region_tree<VEC>::range::empty() const
+  {
+    return first_ == last_;
+  }
+
+  template <typename VEC>
+  bool
+  region_tree<VEC>::range::is_divisible() const
+  {
+    return size() > grain_size_;
+  }
+
+  template <typename VEC>
+  std::size_t
+  region_tree<VEC>::range::size() const
+  {
+    return last_ - first_;
+  }
+
+  template <typename VEC>
+  region_tree<VEC> const&
+  region_tree<VEC>::range::tree() const
+  {
+    return *tree_;
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::iterator
+  region_tree<VEC>::range::begin() const
+  {
+    return iterator(tree_, first_);
+  }
+
+  template <typename VEC>
+  typename region_tree<VEC>::iterator
+  region_tree<VEC>::range::end() const
+  {
+    return iterator(tree_, last_);
+  }
+}
+
+#endif
@@ -0,0 +1,103 @@
+#include "region_tree.hh"
+#include "catch2/catch_test_macros.hpp"
+
+#include "tbb/parallel_for.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+using pfc::column_vector;
+using pfc::region;
+using pfc::region_tree;
+
+namespace {
+  bool
+  same_bounds(region<column_vector> const& a, region<column_vector> const& b)
+  {
+    for (std::size_t i = 0; i != a.ndims(); ++i)
+      if (a.lower(i) != b.lower(i) || a.upper(i) != b.upper(i))
+        return false;
+    return true;
+  }
+}
+
+TEST_CASE("region_tree matches make_splits")
+{
+  // Bounds that are not dyadic, so that any difference in the midpoint
+  // arithmetic would show.
+  region three_d({-0.3, 0.1, 1.7}, {12.9, 25.3, 51.1});
+  std::vector<region<column_vector>> const original{three_d};
+  for (int ngen : {0, 1, 5, 9}) {
+    auto const expected = make_splits(ngen, original);
+    region_tree const tree(three_d, ngen);
+    REQUIRE(tree.size() == expected.size());
+    std::size_t i = 0;
+    for (auto const& r : tree) {
+      CHECK(same_bounds(r, expected[i]));
+      ++i;
+    }
+    CHECK(i == expected.size());
+  }
+
+  // Regions of an intermediate generation are the parents of the last.
+  region_tree const tree(three_d, 6);
+  auto const parents = make_splits(4, original);
+  for (std::size_t i = 0; i != parents.size(); ++i)
+    CHECK(same_bounds(tree.cell(4, i), parents[i]));
+}
+
+TEST_CASE("region_tree splits equal widths in turn")
+{
+  // make_splits mixes the split dimensions of these cubes, at generation 4
+  // and 3 respectively, because their widths are not dyadic.
+  for (auto const& root : {pfc::make_box_in_n_dim(2, -0.3, 0.4),
+                           pfc::make_box_in_n_dim(3, 0.1, 0.7)}) {
+    region_tree const tree(root, 12);
+    for (int g = 0; g != tree.generations(); ++g)
+      CHECK(tree.split_dimension(g) == g % root.ndims());
+
+    // Every region of the last generation is a cube, each of its widths
+    // that of the root halved 12 / ndim times, and they fill the root.
+    double const width = std::ldexp(root.width(0), -12 / int(root.ndims()));
+    double volume = 0.0;
+    long failures = 0;
+    for (auto const& cell : tree) {
+      volume += cell.volume();
+      for (std::size_t i = 0; i != root.ndims(); ++i)
+        if (std::abs(cell.width(i) - width) > 1.0e-15)
+          ++failures;
+      if (!pfc::within_region(cell.lower(), root) ||
+          !pfc::within_region(cell.upper(), root))
+        ++failures;
+    }
+    CHECK(failures == 0);
+    CHECK(std::abs(volume - root.volume()) < 1.0e-12);
+  }
+}
+
+TEST_CASE("region_tree range visits every region once")
+{
+  region_tree const tree(pfc::make_box_in_n_dim(4, -10.0, 10.0), 16);
+  std::vector<std::atomic<int>> visits(tree.size());
+  std::atomic<long> failures = 0;
+  double const expected_volume = tree.root().volume() / tree.size();
+  oneapi::tbb::parallel_for(tree.cells(64), [&](auto const& r) {
+    region<column_vector> cell(tree.root().ndims());
+    for (auto it = r.begin(); it != r.end(); ++it) {
+      visits[it.index()].fetch_add(1);
+      tree.cell(tree.generations(), it.index(), cell);
+      if (cell.volume() != expected_volume ||
+          !pfc::within_region(cell.lower(), tree.root()) ||
+          !pfc::within_region(cell.upper(), tree.root()))
+        failures.fetch_add(1);
+    }
+  });
+  CHECK(failures.load() == 0);
+  long unvisited = 0;
+  for (auto const& v : visits)
+    if (v.load() != 1)
+      ++unvisited;
+  CHECK(unvisited == 0);
+}
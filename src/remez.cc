@@ -0,0 +1,184 @@
+#include "remez.hh"
+
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+#include <numbers>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+  // Return the index of the grid point nearest to x.
+  std::size_t
+  nearest_grid_index(double x, double lower, double step, std::size_t npoints)
+  {
+    double const i = std::round((x - lower) / step);
+    return static_cast<std::size_t>(
+      std::clamp(i, 0.0, static_cast<double>(npoints - 1)));
+  }
+
+  // Choose the next reference from the errors on the grid: the extremum of
+  // each run of errors of the same sign, reduced to 'nref' points by
+  // repeatedly dropping the smaller of the two end points. This keeps the
+  // points alternating in sign, and keeps the global extremum.
+  std::vector<std::size_t>
+  choose_reference(std::vector<double> const& errors, std::size_t nref)
+  {
+    std::deque<std::size_t> extrema;
+    int run_sign = 0;
+    for (std::size_t i = 0; i != errors.size(); ++i) {
+      double const e = errors[i];
+      if (e == 0.0)
+        continue;
+      int const sign = (e > 0.0) ? 1 : -1;
+      if (sign != run_sign) {
+        extrema.push_back(i);
+        run_sign = sign;
+      } else if (std::abs(e) > std::abs(errors[extrema.back()])) {
+        extrema.back() = i;
+      }
+    }
+    if (extrema.size() < nref)
+      throw std::runtime_error(
+        "remez_fit: the error does not alternate in sign often enough");
+    while (extrema.size() > nref) {
+      if (std::abs(errors[extrema.front()]) < std::abs(errors[extrema.back()]))
+        extrema.pop_front();
+      else
+        extrema.pop_back();
+    }
+    return {extrema.begin(), extrema.end()};
+  }
+}
+
+namespace pfc {
+
+  std::vector<double>
+  solve_linear_system(std::vector<double> a, std::vector<double> b)
+  {
+    std::size_t const n = b.size();
+    for (std::size_t col = 0; col != n; ++col) {
+      std::size_t pivot = col;
+      for (std::size_t row = col + 1; row != n; ++row) {
+        if (std::abs(a[row * n + col]) > std::abs(a[pivot * n + col]))
+          pivot = row;
+      }
+      if (a[pivot * n + col] == 0.0)
+        throw std::runtime_error("solve_linear_system: singular matrix");
+      if (pivot != col) {
+        std::swap_ranges(a.begin() + col * n,
+                         a.begin() + (col + 1) * n,
+                         a.begin() + pivot * n);
+        std::swap(b[col], b[pivot]);
+      }
+      for (std::size_t row = col + 1; row != n; ++row) {
+        double const factor = a[row * n + col] / a[col * n + col];
+        for (std::size_t k = col; k != n; ++k)
+          a[row * n + k] -= factor * a[col * n + k];
+        b[row] -= factor * b[col];
+      }
+    }
+    std::vector<double> x(n);
+    for (std::size_t row = n; row-- != 0;) {
+      double sum = b[row];
+      for (std::size_t k = row + 1; k != n; ++k)
+        sum -= a[row * n + k] * x[k];
+      x[row] = sum / a[row * n + row];
+    }
+    return x;
+  }
+
+  remez_result
+  remez_fit(std::function<double(double)> const& target,
+            std::vector<std::function<double(double)>> const& basis,
+            double lower,
+            double upper,
+            remez_config const& config)
+  {
+    using range = oneapi::tbb::blocked_range<std::size_t>;
+    std::size_t const nbasis = basis.size();
+    std::size_t const nref = nbasis + 1;
+    std::size_t const npoints = config.grid_points;
+    double const step = (upper - lower) / (npoints - 1);
+
+    // Tabulate the target and the basis functions on the grid. The basis
+    // values are stored with one row per grid point.
+    std::vector<double> t(npoints);
+    std::vector<double> b(npoints * nbasis);
+    oneapi::tbb::parallel_for(range(0, npoints), [&](range const& r) {
+      for (std::size_t i = r.begin(); i != r.end(); ++i) {
+        double const x = lower + i * step;
+        t[i] = target(x);
+        for (std::size_t k = 0; k != nbasis; ++k)
+          b[i * nbasis + k] = basis[k](x);
+      }
+    });
+
+    // The initial reference is the Chebyshev nodes of the first kind, which
+    // are all in the interior of the interval.
+    std::vector<std::size_t> reference(nref);
+    for (std::size_t j = 0; j != nref; ++j) {
+      double const angle =
+        std::numbers::pi * (2.0 * (nref - 1 - j) + 1.0) / (2.0 * nref);
+      double const c = std::cos(angle);
+      double const x = lower + 0.5 * (upper - lower) * (c + 1.0);
+      reference[j] = nearest_grid_index(x, lower, step, npoints);
+    }
+
+    // Errors below this are rounding noise, and need not be levelled.
+    double const noise =
+      16.0 * std::numeric_limits<double>::epsilon() *
+      std::max(1.0, std::abs(*std::max_element(
+                      t.begin(), t.end(), [](double x, double y) {
+                        return std::abs(x) < std::abs(y);
+                      })));
+
+    remez_result result;
+    std::vector<double> errors(npoints);
+    for (int iteration = 1; iteration <= config.max_iterations; ++iteration) {
+      // Solve for the coefficients, and the levelled error E, such that the
+      // error at the reference points is E, -E, E, ...
+      std::vector<double> a(nref * nref);
+      std::vector<double> rhs(nref);
+      for (std::size_t j = 0; j != nref; ++j) {
+        std::size_t const i = reference[j];
+        for (std::size_t k = 0; k != nbasis; ++k)
+          a[j * nref + k] = b[i * nbasis + k];
+        a[j * nref + nbasis] = (j % 2 == 0) ? 1.0 : -1.0;
+        rhs[j] = t[i];
+      }
+      auto solution = solve_linear_system(std::move(a), std::move(rhs));
+      double const levelled = std::abs(solution.back());
+      solution.pop_back();
+
+      oneapi::tbb::parallel_for(range(0, npoints), [&](range const& r) {
+        for (std::size_t i = r.begin(); i != r.end(); ++i) {
+          double approx = 0.0;
+          for (std::size_t k = 0; k != nbasis; ++k)
+            approx += solution[k] * b[i * nbasis + k];
+          errors[i] = approx - t[i];
+        }
+      });
+      double max_error = 0.0;
+      for (double e : errors)
+        max_error = std::max(max_error, std::abs(e));
+
+      result.coefficients = std::move(solution);
+      result.max_error = max_error;
+      result.levelled_error = levelled;
+      result.iterations = iteration;
+      if (max_error - levelled <= config.tolerance * max_error ||
+          max_error <= noise) {
+        result.converged = true;
+        break;
+      }
+      reference = choose_reference(errors, nref);
+    }
+    return result;
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef PROFILED_FC_CPU_REMEZ_HH
+#define PROFILED_FC_CPU_REMEZ_HH
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace pfc {
+
+  // remez_config controls remez_fit. The error is measured on a grid of
+  // 'grid_points' equally spaced points covering the interval. The iteration
+  // stops when the largest error on the grid exceeds the levelled error of
+  // the current reference by no more than the fraction 'tolerance', or after
+  // 'max_iterations' exchanges.
+  struct remez_config {
+    std::size_t grid_points = 100001;
+    int max_iterations = 50;
+    double tolerance = 1.0e-8;
+  };
+
+  // remez_result holds the outcome of remez_fit.
+  struct remez_result {
+    std::vector<double> coefficients; // one per basis function
+    double max_error = 0.0;  // largest absolute error on the grid
+    double levelled_error = 0.0; // absolute error at the reference points
+    int iterations = 0;
+    bool converged = false;
+  };
+
+  // Find the coefficients c_k minimizing the maximum over [lower, upper] of
+  // |sum_k c_k basis[k](x) - target(x)|, using the Remez exchange algorithm.
+  //
+  // The basis functions may include a common weight, e.g. x^k * sqrt(1 - x),
+  // so models of the form polynomial times weight function are handled
+  // directly. Models that are not linear in their parameters must be
+  // reparametrized to be linear before fitting.
+  //
+  // The target and the basis functions are evaluated once on the grid, in
+  // parallel. At each iteration the error is evaluated on the grid in
+  // parallel, and the reference is replaced by the extremum of each run of
+  // same-sign error, keeping the global extremum.
+  //
+  // Points at which every basis function and the target vanish (e.g. x = 1
+  // for sqrt(1 - x) weights) can not be reference points; the initial
+  // reference is chosen from the interior of the interval to avoid them.
+  //
+  // Throws std::runtime_error if the linear system for a reference is
+  // singular, or if the error does not alternate in sign often enough to form
+  // a new reference.
+  remez_result remez_fit(
+    std::function<double(double)> const& target,
+    std::vector<std::function<double(double)>> const& basis,
+    double lower,
+    double upper,
+    remez_config const& config = {});
+
+  // Solve the dense linear system A x = b, where 'a' holds A in row-major
+  // order, by Gaussian elimination with partial pivoting. Throws
+  // std::runtime_error if A is singular.
+  std::vector<double> solve_linear_system(std::vector<double> a,
+                                          std::vector<double> b);
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "remez.hh"
+
+#include "catch2/catch_test_macros.hpp"
+#include "catch2/matchers/catch_matchers_floating_point.hpp"
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+using Catch::Matchers::WithinAbs;
+using Catch::Matchers::WithinRel;
+
+namespace {
+  std::vector<std::function<double(double)>>
+  monomials(int n)
+  {
+    std::vector<std::function<double(double)>> basis;
+    for (int k = 0; k != n; ++k)
+      basis.push_back([k](double x) { return std::pow(x, k); });
+    return basis;
+  }
+}
+
+TEST_CASE("linear system solution")
+{
+  // The first pivot is zero, so this needs row exchange.
+  std::vector<double> const a{0.0, 2.0, 1.0, 1.0, 1.0, 1.0, 2.0, 1.0, 3.0};
+  auto const x = pfc::solve_linear_system(a, {7.0, 6.0, 13.0});
+  CHECK_THAT(x[0], WithinAbs(1.0, 1.e-12));
+  CHECK_THAT(x[1], WithinAbs(2.0, 1.e-12));
+  CHECK_THAT(x[2], WithinAbs(3.0, 1.e-12));
+}
+
+TEST_CASE("polynomials are reproduced exactly")
+{
+  auto const r =
+    pfc::remez_fit([](double x) { return 1.0 - 2.0 * x + 0.5 * x * x; },
+                   monomials(3),
+                   -1.0,
+                   1.0);
+  CHECK(r.converged);
+  CHECK(r.max_error < 1.e-12);
+  CHECK_THAT(r.coefficients[0], WithinAbs(1.0, 1.e-12));
+  CHECK_THAT(r.coefficients[1], WithinAbs(-2.0, 1.e-12));
+  CHECK_THAT(r.coefficients[2], WithinAbs(0.5, 1.e-12));
+}
+
+TEST_CASE("minimax cubic approximation of exp")
+{
+  auto const r = pfc::remez_fit(
+    [](double x) { return std::exp(x); }, monomials(4), -1.0, 1.0);
+  CHECK(r.converged);
+  // The error of the best cubic approximation to exp on [-1, 1] is
+  // 0.0055283, and it equioscillates.
+  CHECK_THAT(r.max_error, WithinAbs(0.0055283, 1.e-6));
+  CHECK_THAT(r.levelled_error, WithinRel(r.max_error, 1.e-8));
+}
+
+TEST_CASE("weighted basis")
+{
+  // acos(x) = sqrt(1 - x) * p(x) on [0, 1]; the basis functions and the
+  // target all vanish at x = 1.
+  std::vector<std::function<double(double)>> basis;
+  for (int k = 0; k != 4; ++k)
+    basis.push_back(
+      [k](double x) { return std::pow(x, k) * std::sqrt(1.0 - x); });
+  auto const r =
+    pfc::remez_fit([](double x) { return std::acos(x); }, basis, 0.0, 1.0);
+  CHECK(r.converged);
+  // This is the accuracy of the classic Hastings approximation.
+  CHECK(r.max_error < 7.e-5);
+}
@@ -0,0 +1,147 @@
+#include "report_writer.hh"
+
+#include "tbb/concurrent_queue.h"
+#include "tbb/parallel_pipeline.h"
+#include "tbb/task_arena.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+
+  // Append the elements of 'v' separated by tabs, as the operator<< of
+  // column_vector writes them.
+  void
+  format_vector(fmt::memory_buffer& out, pfc::column_vector const& v)
+  {
+    auto it = std::back_inserter(out);
+    for (long i = 0; i != v.size(); ++i) {
+      if (i != 0)
+        out.push_back('\t');
+      fmt::format_to(it, "{:.17e}", v(i));
+    }
+  }
+
+  // Write all of 'buffer' to 'fd', continuing after partial writes.
+  void
+  write_all(int fd, fmt::memory_buffer const& buffer)
+  {
+    char const* data = buffer.data();
+    std::size_t remaining = buffer.size();
+    while (remaining != 0) {
+      ssize_t const n = ::write(fd, data, remaining);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::runtime_error(std::string("Unable to write report: ") +
+                                 std::strerror(errno));
+      }
+      data += n;
+      remaining -= n;
+    }
+  }
+
+  // A chunk of the report: the solutions [first, last), and the buffer into
+  // which they are formatted.
+  struct chunk {
+    std::size_t first;
+    std::size_t last;
+    fmt::memory_buffer* buffer;
+  };
+}
+
+namespace pfc {
+
+  void
+  format_report_header(fmt::memory_buffer& out, long ndim)
+  {
+    auto it = std::back_inserter(out);
+    fmt::format_to(it, "idx\ttstart\t");
+    for (long i = 0; i != ndim; ++i)
+      fmt::format_to(it, "s{}\t", i);
+    fmt::format_to(it, "fs\ttstop\t");
+    for (long i = 0; i != ndim; ++i)
+      fmt::format_to(it, "x{}\t", i);
+    fmt::format_to(it, "min\tdist\tnsteps\n");
+  }
+
+  void
+  format_solution(fmt::memory_buffer& out, solution const& s)
+  {
+    auto it = std::back_inserter(out);
+    double const dist = dlib::length(s.start - s.location);
+    fmt::format_to(it, "{}\t{:.17e}\t", s.index, s.tstart);
+    format_vector(out, s.start);
+    fmt::format_to(it, "\t{:.17e}\t{:.17e}\t", s.start_value, s.tstop);
+    format_vector(out, s.location);
+    // The distance is written by operator<< with the default stream
+    // formatting, which is that of printf's %g.
+    fmt::format_to(it, "\t{:.17e}\t{:g}\t{}", s.value, dist, s.nsteps);
+  }
+
+  void
+  write_report(std::vector<solution> const& results,
+               int fd,
+               report_writer_config const& config)
+  {
+    if (results.empty())
+      return;
+
+    fmt::memory_buffer header;
+    format_report_header(header, results.front().location.size());
+    write_all(fd, header);
+
+    std::size_t const chunk_size = std::max<std::size_t>(config.chunk_size, 1);
+    std::size_t const max_in_flight =
+      (config.max_chunks_in_flight > 0)
+        ? config.max_chunks_in_flight
+        : 2 * oneapi::tbb::this_task_arena::max_concurrency();
+
+    // The pipeline never has more than max_in_flight chunks in it, so this
+    // many buffers are enough; each is returned to the pool once written.
+    std::vector<std::unique_ptr<fmt::memory_buffer>> buffers;
+    oneapi::tbb::concurrent_queue<fmt::memory_buffer*> pool;
+    for (std::size_t i = 0; i != max_in_flight; ++i) {
+      buffers.push_back(std::make_unique<fmt::memory_buffer>());
+      pool.push(buffers.back().get());
+    }
+
+    std::size_t next = 0;
+    oneapi::tbb::parallel_pipeline(
+      max_in_flight,
+      oneapi::tbb::make_filter<void, chunk>(
+        oneapi::tbb::filter_mode::serial_in_order,
+        [&](oneapi::tbb::flow_control& fc) -> chunk {
+          if (next == results.size()) {
+            fc.stop();
+            return {};
+          }
+          chunk c{next, std::min(next + chunk_size, results.size()), nullptr};
+          next = c.last;
+          pool.try_pop(c.buffer);
+          return c;
+        }) &
+        oneapi::tbb::make_filter<chunk, chunk>(
+          oneapi::tbb::filter_mode::parallel,
+          [&](chunk c) {
+            c.buffer->clear();
+            for (std::size_t i = c.first; i != c.last; ++i) {
+              format_solution(*c.buffer, results[i]);
+              c.buffer->push_back('\n');
+            }
+            return c;
+          }) &
+        oneapi::tbb::make_filter<chunk, void>(
+          oneapi::tbb::filter_mode::serial_in_order, [&](chunk c) {
+            write_all(fd, *c.buffer);
+            pool.push(c.buffer);
+          }));
+  }
+}
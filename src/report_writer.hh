@@ -0,0 +1,44 @@
+#ifndef PROFILED_FC_CPU_REPORT_WRITER_HH
+#define PROFILED_FC_CPU_REPORT_WRITER_HH
+
+#include "solution.hh"
+
+#include "fmt/format.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace pfc {
+
+  // The report writer produces the same text as print_report, byte for
+  // byte, for a stream in its default state, but much faster: the numbers
+  // are formatted straight into reusable fmt::memory_buffers, without
+  // temporary strings or iostreams, chunks of solutions are formatted in
+  // parallel, and each chunk is written with a single write(2), in order.
+
+  // report_writer_config controls write_report.
+  struct report_writer_config {
+    // The number of solutions formatted into each buffer, and written with
+    // each call of write(2).
+    std::size_t chunk_size = 4096;
+    // The most chunks being formatted or waiting to be written at once, and
+    // so the number of buffers used; 0 means twice the number of threads.
+    std::size_t max_chunks_in_flight = 0;
+  };
+
+  // Append the header line of a report of solutions of dimension 'ndim',
+  // including the newline, to 'out'.
+  void format_report_header(fmt::memory_buffer& out, long ndim);
+
+  // Append 's', as operator<< writes it, without a newline, to 'out'.
+  void format_solution(fmt::memory_buffer& out, solution const& s);
+
+  // Write the report of 'results' that print_report writes to the file
+  // descriptor 'fd'. Nothing is written if 'results' is empty. Throws
+  // std::runtime_error if a write fails.
+  void write_report(std::vector<solution> const& results,
+                    int fd,
+                    report_writer_config const& config = {});
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "report_writer.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using pfc::column_vector;
+using pfc::solution;
+
+namespace {
+  // Return what write_report writes, by way of a temporary file.
+  std::string
+  written_report(std::vector<solution> const& results,
+                 pfc::report_writer_config const& config)
+  {
+    std::FILE* file = std::tmpfile();
+    pfc::write_report(results, ::fileno(file), config);
+    std::string text;
+    std::rewind(file);
+    char buffer[4096];
+    std::size_t n = 0;
+    while ((n = std::fread(buffer, 1, sizeof(buffer), file)) > 0)
+      text.append(buffer, n);
+    std::fclose(file);
+    return text;
+  }
+}
+
+TEST_CASE("write_report matches print_report byte for byte")
+{
+  std::mt19937 engine(17);
+  std::uniform_real_distribution<double> flat(-1.0e3, 1.0e3);
+  std::vector<solution> results(1000);
+  for (std::size_t i = 0; i != results.size(); ++i) {
+    solution& s = results[i];
+    s.start = column_vector({flat(engine), flat(engine), 1.0e-300});
+    s.location = column_vector({flat(engine), 0.0, -7.0e12});
+    s.index = static_cast<long>(i);
+    s.start_value = flat(engine);
+    s.value = flat(engine) / 3.0;
+    s.tstart = 1.0e12 + i;
+    s.tstop = s.tstart + 0.125;
+    s.nsteps = (i % 3 == 0) ? -1 : static_cast<long>(i);
+  }
+  // Some of the values a search can produce, but rarely does.
+  results[1].value = std::numeric_limits<double>::infinity();
+  results[2].start_value = -std::numeric_limits<double>::infinity();
+  results[3].value = std::numeric_limits<double>::quiet_NaN();
+  results[4].location = results[4].start; // zero distance
+  results[5].start(0) = 1.0e200;          // very large distance
+
+  std::ostringstream expected;
+  pfc::print_report(results, expected);
+
+  pfc::report_writer_config config;
+  config.chunk_size = 7; // many chunks, the last one partial
+  CHECK(written_report(results, config) == expected.str());
+  config.chunk_size = 100000; // a single chunk
+  config.max_chunks_in_flight = 1;
+  CHECK(written_report(results, config) == expected.str());
+  CHECK(written_report({}, config).empty());
+}
@@ -0,0 +1,118 @@
+#ifndef PROFILED_FC_CPU_SCALED_MINIMIZER_HH
+#define PROFILED_FC_CPU_SCALED_MINIMIZER_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "shared_result.hh"
+#include "solution.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pfc {
+
+  // scaled_minimizer is a local minimization policy that runs another policy
+  // (by default bfgs_minimizer) in rescaled coordinates, for problems whose
+  // parameters have very different scales.
+  //
+  // The region is first mapped onto the unit hypercube. Then the diagonal of
+  // the Hessian is estimated at the starting point, by central differences,
+  // and each coordinate is scaled so that the estimated curvature along it is
+  // one. The inner policy minimizes the function of the scaled coordinates;
+  // the solution it returns is mapped back to the original coordinates, so
+  // the caller never sees the scaled ones.
+  //
+  // The curvature estimate costs 2n extra function calls per local
+  // minimization; the value at the starting point it needs is reused by the
+  // inner policy. Where the estimated curvature is not positive, that
+  // coordinate is only mapped onto the unit interval. A dimension of zero
+  // width can not be mapped onto the unit interval; it is only shifted, so
+  // that its scale is set by the curvature alone.
+  //
+  // The inner policy must not hold bounds of its own (as
+  // box_constrained_minimizer does), since they would not be rescaled.
+  template <typename LOCAL = bfgs_minimizer>
+  struct scaled_minimizer {
+    column_vector lower;
+    column_vector width;
+    LOCAL inner;
+    // Step used for the curvature estimate, in unit-cube coordinates.
+    double curvature_step = 1.0e-4;
+
+    explicit scaled_minimizer(region<column_vector> const& bounds,
+                              LOCAL inner_policy = LOCAL())
+      : lower(bounds.lower())
+      , width(bounds.upper() - bounds.lower())
+      , inner(inner_policy)
+    {
+      for (long i = 0; i != width.size(); ++i) {
+        if (width(i) == 0.0)
+          width(i) = 1.0;
+      }
+    }
+
+    template <typename FUNC>
+    solution operator()(FUNC const& f,
+                        column_vector const& starting_point,
+                        shared_result const& solutions) const;
+  };
+
+  // Implementation details below.
+
+  template <typename LOCAL>
+  template <typename FUNC>
+  solution
+  scaled_minimizer<LOCAL>::operator()(FUNC const& f,
+                                      column_vector const& starting_point,
+                                      shared_result const& solutions) const
+  {
+    long const n = starting_point.size();
+    column_vector const u0 =
+      dlib::pointwise_divide(starting_point - lower, width);
+    auto from_unit = [this](column_vector const& u) -> column_vector {
+      return lower + dlib::pointwise_multiply(width, u);
+    };
+
+    // Estimate the curvature along each axis of the unit cube, and choose
+    // the scale of each coordinate from it.
+    double const h = curvature_step;
+    double const f0 = f(starting_point);
+    column_vector scale(n);
+    column_vector u = u0;
+    for (long i = 0; i != n; ++i) {
+      u(i) = u0(i) + h;
+      double const fplus = f(from_unit(u));
+      u(i) = u0(i) - h;
+      double const fminus = f(from_unit(u));
+      u(i) = u0(i);
+      double const curvature = (fplus - 2.0 * f0 + fminus) / (h * h);
+      scale(i) = (curvature > 0.0 && std::isfinite(curvature))
+                   ? 1.0 / std::sqrt(curvature)
+                   : 1.0;
+    }
+
+    // The scaled coordinates y are related to the unit-cube coordinates by
+    // u = scale * y, and so to the original coordinates by
+    // x = lower + width * scale * y.
+    column_vector const step = dlib::pointwise_multiply(width, scale);
+    auto to_original = [this, &step](column_vector const& y) -> column_vector {
+      return lower + dlib::pointwise_multiply(step, y);
+    };
+    column_vector const y0 = dlib::pointwise_divide(u0, scale);
+    // The inner policy starts by evaluating the function at y0, which we
+    // have already done. The function is pure, so returning f0 there is
+    // safe even if the inner policy calls scaled_f from several threads.
+    auto scaled_f = [&f, &to_original, &y0, f0](column_vector const& y) {
+      if (y == y0)
+        return f0;
+      return f(to_original(y));
+    };
+
+    solution result = inner(scaled_f, y0, solutions);
+    result.start = starting_point;
+    result.location = to_original(result.location);
+    return result;
+  }
+}
+
+#endif
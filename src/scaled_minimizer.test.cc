@@ -0,0 +1,83 @@
+#include "scaled_minimizer.hh"
+#include "geometry.hh"
+#include "shared_result.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cmath>
+#include <limits>
+
+using pfc::column_vector;
+
+namespace {
+  // A quadratic whose curvatures along the two axes differ by a factor of
+  // 1e6, with its minimum at (0.3, 0.7).
+  double
+  badly_scaled_quadratic(column_vector const& x)
+  {
+    double const dx = x(0) - 0.3;
+    double const dy = x(1) - 0.7;
+    return 1.0e3 * dx * dx + 1.0e-3 * dy * dy;
+  }
+
+  // A local minimization policy that only evaluates the function at the
+  // starting point.
+  struct evaluate_start {
+    template <typename FUNC>
+    pfc::solution
+    operator()(FUNC const& f,
+               column_vector const& starting_point,
+               pfc::shared_result const&) const
+    {
+      pfc::solution result;
+      result.start = starting_point;
+      result.start_value = f(starting_point);
+      result.location = starting_point;
+      result.value = result.start_value;
+      return result;
+    }
+  };
+}
+
+TEST_CASE("scaled_minimizer minimizes a badly scaled quadratic")
+{
+  pfc::shared_result solutions(-std::numeric_limits<double>::infinity(), 1);
+  pfc::scaled_minimizer minimizer(pfc::make_box_in_n_dim(2, 0.0, 1.0));
+  column_vector const start({0.9, 0.1});
+  auto const result = minimizer(badly_scaled_quadratic, start, solutions);
+  CHECK(result.start == start);
+  CHECK(result.start_value == badly_scaled_quadratic(start));
+  CHECK(std::abs(result.location(0) - 0.3) < 1.0e-6);
+  CHECK(std::abs(result.location(1) - 0.7) < 1.0e-3);
+  CHECK(result.value < 1.0e-9);
+}
+
+TEST_CASE("scaled_minimizer evaluates the starting point only once")
+{
+  pfc::shared_result solutions(-std::numeric_limits<double>::infinity(), 1);
+  long num_calls = 0;
+  auto f = [&num_calls](column_vector const& x) {
+    ++num_calls;
+    return badly_scaled_quadratic(x);
+  };
+  pfc::scaled_minimizer minimizer(pfc::make_box_in_n_dim(2, 0.0, 1.0),
+                                  evaluate_start());
+  column_vector const start({0.9, 0.1});
+  auto const result = minimizer(f, start, solutions);
+  // One call at the start, and two per dimension for the curvature.
+  CHECK(num_calls == 5);
+  CHECK(result.start_value == badly_scaled_quadratic(start));
+}
+
+TEST_CASE("scaled_minimizer passes a dimension of zero width through")
+{
+  pfc::shared_result solutions(-std::numeric_limits<double>::infinity(), 1);
+  pfc::region<column_vector> const box(column_vector({0.0, 0.7}),
+                                       column_vector({1.0, 0.7}));
+  pfc::scaled_minimizer minimizer(box);
+  auto const result =
+    minimizer(badly_scaled_quadratic, column_vector({0.9, 0.7}), solutions);
+  REQUIRE(std::isfinite(result.value));
+  CHECK(std::abs(result.location(0) - 0.3) < 1.0e-6);
+  CHECK(std::abs(result.location(1) - 0.7) < 1.0e-3);
+}
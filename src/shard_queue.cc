@@ -0,0 +1,315 @@
+#include "shard_queue.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+#include <unistd.h> // for gethostname, getpid and link
+
+namespace fs = std::filesystem;
+
+namespace {
+  // Shard files and names use the shard id as their base name. A claimed
+  // shard has the worker name appended, after an '@'.
+  char const CLAIM_SEPARATOR = '@';
+
+  pfc::shard
+  read_shard(fs::path const& p)
+  {
+    std::ifstream in(p);
+    pfc::shard s;
+    if (!(in >> s.id >> s.grid_point >> s.num_attempts))
+      throw std::runtime_error("Unable to read shard file: " + p.string());
+    return s;
+  }
+
+  void
+  write_shard(fs::path const& p, pfc::shard const& s)
+  {
+    std::ofstream out(p);
+    out << s.id << ' ' << s.grid_point << ' ' << s.num_attempts << '\n';
+    if (!out)
+      throw std::runtime_error("Unable to write shard file: " + p.string());
+  }
+
+  // Return the shard id part of a file name in pending/ or claimed/.
+  std::string
+  shard_id_of(fs::path const& p)
+  {
+    auto const name = p.filename().string();
+    return name.substr(0, name.find(CLAIM_SEPARATOR));
+  }
+
+  // Return the worker part of a file name in claimed/.
+  std::string
+  worker_of(fs::path const& p)
+  {
+    auto const name = p.filename().string();
+    auto const sep = name.find(CLAIM_SEPARATOR);
+    if (sep == std::string::npos)
+      return {};
+    return name.substr(sep + 1);
+  }
+}
+
+namespace pfc {
+
+  shard_queue::shard_queue(fs::path dir) : dir_(std::move(dir)) {}
+
+  fs::path
+  shard_queue::pending_dir() const
+  {
+    return dir_ / "pending";
+  }
+
+  fs::path
+  shard_queue::claimed_dir() const
+  {
+    return dir_ / "claimed";
+  }
+
+  fs::path
+  shard_queue::results_dir() const
+  {
+    return dir_ / "results";
+  }
+
+  fs::path
+  shard_queue::partial_path(shard const& s, std::string const& worker) const
+  {
+    return results_dir() / (std::to_string(s.id) + '.' + worker);
+  }
+
+  fs::path
+  shard_queue::result_path(long id) const
+  {
+    return results_dir() / (std::to_string(id) + ".tsv");
+  }
+
+  void
+  shard_queue::create(std::vector<shard> const& shards, long ndim)
+  {
+    fs::create_directories(pending_dir());
+    fs::create_directories(claimed_dir());
+    fs::create_directories(results_dir());
+    for (auto const& s : shards)
+      write_shard(pending_dir() / std::to_string(s.id), s);
+    // The manifest is written last, so that a worker that sees it knows all
+    // the shards exist.
+    std::ofstream manifest(dir_ / "manifest");
+    manifest << shards.size() << ' ' << ndim << '\n';
+  }
+
+  std::string
+  shard_queue::this_worker_name()
+  {
+    char host[256] = {};
+    gethostname(host, sizeof(host) - 1);
+    return std::string(host) + '-' + std::to_string(getpid());
+  }
+
+  fs::path
+  shard_queue::claimed_path(shard const& s, std::string const& worker) const
+  {
+    return claimed_dir() / (std::to_string(s.id) + CLAIM_SEPARATOR + worker);
+  }
+
+  std::optional<shard>
+  shard_queue::claim(std::string const& worker)
+  {
+    std::vector<fs::path> candidates;
+    for (auto const& entry : fs::directory_iterator(pending_dir()))
+      candidates.push_back(entry.path());
+    std::sort(candidates.begin(), candidates.end());
+
+    for (auto const& p : candidates) {
+      auto const id = shard_id_of(p);
+      // A shard that was requeued after its original worker finished it
+      // need not be done again.
+      if (fs::exists(result_path(std::stol(id)))) {
+        std::error_code ec;
+        fs::remove(p, ec);
+        continue;
+      }
+      fs::path const claimed =
+        claimed_dir() / (id + CLAIM_SEPARATOR + worker);
+      std::error_code ec;
+      // Only one process can succeed in renaming a given file; everyone else
+      // gets an error because the source no longer exists.
+      fs::rename(p, claimed, ec);
+      if (ec)
+        continue;
+      return read_shard(claimed);
+    }
+    return {};
+  }
+
+  bool
+  shard_queue::heartbeat(shard const& s, std::string const& worker)
+  {
+    // Setting the time fails if the claim has been renamed away.
+    std::error_code ec;
+    fs::last_write_time(claimed_path(s, worker), clock::now(), ec);
+    return !ec;
+  }
+
+  bool
+  shard_queue::append_results(shard const& s,
+                              std::string const& worker,
+                              std::vector<solution> const& solutions)
+  {
+    std::ofstream out(partial_path(s, worker), std::ios::app);
+    for (auto const& sol : solutions)
+      out << s.grid_point << '\t' << sol << '\n';
+    out.flush();
+    if (!out)
+      throw std::runtime_error("Unable to write results for shard " +
+                               std::to_string(s.id));
+    out.close();
+    // A requeue moves the claim away before it removes the partial results,
+    // so if we still hold the claim after writing, none of what we wrote has
+    // been removed.
+    if (heartbeat(s, worker))
+      return true;
+    std::error_code ec;
+    fs::remove(partial_path(s, worker), ec);
+    return false;
+  }
+
+  bool
+  shard_queue::complete(shard const& s, std::string const& worker)
+  {
+    auto const partial = partial_path(s, worker);
+    // A shard may legitimately produce no solutions; we still need a result
+    // file to mark it as complete.
+    if (!fs::exists(partial))
+      std::ofstream{partial};
+    bool published = false;
+    if (heartbeat(s, worker)) {
+      // Unlike rename, link does not replace an existing result file. It
+      // also fails if the partial results were removed by a requeue after
+      // the heartbeat.
+      published = ::link(partial.c_str(), result_path(s.id).c_str()) == 0;
+      if (!published && errno != EEXIST && errno != ENOENT)
+        throw std::runtime_error("Unable to publish results for shard " +
+                                 std::to_string(s.id) + ": " +
+                                 std::strerror(errno));
+    }
+    std::error_code ec;
+    fs::remove(partial, ec);
+    fs::remove(claimed_path(s, worker), ec);
+    return published;
+  }
+
+  std::size_t
+  shard_queue::requeue_worker(std::string const& worker)
+  {
+    std::size_t count = 0;
+    for (auto const& entry : fs::directory_iterator(claimed_dir())) {
+      if (worker_of(entry.path()) != worker)
+        continue;
+      auto const id = shard_id_of(entry.path());
+      std::error_code ec;
+      fs::rename(entry.path(), pending_dir() / id, ec);
+      if (ec)
+        continue;
+      ++count;
+      // The worker is known to be gone, so its partial results will never be
+      // completed.
+      fs::remove(results_dir() / (id + '.' + worker), ec);
+    }
+    return count;
+  }
+
+  std::size_t
+  shard_queue::requeue_stale(std::chrono::seconds max_age)
+  {
+    std::size_t count = 0;
+    auto const now = clock::now();
+    for (auto const& entry : fs::directory_iterator(claimed_dir())) {
+      std::error_code ec;
+      auto const t = fs::last_write_time(entry.path(), ec);
+      if (ec || now - t < max_age)
+        continue;
+      auto const id = shard_id_of(entry.path());
+      fs::rename(entry.path(), pending_dir() / id, ec);
+      if (ec)
+        continue;
+      ++count;
+      // The shard will be done again from the start, so the partial results
+      // of the stale worker must not be merged with the new ones.
+      fs::remove(results_dir() / (id + '.' + worker_of(entry.path())), ec);
+    }
+    return count;
+  }
+
+  long
+  shard_queue::num_shards() const
+  {
+    std::ifstream manifest(dir_ / "manifest");
+    long n = 0;
+    manifest >> n;
+    return n;
+  }
+
+  long
+  shard_queue::ndim() const
+  {
+    std::ifstream manifest(dir_ / "manifest");
+    long n = 0;
+    long nd = 0;
+    manifest >> n >> nd;
+    return nd;
+  }
+
+  long
+  shard_queue::num_complete() const
+  {
+    long count = 0;
+    for (auto const& entry : fs::directory_iterator(results_dir())) {
+      if (entry.path().extension() == ".tsv")
+        ++count;
+    }
+    return count;
+  }
+
+  void
+  shard_queue::mark_done()
+  {
+    std::ofstream{dir_ / "done"};
+  }
+
+  bool
+  shard_queue::is_done() const
+  {
+    return fs::exists(dir_ / "done");
+  }
+
+  std::map<long, std::vector<solution>>
+  shard_queue::merged_results(std::size_t max_results) const
+  {
+    long const nd = ndim();
+    std::map<long, std::vector<solution>> merged;
+    for (auto const& entry : fs::directory_iterator(results_dir())) {
+      if (entry.path().extension() != ".tsv")
+        continue;
+      std::ifstream in(entry.path());
+      std::string line;
+      while (std::getline(in, line)) {
+        auto const tab = line.find('\t');
+        long const grid_point = std::stol(line.substr(0, tab));
+        merged[grid_point].push_back(
+          parse_solution(line.substr(tab + 1), nd));
+      }
+    }
+    for (auto& [grid_point, solutions] : merged) {
+      std::sort(solutions.begin(), solutions.end());
+      if (solutions.size() > max_results)
+        solutions.resize(max_results);
+    }
+    return merged;
+  }
+}
@@ -0,0 +1,132 @@
+#ifndef PROFILED_FC_CPU_SHARD_QUEUE_HH
+#define PROFILED_FC_CPU_SHARD_QUEUE_HH
+
+#include "solution.hh"
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pfc {
+
+  // A shard is a unit of work handed out to a worker process: a number of
+  // local minimization attempts to be made for one point of a grid (e.g. one
+  // point of a Feldman-Cousins grid). A grid point may be split into several
+  // shards.
+  struct shard {
+    long id = -1;
+    long grid_point = -1;
+    long num_attempts = 0;
+  };
+
+  // shard_queue is a work queue shared between one coordinator process and
+  // any number of worker processes, implemented as files in a directory.
+  // Because it relies only on atomic rename and link within one filesystem,
+  // the same code works for processes on one machine and for processes on
+  // many machines sharing a filesystem.
+  //
+  // The directory layout is:
+  //
+  //   manifest                number of shards and dimensionality
+  //   pending/<id>            shards waiting for a worker
+  //   claimed/<id>@<worker>   shards being worked on; the modification time
+  //                           is the worker's last heartbeat
+  //   results/<id>.<worker>   results being streamed by a worker
+  //   results/<id>.tsv        results of a completed shard
+  //   done                    created by the coordinator when all is done
+  //
+  // A worker claims a shard by renaming it from pending/ to claimed/; only one
+  // worker can succeed. If a worker dies, the coordinator moves its shards
+  // back to pending/ so that another worker can redo them. Results of a
+  // shard only become visible when the shard is complete, so results from a
+  // worker that died are never merged.
+  //
+  // A worker that is only slow may have its shards requeued while it is
+  // still working on them. It finds out the next time it appends results,
+  // or completes the shard, because its claim is gone; it then discards its
+  // partial results, which may lack the chunks written before the requeue.
+  // The results of a shard are published only once: a worker that finishes
+  // a shard that another has already completed discards its own.
+  //
+  // Results are stored one solution per line, as the grid point followed by
+  // the solution in the format written by operator<<(std::ostream&,
+  // solution const&).
+  class shard_queue {
+  public:
+    using clock = std::filesystem::file_time_type::clock;
+
+    // Open (but do not create) the queue in the given directory.
+    explicit shard_queue(std::filesystem::path dir);
+
+    // Create the directory structure and the given shards. This is to be
+    // called once, by the coordinator, before any workers are started.
+    void create(std::vector<shard> const& shards, long ndim);
+
+    // Return a unique name for a worker running in this process.
+    static std::string this_worker_name();
+
+    // Try to claim a pending shard for 'worker'. Returns an empty optional if
+    // there are no pending shards.
+    std::optional<shard> claim(std::string const& worker);
+
+    // Record that 'worker' is still working on 's'. Returns false if
+    // 'worker' no longer holds the claim on 's', because it has been
+    // requeued.
+    bool heartbeat(shard const& s, std::string const& worker);
+
+    // Append solutions for shard 's' to the results being streamed by
+    // 'worker'. Returns false, discarding the results streamed so far, if
+    // 'worker' no longer holds the claim on 's'; the worker should then
+    // abandon the shard.
+    bool append_results(shard const& s,
+                        std::string const& worker,
+                        std::vector<solution> const& solutions);
+
+    // Mark shard 's' as completed by 'worker', publishing its results.
+    // Returns false, discarding the results, if 'worker' no longer holds the
+    // claim on 's', or if the results of 's' have already been published by
+    // another worker.
+    bool complete(shard const& s, std::string const& worker);
+
+    // Move all shards claimed by 'worker', which is known to have died, back
+    // to pending, and discard its partial results. Returns the number of
+    // shards moved.
+    std::size_t requeue_worker(std::string const& worker);
+
+    // Move back to pending all claimed shards whose last heartbeat is older
+    // than 'max_age', and discard their partial results. Returns the number
+    // of shards moved.
+    std::size_t requeue_stale(std::chrono::seconds max_age);
+
+    // Return the number of shards, and the number that are complete.
+    long num_shards() const;
+    long num_complete() const;
+
+    // Mark the whole queue as finished; workers that see this exit.
+    void mark_done();
+    bool is_done() const;
+
+    // Read the results of all completed shards and return, for each grid
+    // point, the best 'max_results' solutions, sorted best first.
+    std::map<long, std::vector<solution>> merged_results(
+      std::size_t max_results) const;
+
+  private:
+    std::filesystem::path pending_dir() const;
+    std::filesystem::path claimed_dir() const;
+    std::filesystem::path results_dir() const;
+    std::filesystem::path partial_path(shard const& s,
+                                       std::string const& worker) const;
+    std::filesystem::path result_path(long id) const;
+    std::filesystem::path claimed_path(shard const& s,
+                                       std::string const& worker) const;
+    long ndim() const;
+
+    std::filesystem::path dir_;
+  };
+}
+
+#endif
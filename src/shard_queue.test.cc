@@ -0,0 +1,101 @@
+#include "shard_queue.hh"
+#include "solution.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using pfc::shard;
+using pfc::shard_queue;
+
+namespace {
+  // Return a solution whose value identifies the worker that found it.
+  pfc::solution
+  make_solution(double value)
+  {
+    pfc::solution s;
+    s.start = pfc::column_vector({1.0});
+    s.location = pfc::column_vector({0.5});
+    s.start_value = 2.0;
+    s.value = value;
+    return s;
+  }
+
+  // Create a queue of one shard in a fresh directory.
+  std::filesystem::path
+  make_queue(std::string const& name)
+  {
+    auto const dir = std::filesystem::temp_directory_path() /
+                     ("pfc_shard_queue_test_" + name + '_' +
+                      std::to_string(::getpid()));
+    std::filesystem::remove_all(dir);
+    shard s;
+    s.id = 0;
+    s.grid_point = 3;
+    s.num_attempts = 10;
+    shard_queue(dir).create({s}, 1);
+    return dir;
+  }
+}
+
+TEST_CASE("a worker whose shard was requeued abandons it")
+{
+  auto const dir = make_queue("requeue");
+  shard_queue queue(dir);
+  auto const a = queue.claim("a");
+  REQUIRE(a);
+  CHECK(queue.heartbeat(*a, "a"));
+  CHECK(queue.append_results(*a, "a", {make_solution(1.0)}));
+
+  // Worker a is slow, but still running, when its shard is requeued.
+  CHECK(queue.requeue_stale(std::chrono::seconds(0)) == 1);
+  CHECK_FALSE(queue.heartbeat(*a, "a"));
+  CHECK_FALSE(queue.append_results(*a, "a", {make_solution(2.0)}));
+  CHECK_FALSE(std::filesystem::exists(dir / "results" / "0.a"));
+
+  auto const b = queue.claim("b");
+  REQUIRE(b);
+  CHECK(queue.append_results(*b, "b", {make_solution(3.0)}));
+  CHECK(queue.append_results(*b, "b", {make_solution(4.0)}));
+  CHECK_FALSE(queue.complete(*a, "a"));
+  CHECK(queue.complete(*b, "b"));
+
+  CHECK(queue.num_complete() == 1);
+  auto const merged = queue.merged_results(10);
+  REQUIRE(merged.size() == 1);
+  auto const& solutions = merged.at(3);
+  REQUIRE(solutions.size() == 2);
+  CHECK(solutions[0].value == 3.0);
+  CHECK(solutions[1].value == 4.0);
+  std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("the results of a shard are published only once")
+{
+  auto const dir = make_queue("once");
+  shard_queue queue(dir);
+  auto const a = queue.claim("a");
+  REQUIRE(a);
+  CHECK(queue.append_results(*a, "a", {make_solution(1.0)}));
+  CHECK(queue.requeue_stale(std::chrono::seconds(0)) == 1);
+
+  // The replacement finishes first; worker a, whose claim is gone, does not
+  // replace its results.
+  auto const b = queue.claim("b");
+  REQUIRE(b);
+  CHECK(queue.append_results(*b, "b", {make_solution(3.0)}));
+  CHECK(queue.complete(*b, "b"));
+  CHECK_FALSE(queue.complete(*a, "a"));
+  CHECK_FALSE(std::filesystem::exists(dir / "results" / "0.a"));
+
+  auto const merged = queue.merged_results(10);
+  REQUIRE(merged.at(3).size() == 1);
+  CHECK(merged.at(3).front().value == 3.0);
+  CHECK_FALSE(queue.claim("c"));
+  std::filesystem::remove_all(dir);
+}
@@ -1,7 +1,11 @@
 #include "shared_result.hh"
+#include "report_writer.hh"
+#include "timed_lock.hh"
 
 #include <algorithm>
+#include <cmath>
 #include <ostream>
+#include <stdexcept>
 
 namespace pfc {
 
@@ -25,11 +29,23 @@ namespace pfc {
   void
   shared_result::insert(solution s)
   {
-    std::scoped_lock<std::mutex> lock(guard_results_);
+    if (catalog_)
+      catalog_->insert(s.location, s.value);
+    auto lock = lock_and_count_wait(guard_results_, lock_wait_ns_);
     num_results_ += 1;
     s.index = num_results_;
-    if (s.value < desired_min_)
-      done_ = true;
+    if (s.value < desired_min_) {
+      // done_ may have been set by request_stop, so it does not say whether
+      // a success has been recorded.
+      if (std::isnan(first_success_time_))
+        first_success_time_ = s.tstop;
+      done_.store(true, std::memory_order_relaxed);
+    }
+    if (s.value < best_value_) {
+      best_value_ = s.value;
+      if (on_improvement_)
+        on_improvement_(s);
+    }
 
     if (results_.empty()) {
       results_.push_back(s);
@@ -79,9 +95,94 @@ namespace pfc {
 
   bool
   shared_result::is_done(long max_attempts) const
+  {
+    // These are only stop flags, and nothing else is read based on their
+    // values, so relaxed loads are enough.
+    long const n = num_results_.load(std::memory_order_relaxed);
+    if (done_.load(std::memory_order_relaxed) || n > max_attempts)
+      return true;
+    if (stop_on_unseen_ && n >= unseen_min_attempts_ &&
+        catalog_->expected_unseen(unseen_estimator_) < unseen_threshold_)
+      return true;
+    return budget_.expired();
+  }
+
+  void
+  shared_result::set_time_budget(time_budget const& budget)
+  {
+    std::scoped_lock<std::mutex> lock(guard_results_);
+    budget_ = budget;
+  }
+
+  bool
+  shared_result::budget_expired() const
+  {
+    return budget_.expired();
+  }
+
+  double
+  shared_result::percent_budget_used() const
+  {
+    return budget_.percent_used();
+  }
+
+  void
+  shared_result::on_improvement(std::function<void(solution const&)> callback)
+  {
+    std::scoped_lock<std::mutex> lock(guard_results_);
+    on_improvement_ = std::move(callback);
+  }
+
+  void
+  shared_result::enable_minima_catalog(double distance, std::size_t max_minima)
+  {
+    std::scoped_lock<std::mutex> lock(guard_results_);
+    catalog_ = std::make_unique<minima_catalog>(distance, max_minima);
+  }
+
+  std::vector<minimum>
+  shared_result::minima() const
+  {
+    if (!catalog_)
+      return {};
+    return catalog_->minima();
+  }
+
+  long
+  shared_result::num_minima_found() const
+  {
+    if (!catalog_)
+      return 0;
+    return catalog_->num_found();
+  }
+
+  void
+  shared_result::set_unseen_minima_stop(unseen_minima_estimator estimator,
+                                        double threshold,
+                                        long min_attempts)
   {
     std::scoped_lock<std::mutex> lock(guard_results_);
-    return done_ || (num_results_ > max_attempts);
+    if (!catalog_)
+      throw std::logic_error("set_unseen_minima_stop requires the minima "
+                             "catalog to be enabled");
+    stop_on_unseen_ = true;
+    unseen_estimator_ = estimator;
+    unseen_threshold_ = threshold;
+    unseen_min_attempts_ = min_attempts;
+  }
+
+  double
+  shared_result::expected_unseen_minima() const
+  {
+    if (!stop_on_unseen_)
+      return std::numeric_limits<double>::infinity();
+    return catalog_->expected_unseen(unseen_estimator_);
+  }
+
+  void
+  shared_result::request_stop()
+  {
+    done_.store(true, std::memory_order_relaxed);
   }
 
   std::vector<solution>
@@ -112,6 +213,27 @@ namespace pfc {
     pfc::print_report(results_, os);
   }
 
+  void
+  shared_result::write_report(int fd) const
+  {
+    std::scoped_lock<std::mutex> lock(guard_results_);
+    pfc::write_report(results_, fd);
+  }
+
+  double
+  shared_result::lock_wait_ms() const
+  {
+    std::scoped_lock<std::mutex> lock(guard_results_);
+    return lock_wait_ns_ * 1.0e-6;
+  }
+
+  double
+  shared_result::first_success_time() const
+  {
+    std::scoped_lock<std::mutex> lock(guard_results_);
+    return first_success_time_;
+  }
+
   void
   print_report(std::vector<solution> const& results, std::ostream& os)
   {
@@ -1,10 +1,15 @@
 #ifndef PROFILED_FC_CPU_SHARED_RESULT_HH
 #define PROFILED_FC_CPU_SHARED_RESULT_HH
 
+#include "minima_catalog.hh"
 #include "solution.hh"
+#include "time_budget.hh"
 
+#include <atomic>
+#include <functional>
 #include <iosfwd>
 #include <limits>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -41,12 +46,70 @@ namespace pfc {
     // Obtain a copy of the best result thus far.
     solution best() const;
 
-    // Check whether we are done or not. The current implementation is very
-    // naive; we are done when the best solution has found a local minimum with
-    // value less than the value of desired_min used to configure the
-    // shared_result object.
+    // Check whether we are done or not. We are done when the best solution has
+    // found a local minimum with value less than the value of desired_min
+    // used to configure the shared_result object, when more than
+    // 'num_attempts' solutions have been inserted, when the time budget (if
+    // any) has been used up, or when the stopping rule on unseen minima (if
+    // any) is satisfied.
+    // This does not take the internal lock, so it is cheap to call often.
     bool is_done(long num_attempts = std::numeric_limits<long>::max()) const;
 
+    // Limit the search to the given time budget. This should be set before
+    // the search begins.
+    void set_time_budget(time_budget const& budget);
+
+    // Report whether the time budget has been used up. This does not take
+    // the internal lock, so it is cheap enough to be called at every step of
+    // a local minimization.
+    bool budget_expired() const;
+
+    // Report the percentage of the time budget used so far; this is 0 if
+    // there is no budget.
+    double percent_budget_used() const;
+
+    // Register a function to be called each time a solution better than all
+    // previous solutions is inserted. The function is called while the
+    // internal lock is held, so that the calls are made in order of
+    // improvement; it should therefore be quick, and must not call any member
+    // functions of this shared_result. This should be set before the search
+    // begins.
+    void on_improvement(std::function<void(solution const&)> callback);
+
+    // Keep a catalog of the distinct minima reached, in addition to the best
+    // solutions; see minima_catalog. This should be set before the search
+    // begins. Insertions into the catalog are done before the internal lock
+    // is taken, so they do not add to the time it is held.
+    void enable_minima_catalog(double distance, std::size_t max_minima);
+
+    // Return a copy of the distinct minima found, best first. This is empty
+    // if the catalog was not enabled.
+    std::vector<minimum> minima() const;
+
+    // Report the number of distinct minima found by the catalog; 0 if it was
+    // not enabled. This reads an atomic counter of the catalog, without the
+    // internal lock, so it can be sampled while the search runs.
+    long num_minima_found() const;
+
+    // Stop the search once at least 'min_attempts' solutions have been
+    // inserted, and the number of minima not yet found, estimated from the
+    // minima catalog, is less than 'threshold'. This allows a search to stop
+    // without knowing the value of the global minimum. The catalog must have
+    // been enabled; throws std::logic_error if it has not. This should be set
+    // before the search begins.
+    void set_unseen_minima_stop(unseen_minima_estimator estimator,
+                                double threshold,
+                                long min_attempts);
+
+    // Report the estimated number of minima not yet found, using the
+    // estimator given to set_unseen_minima_stop. This is infinite if there is
+    // no such stopping rule.
+    double expected_unseen_minima() const;
+
+    // Mark the search as done, so that is_done will return true from now on.
+    // This allows a search to be stopped from outside of the tasks doing it.
+    void request_stop();
+
     // Write out all the contained solutions in a format suitable for automated
     // processing.
     friend std::ostream& operator<<(std::ostream& os, shared_result const& r);
@@ -64,13 +127,41 @@ namespace pfc {
     // machine analysis, but may not be very good for human reading.
     void print_report(std::ostream& os) const;
 
+    // Write the same output to the file descriptor 'fd', with write_report
+    // (see report_writer.hh), which is much faster for many solutions.
+    void write_report(int fd) const;
+
+    // Report the total time, in milliseconds, that callers of insert have
+    // spent blocked waiting for another thread to release the
+    // internal lock.
+    double lock_wait_ms() const;
+
+    // Report the stop time (the 'tstop' of the solution) of the first solution
+    // inserted with a value less than desired_min. If there has been no such
+    // solution, return NaN.
+    double first_success_time() const;
+
   private:
     std::mutex mutable guard_results_;
     std::vector<solution> results_;
-    long num_results_ = 0;
+    // num_results_ is only modified while holding the lock, and done_ is
+    // too, except by request_stop; both are atomic so that is_done can read
+    // them without it.
+    std::atomic<long> num_results_ = 0;
     double const desired_min_;
-    bool done_ = false;
+    std::atomic<bool> done_ = false;
+    time_budget budget_;
     std::size_t max_results_;
+    long mutable lock_wait_ns_ = 0;
+    double first_success_time_ = std::numeric_limits<double>::quiet_NaN();
+    double best_value_ = std::numeric_limits<double>::infinity();
+    std::function<void(solution const&)> on_improvement_;
+    std::unique_ptr<minima_catalog> catalog_;
+    bool stop_on_unseen_ = false;
+    unseen_minima_estimator unseen_estimator_ =
+      unseen_minima_estimator::boender_rinnooy_kan;
+    double unseen_threshold_ = 0.0;
+    long unseen_min_attempts_ = 0;
   };
 
   void print_report(std::vector<solution> const& solutions, std::ostream& os);
@@ -5,10 +5,14 @@
 #include "catch2/catch_test_macros.hpp"
 #include "catch2/matchers/catch_matchers_floating_point.hpp"
 #include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
 
 using pfc::column_vector;
 using pfc::shared_result;
 using pfc::solution;
+using pfc::time_budget;
 
 double
 function(double x)
@@ -67,4 +71,78 @@ TEST_CASE("not filled")
   CHECK(solutions.num_attempts() == 3);
 
   REQUIRE_THAT(solutions.best().value, Catch::Matchers::WithinAbs(0.0, 1.e-6));
-}
\ No newline at end of file
+}
+
+TEST_CASE("time budget")
+{
+  shared_result unlimited(1.e-6, 2);
+  CHECK(!unlimited.budget_expired());
+  CHECK(unlimited.percent_budget_used() == 0.0);
+
+  shared_result solutions(1.e-6, 2);
+  solutions.set_time_budget(time_budget(20.0));
+  CHECK(!solutions.is_done());
+  CHECK(!solutions.budget_expired());
+  CHECK(solutions.percent_budget_used() < 100.0);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  CHECK(solutions.budget_expired());
+  CHECK(solutions.is_done());
+  CHECK(solutions.percent_budget_used() >= 100.0);
+}
+
+TEST_CASE("cpu time budget")
+{
+  time_budget const budget(5.0, time_budget::clock_type::cpu);
+  CHECK(budget.limited());
+  // Sleeping uses no CPU time, so we have to do some work to use the budget.
+  double sum = 0.0;
+  while (!budget.expired())
+    sum += function(0.5);
+  CHECK(budget.percent_used() >= 100.0);
+  CHECK(!time_budget().expired());
+}
+
+TEST_CASE("unseen minima stopping rule")
+{
+  shared_result solutions(-1.0, 2);
+  CHECK_THROWS_AS(solutions.set_unseen_minima_stop(
+                    pfc::unseen_minima_estimator::chao1, 0.5, 4),
+                  std::logic_error);
+
+  solutions.enable_minima_catalog(0.1, 100);
+  solutions.set_unseen_minima_stop(pfc::unseen_minima_estimator::chao1, 0.5, 4);
+  solution s;
+  s.start = column_vector({1.0});
+  s.start_value = 1.0;
+  s.tstart = s.tstop = 0.0;
+  // Alternate between two minima; after four attempts each has been found
+  // twice, and no unseen minima are expected.
+  for (int i = 0; i != 4; ++i) {
+    CHECK(!solutions.is_done());
+    s.location = column_vector({(i % 2) * 1.0});
+    s.value = 0.5 * (i % 2);
+    solutions.insert(s);
+  }
+  CHECK(solutions.expected_unseen_minima() == 0.0);
+  CHECK(solutions.is_done());
+  CHECK(solutions.minima().size() == 2);
+}
+
+TEST_CASE("first success time after a stop request")
+{
+  shared_result solutions(1.e-6, 2);
+  CHECK(std::isnan(solutions.first_success_time()));
+  solutions.request_stop();
+  CHECK(solutions.is_done());
+
+  solution s;
+  s.start = column_vector({0.5});
+  s.start_value = function(s.start(0));
+  s.location = column_vector({1.0e-8});
+  s.value = function(s.location(0));
+  s.tstart = 1.0;
+  s.tstop = 2.0;
+  solutions.insert(s);
+  CHECK(solutions.first_success_time() == 2.0);
+}
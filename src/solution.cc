@@ -1,7 +1,10 @@
 #include "solution.hh"
 
 #include "fmt/format.h"
+#include <cstdlib>
 #include <ostream>
+#include <stdexcept>
+#include <vector>
 
 namespace {
   inline std::string
@@ -9,6 +12,44 @@ namespace {
   {
     return fmt::format("{:.17e}", x);
   }
+
+  // Split 'line' into tab-separated fields.
+  std::vector<std::string>
+  split_fields(std::string const& line)
+  {
+    std::vector<std::string> fields;
+    std::string::size_type start = 0;
+    while (true) {
+      auto const tab = line.find('\t', start);
+      fields.push_back(line.substr(start, tab - start));
+      if (tab == std::string::npos)
+        break;
+      start = tab + 1;
+    }
+    return fields;
+  }
+
+  // We use strtod rather than stream extraction because it also accepts the
+  // representations of infinities and NaNs.
+  double
+  parse_double(std::string const& field)
+  {
+    char* end = nullptr;
+    double const x = std::strtod(field.c_str(), &end);
+    if (end == field.c_str())
+      throw std::runtime_error("Invalid floating point field: " + field);
+    return x;
+  }
+
+  long
+  parse_long(std::string const& field)
+  {
+    char* end = nullptr;
+    long const x = std::strtol(field.c_str(), &end, 10);
+    if (end == field.c_str())
+      throw std::runtime_error("Invalid integer field: " + field);
+    return x;
+  }
 }
 
 std::ostream&
@@ -21,4 +62,32 @@ pfc::operator<<(std::ostream& os, pfc::solution const& sol)
      << format_double(sol.tstop) << '\t' << sol.location << '\t'
      << format_double(sol.value) << '\t' << dist << '\t' << sol.nsteps;
   return os;
-}
\ No newline at end of file
+}
+
+pfc::solution
+pfc::parse_solution(std::string const& line, long ndim)
+{
+  auto const fields = split_fields(line);
+  // idx, tstart, start..., start_value, tstop, location..., value, dist,
+  // nsteps
+  std::size_t const nfields = 2 * ndim + 7;
+  if (fields.size() != nfields)
+    throw std::runtime_error("Wrong number of fields in solution: " + line);
+
+  solution sol;
+  sol.start.set_size(ndim);
+  sol.location.set_size(ndim);
+  std::size_t i = 0;
+  sol.index = parse_long(fields[i++]);
+  sol.tstart = parse_double(fields[i++]);
+  for (long j = 0; j != ndim; ++j)
+    sol.start(j) = parse_double(fields[i++]);
+  sol.start_value = parse_double(fields[i++]);
+  sol.tstop = parse_double(fields[i++]);
+  for (long j = 0; j != ndim; ++j)
+    sol.location(j) = parse_double(fields[i++]);
+  sol.value = parse_double(fields[i++]);
+  ++i; // skip the distance
+  sol.nsteps = parse_long(fields[i++]);
+  return sol;
+}
@@ -4,6 +4,7 @@
 #include "geometry.hh"
 
 #include <iosfwd>
+#include <string>
 
 namespace pfc {
   struct solution {
@@ -15,6 +16,10 @@ namespace pfc {
     double tstart;
     double tstop;
     long nsteps = -1; // not all algorithms will fill this value
+    // True if the minimization was constrained to a box, and the location is
+    // on the boundary of that box. This is not written by operator<<, so
+    // that the output format does not depend on the algorithm used.
+    bool bound_active = false;
   };
 
   // solutions are sorted by the value: the smallest value is the obvious best
@@ -27,6 +32,12 @@ namespace pfc {
 
   std::ostream& operator<<(std::ostream& os, solution const& s);
 
+  // Read a solution from a line in the format written by operator<<. The
+  // dimensionality of the solution must be supplied. The distance column is
+  // not stored in a solution, and so is ignored. Throws std::runtime_error if
+  // the line can not be parsed.
+  solution parse_solution(std::string const& line, long ndim);
+
   inline long
   ndims(solution const& s)
   {
@@ -0,0 +1,60 @@
+#include "solution.hh"
+#include "geometry.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+using pfc::column_vector;
+using pfc::solution;
+
+TEST_CASE("solutions survive a round trip through text")
+{
+  solution s;
+  s.start = column_vector({1.0, -2.5, 1.0e-300});
+  s.location = column_vector({0.125, 3.0, -7.0e12});
+  s.index = 17;
+  s.start_value = 42.0;
+  s.value = 1.0 / 3.0;
+  s.tstart = 123456.789;
+  s.tstop = 123457.5;
+  s.nsteps = 12;
+
+  std::ostringstream os;
+  os << s;
+  auto const t = pfc::parse_solution(os.str(), 3);
+  CHECK(t.index == s.index);
+  CHECK(t.nsteps == s.nsteps);
+  // We print 17 significant digits, which is enough to recover every double
+  // exactly.
+  CHECK(t.value == s.value);
+  CHECK(t.start_value == s.start_value);
+  CHECK(t.tstart == s.tstart);
+  CHECK(t.tstop == s.tstop);
+  for (long i = 0; i != 3; ++i) {
+    CHECK(t.start(i) == s.start(i));
+    CHECK(t.location(i) == s.location(i));
+  }
+}
+
+TEST_CASE("infinite values can be read")
+{
+  solution s;
+  s.start = column_vector({1.0});
+  s.location = column_vector({2.0});
+  s.start_value = std::numeric_limits<double>::infinity();
+  s.value = 0.0;
+  s.tstart = 0.0;
+  s.tstop = 0.0;
+  std::ostringstream os;
+  os << s;
+  auto const t = pfc::parse_solution(os.str(), 1);
+  CHECK(t.start_value == s.start_value);
+}
+
+TEST_CASE("bad lines are rejected")
+{
+  CHECK_THROWS_AS(pfc::parse_solution("1\t2\t3", 2), std::runtime_error);
+}
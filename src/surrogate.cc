@@ -0,0 +1,429 @@
+#include "surrogate.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+  // Added to the diagonal of the kernel matrix; see rbf_model.
+  double const RBF_NUGGET = 1.0e-8;
+
+  double
+  cubic(double r)
+  {
+    return r * r * r;
+  }
+
+  // Invert the n x n matrix 'a', stored by rows, by Gauss-Jordan elimination
+  // with partial pivoting. Throws std::runtime_error if it is singular.
+  std::vector<double>
+  invert(std::vector<double> a, std::size_t n)
+  {
+    std::vector<double> inv(n * n, 0.0);
+    for (std::size_t i = 0; i != n; ++i)
+      inv[i * n + i] = 1.0;
+    for (std::size_t col = 0; col != n; ++col) {
+      std::size_t pivot = col;
+      for (std::size_t row = col + 1; row != n; ++row) {
+        if (std::abs(a[row * n + col]) > std::abs(a[pivot * n + col]))
+          pivot = row;
+      }
+      if (a[pivot * n + col] == 0.0)
+        throw std::runtime_error("rbf_model: singular matrix");
+      if (pivot != col) {
+        std::swap_ranges(a.begin() + col * n,
+                         a.begin() + (col + 1) * n,
+                         a.begin() + pivot * n);
+        std::swap_ranges(inv.begin() + col * n,
+                         inv.begin() + (col + 1) * n,
+                         inv.begin() + pivot * n);
+      }
+      double const scale = 1.0 / a[col * n + col];
+      for (std::size_t k = 0; k != n; ++k) {
+        a[col * n + k] *= scale;
+        inv[col * n + k] *= scale;
+      }
+      for (std::size_t row = 0; row != n; ++row) {
+        double const factor = a[row * n + col];
+        if (row == col || factor == 0.0)
+          continue;
+        for (std::size_t k = 0; k != n; ++k) {
+          a[row * n + k] -= factor * a[col * n + k];
+          inv[row * n + k] -= factor * inv[col * n + k];
+        }
+      }
+    }
+    return inv;
+  }
+
+  // Return the column of the matrix of the system (see rbf_model) for a
+  // point y, against the unknowns of the tail and of 'points': 1, then the
+  // coordinates of y, then |y - x_i|^3 for each x_i of 'points'.
+  std::vector<double>
+  coupling(pfc::column_vector const& y,
+           std::vector<pfc::column_vector> const& points)
+  {
+    std::vector<double> result;
+    result.reserve(1 + y.size() + points.size());
+    result.push_back(1.0);
+    for (long k = 0; k != y.size(); ++k)
+      result.push_back(y(k));
+    for (auto const& x : points)
+      result.push_back(cubic(dlib::length(y - x)));
+    return result;
+  }
+
+  // Return the distance from x to the nearest of 'points', which must not be
+  // empty.
+  double
+  nearest_distance(pfc::column_vector const& x,
+                   std::vector<pfc::column_vector> const& points)
+  {
+    double result = std::numeric_limits<double>::infinity();
+    for (auto const& p : points)
+      result = std::min(result, dlib::length(x - p));
+    return result;
+  }
+}
+
+namespace pfc {
+
+  // The system is
+  //   [ 0   P^T              ] [ c ]   [ 0 ]
+  //   [ P   Phi + nugget I   ] [ w ] = [ f ]
+  // where Phi(i, j) = |x_i - x_j|^3, and row i of P is (1, x_i). It is
+  // symmetric, and its inverse is kept, so that a fit can be extended to
+  // more points without inverting it again.
+
+  rbf_model::rbf_model(std::vector<column_vector> points,
+                       std::vector<double> values)
+    : points_(std::move(points)), values_(std::move(values))
+  {
+    std::size_t const n = points_.size();
+    std::size_t const t = points_.front().size() + 1;
+    std::size_t const m = t + n;
+    std::vector<double> a(m * m, 0.0);
+    for (std::size_t j = 0; j != n; ++j) {
+      auto const column = coupling(points_[j], points_);
+      for (std::size_t i = 0; i != m; ++i)
+        a[i * m + t + j] = a[(t + j) * m + i] = column[i];
+      a[(t + j) * m + t + j] += RBF_NUGGET;
+    }
+    inverse_ = invert(std::move(a), m);
+    solve();
+  }
+
+  rbf_model::rbf_model(rbf_model const& previous,
+                       std::vector<column_vector> const& points,
+                       std::vector<double> const& values)
+    : points_(previous.points_), values_(previous.values_)
+  {
+    // With A the previous matrix, the new one is [ A B; B^T C ], with B the
+    // coupling of the new points to the previous unknowns and C the kernel
+    // matrix of the new points. With E = A^-1 B and the Schur complement
+    // S = C - B^T E, its inverse is
+    //   [ A^-1 + E S^-1 E^T   -E S^-1 ]
+    //   [ -S^-1 E^T            S^-1   ].
+    std::size_t const m = previous.tail_.size() + previous.points_.size();
+    std::size_t const k = points.size();
+    std::vector<double> const& ainv = previous.inverse_;
+
+    std::vector<double> b(m * k);
+    for (std::size_t j = 0; j != k; ++j) {
+      auto const column = coupling(points[j], previous.points_);
+      for (std::size_t i = 0; i != m; ++i)
+        b[i * k + j] = column[i];
+    }
+    std::vector<double> e(m * k, 0.0);
+    for (std::size_t i = 0; i != m; ++i)
+      for (std::size_t l = 0; l != m; ++l) {
+        double const a_il = ainv[i * m + l];
+        for (std::size_t j = 0; j != k; ++j)
+          e[i * k + j] += a_il * b[l * k + j];
+      }
+    std::vector<double> schur(k * k);
+    for (std::size_t i = 0; i != k; ++i)
+      for (std::size_t j = 0; j != k; ++j) {
+        double sum = cubic(dlib::length(points[i] - points[j]));
+        if (i == j)
+          sum += RBF_NUGGET;
+        for (std::size_t l = 0; l != m; ++l)
+          sum -= b[l * k + i] * e[l * k + j];
+        schur[i * k + j] = sum;
+      }
+    auto const sinv = invert(std::move(schur), k);
+    // F = E S^-1.
+    std::vector<double> f(m * k, 0.0);
+    for (std::size_t i = 0; i != m; ++i)
+      for (std::size_t l = 0; l != k; ++l) {
+        double const e_il = e[i * k + l];
+        for (std::size_t j = 0; j != k; ++j)
+          f[i * k + j] += e_il * sinv[l * k + j];
+      }
+
+    std::size_t const mk = m + k;
+    inverse_.resize(mk * mk);
+    for (std::size_t i = 0; i != m; ++i) {
+      for (std::size_t j = 0; j != m; ++j) {
+        double sum = ainv[i * m + j];
+        for (std::size_t l = 0; l != k; ++l)
+          sum += f[i * k + l] * e[j * k + l];
+        inverse_[i * mk + j] = sum;
+      }
+      for (std::size_t j = 0; j != k; ++j)
+        inverse_[i * mk + m + j] = inverse_[(m + j) * mk + i] = -f[i * k + j];
+    }
+    for (std::size_t i = 0; i != k; ++i)
+      for (std::size_t j = 0; j != k; ++j)
+        inverse_[(m + i) * mk + m + j] = sinv[i * k + j];
+
+    points_.insert(points_.end(), points.begin(), points.end());
+    values_.insert(values_.end(), values.begin(), values.end());
+    solve();
+  }
+
+  void
+  rbf_model::solve()
+  {
+    // The right-hand side is zero for the unknowns of the tail.
+    std::size_t const n = points_.size();
+    std::size_t const t = points_.front().size() + 1;
+    std::size_t const m = t + n;
+    std::vector<double> rhs(m, 0.0);
+    std::copy(values_.begin(), values_.end(), rhs.begin() + t);
+    auto multiply = [&](std::vector<double> const& b) {
+      std::vector<double> result(m, 0.0);
+      for (std::size_t i = 0; i != m; ++i)
+        for (std::size_t j = 0; j != m; ++j)
+          result[i] += inverse_[i * m + j] * b[j];
+      return result;
+    };
+    auto x = multiply(rhs);
+
+    // An inverse, and more so an updated one, loses accuracy on the
+    // ill-conditioned kernel matrix; one step of iterative refinement
+    // recovers it, at the cost of forming the residual in O((n + d)^2).
+    // Column t + j of the matrix is the coupling of point j, and by
+    // symmetry so is the tail part of row t + j.
+    std::vector<double> residual = rhs;
+    for (std::size_t j = 0; j != n; ++j) {
+      auto const column = coupling(points_[j], points_);
+      for (std::size_t i = 0; i != m; ++i)
+        residual[i] -= column[i] * x[t + j];
+      for (std::size_t k = 0; k != t; ++k)
+        residual[t + j] -= column[k] * x[k];
+      residual[t + j] -= RBF_NUGGET * x[t + j];
+    }
+    auto const correction = multiply(residual);
+    for (std::size_t i = 0; i != m; ++i)
+      x[i] += correction[i];
+    tail_.assign(x.begin(), x.begin() + t);
+    weights_.assign(x.begin() + t, x.end());
+  }
+
+  double
+  rbf_model::operator()(column_vector const& x) const
+  {
+    double sum = tail_[0];
+    for (long k = 0; k != x.size(); ++k)
+      sum += tail_[k + 1] * x(k);
+    for (std::size_t i = 0; i != points_.size(); ++i)
+      sum += weights_[i] * cubic(dlib::length(x - points_[i]));
+    return sum;
+  }
+
+  std::vector<column_vector> const&
+  rbf_model::points() const
+  {
+    return points_;
+  }
+
+  surrogate_sampler::surrogate_sampler(region<column_vector> const& bounds,
+                                       surrogate_config const& config)
+    : bounds_(bounds), config_(config)
+  {}
+
+  surrogate_sampler::~surrogate_sampler()
+  {
+    wait();
+  }
+
+  void
+  surrogate_sampler::wait()
+  {
+    refits_.wait();
+  }
+
+  column_vector
+  surrogate_sampler::to_unit(column_vector const& x) const
+  {
+    return dlib::pointwise_divide(x - bounds_.lower(),
+                                  bounds_.upper() - bounds_.lower());
+  }
+
+  void
+  surrogate_sampler::record(column_vector const& x, double value)
+  {
+    if (!std::isfinite(value))
+      return;
+    num_evaluations_.fetch_add(1, std::memory_order_relaxed);
+    std::size_t npending = 0;
+    {
+      std::scoped_lock lock(guard_pending_);
+      // If the refits can not keep up, we drop evaluations rather than let
+      // the buffer grow without limit.
+      if (pending_.size() < 10 * config_.max_points + config_.refit_interval)
+        pending_.push_back({to_unit(x), value});
+      npending = pending_.size();
+    }
+    if (npending >= config_.refit_interval && !fitting_.exchange(true)) {
+      refits_.run([this]() {
+        refit();
+        fitting_.store(false);
+      });
+    }
+  }
+
+  void
+  surrogate_sampler::refit()
+  {
+    std::vector<evaluation> incoming;
+    {
+      std::scoped_lock lock(guard_pending_);
+      incoming.swap(pending_);
+    }
+
+    // Add the new evaluations that are not too close to those already in
+    // the fit, best first, so that of nearby points we keep the best.
+    std::sort(incoming.begin(),
+              incoming.end(),
+              [](auto const& a, auto const& b) { return a.value < b.value; });
+    for (auto& e : incoming) {
+      bool const separated = std::none_of(
+        fitted_.begin(), fitted_.end(), [&](evaluation const& f) {
+          return dlib::length(e.u - f.u) < config_.min_separation;
+        });
+      if (separated)
+        fitted_.push_back(std::move(e));
+    }
+    if (fitted_.size() > config_.max_points) {
+      std::nth_element(
+        fitted_.begin(),
+        fitted_.begin() + config_.max_points,
+        fitted_.end(),
+        [](auto const& a, auto const& b) { return a.value < b.value; });
+      fitted_.resize(config_.max_points);
+      // Points have been dropped, so the model must be fitted from scratch.
+      num_modelled_ = 0;
+    }
+    if (fitted_.size() < config_.min_points || fitted_.size() == num_modelled_)
+      return;
+
+    std::shared_ptr<rbf_model const> previous;
+    if (num_modelled_ != 0) {
+      std::scoped_lock lock(guard_model_);
+      previous = model_;
+    }
+    auto collect = [this](std::size_t first) {
+      std::pair<std::vector<column_vector>, std::vector<double>> result;
+      for (std::size_t i = first; i != fitted_.size(); ++i) {
+        result.first.push_back(fitted_[i].u);
+        result.second.push_back(fitted_[i].value);
+      }
+      return result;
+    };
+    std::shared_ptr<rbf_model const> model;
+    if (previous) {
+      auto const [points, values] = collect(num_modelled_);
+      try {
+        model = std::make_shared<rbf_model const>(*previous, points, values);
+      }
+      catch (std::runtime_error const&) {
+        // Fit from scratch below.
+      }
+    }
+    try {
+      if (!model) {
+        auto [points, values] = collect(0);
+        model = std::make_shared<rbf_model const>(std::move(points),
+                                                  std::move(values));
+      }
+    }
+    catch (std::runtime_error const&) {
+      // Keep the previous model.
+      return;
+    }
+    {
+      std::scoped_lock lock(guard_model_);
+      model_ = std::move(model);
+    }
+    num_modelled_ = fitted_.size();
+    num_fits_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  column_vector
+  surrogate_sampler::choose(std::vector<column_vector> const& candidates) const
+  {
+    std::shared_ptr<rbf_model const> model;
+    {
+      std::scoped_lock lock(guard_model_);
+      model = model_;
+    }
+    if (!model)
+      return candidates.front();
+
+    std::size_t const n = candidates.size();
+    std::vector<double> s(n);
+    std::vector<double> d(n);
+    for (std::size_t i = 0; i != n; ++i) {
+      column_vector const u = to_unit(candidates[i]);
+      s[i] = (*model)(u);
+      d[i] = nearest_distance(u, model->points());
+    }
+    auto const [smin, smax] = std::minmax_element(s.begin(), s.end());
+    auto const [dmin, dmax] = std::minmax_element(d.begin(), d.end());
+    double const srange = *smax - *smin;
+    double const drange = *dmax - *dmin;
+    double const w = config_.surrogate_weight;
+
+    std::size_t best = 0;
+    double best_score = std::numeric_limits<double>::infinity();
+    for (std::size_t i = 0; i != n; ++i) {
+      double const vs = (srange > 0.0) ? (s[i] - *smin) / srange : 0.0;
+      double const vd = (drange > 0.0) ? (*dmax - d[i]) / drange : 0.0;
+      double const score = w * vs + (1.0 - w) * vd;
+      if (score < best_score) {
+        best_score = score;
+        best = i;
+      }
+    }
+    return candidates[best];
+  }
+
+  region<column_vector> const&
+  surrogate_sampler::bounds() const
+  {
+    return bounds_;
+  }
+
+  std::size_t
+  surrogate_sampler::num_candidates() const
+  {
+    return config_.num_candidates;
+  }
+
+  long
+  surrogate_sampler::num_evaluations() const
+  {
+    return num_evaluations_.load(std::memory_order_relaxed);
+  }
+
+  long
+  surrogate_sampler::num_fits() const
+  {
+    return num_fits_.load(std::memory_order_relaxed);
+  }
+}
@@ -0,0 +1,223 @@
+#ifndef PROFILED_FC_CPU_SURROGATE_HH
+#define PROFILED_FC_CPU_SURROGATE_HH
+
+#include "geometry.hh"
+#include "minimizers.hh"
+#include "protected_engine.hh"
+#include "shared_result.hh"
+
+#include "tbb/task_group.h"
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+namespace pfc {
+
+  // rbf_model is a radial basis function interpolant, with the cubic kernel
+  // r^3 and a linear polynomial tail, of values at a set of points in the
+  // unit hypercube.
+  class rbf_model {
+  public:
+    // Fit the model to the given points and values, from scratch, in
+    // O((n + d)^3) time for n points in d dimensions. Points closer together
+    // than the fit can resolve make the system singular; the caller should
+    // keep points apart. A small multiple of the identity is added to the
+    // kernel matrix, so that nearly coincident points do not make the fit
+    // fail. Throws std::runtime_error if the system is singular regardless.
+    rbf_model(std::vector<column_vector> points, std::vector<double> values);
+
+    // Fit the model to the points and values of 'previous', followed by
+    // 'points' and 'values'. The inverse of the system of 'previous' is
+    // extended by a bordered (Schur complement) update, in O((n + d)^2 k)
+    // time for k new points, rather than computed again. Throws
+    // std::runtime_error if the extended system is singular.
+    rbf_model(rbf_model const& previous,
+              std::vector<column_vector> const& points,
+              std::vector<double> const& values);
+
+    double operator()(column_vector const& x) const;
+
+    std::vector<column_vector> const& points() const;
+
+  private:
+    // Set the weights and tail from the inverse and the values.
+    void solve();
+
+    std::vector<column_vector> points_;
+    std::vector<double> values_;
+    // The inverse of the matrix of the system (see surrogate.cc), with the
+    // unknowns of the tail first and then those of the points, so that new
+    // points border it.
+    std::vector<double> inverse_;
+    std::vector<double> weights_;
+    std::vector<double> tail_; // constant term, then one per coordinate
+  };
+
+  // surrogate_config controls the choice of starting points by
+  // surrogate_sampler.
+  struct surrogate_config {
+    // The number of random candidates from which each starting point is
+    // chosen.
+    std::size_t num_candidates = 100;
+    // The weight of the surrogate value in the score of a candidate; the
+    // rest of the weight goes to the distance from points already
+    // evaluated. 1 is pure exploitation, 0 pure exploration.
+    double surrogate_weight = 0.7;
+    // The minimum number of distinct points before a model is fitted; until
+    // then, starting points are random.
+    std::size_t min_points = 10;
+    // The maximum number of points used in the fit. When there are more,
+    // those with the lowest values are kept.
+    std::size_t max_points = 200;
+    // Points closer than this (in unit-cube coordinates) to a point already
+    // in the fit are not added to it.
+    double min_separation = 1.0e-3;
+    // The model is refitted after this many new evaluations.
+    std::size_t refit_interval = 50;
+  };
+
+  // surrogate_sampler chooses starting points for local minimizations with
+  // the help of a surrogate model (an rbf_model) of the function being
+  // minimized, fitted to every evaluation of the function recorded with
+  // 'record'. This is the stochastic RBF method of Regis and Shoemaker
+  // (2007): each starting point is the best of a set of random candidates,
+  // scored by a weighted sum of the (normalized) surrogate value and of the
+  // (normalized) closeness to points already evaluated. The first term
+  // favours points where the function is expected to be small; the second
+  // is an exploration bonus for points far from those already evaluated.
+  //
+  // Recording an evaluation only appends it to a buffer. When enough new
+  // evaluations have been recorded, the model is refitted in a TBB task,
+  // while starting points continue to be chosen with the previous model, so
+  // the fit is never on the critical path of the minimizations. Each refit
+  // adds the new evaluations to the points of the previous fit, and extends
+  // the previous fit with them, in O((n + d)^2 k) time for k new points of n
+  // in d dimensions. Only when there are more than max_points points, so
+  // that the worst are dropped, or when the extension fails, is the model
+  // fitted from scratch, in O((n + d)^3) time.
+  //
+  // A surrogate_sampler can be used as the starting point volume of
+  // run_parallel_attempts, through the overload of random_point_within
+  // below. All member functions are safe to call from multiple threads.
+  class surrogate_sampler {
+  public:
+    explicit surrogate_sampler(region<column_vector> const& bounds,
+                               surrogate_config const& config = {});
+
+    // Wait for any refit in progress.
+    ~surrogate_sampler();
+    void wait();
+
+    surrogate_sampler(surrogate_sampler const&) = delete;
+    surrogate_sampler& operator=(surrogate_sampler const&) = delete;
+
+    // Record an evaluation of the function.
+    void record(column_vector const& x, double value);
+
+    // Return the point of 'candidates' with the best score, or the first if
+    // there is not yet a model.
+    column_vector choose(std::vector<column_vector> const& candidates) const;
+
+    region<column_vector> const& bounds() const;
+    std::size_t num_candidates() const;
+
+    // Report the number of evaluations recorded, and the number of fits
+    // completed.
+    long num_evaluations() const;
+    long num_fits() const;
+
+  private:
+    struct evaluation {
+      column_vector u; // in unit-cube coordinates
+      double value;
+    };
+
+    column_vector to_unit(column_vector const& x) const;
+    void refit();
+
+    region<column_vector> bounds_;
+    surrogate_config config_;
+
+    std::mutex mutable guard_pending_;
+    std::vector<evaluation> pending_;
+    std::atomic<long> num_evaluations_ = 0;
+    std::atomic<long> num_fits_ = 0;
+    std::atomic<bool> fitting_ = false;
+    // Only the refit task uses fitted_ and num_modelled_, the number of
+    // leading points of fitted_ to which model_ was fitted.
+    std::vector<evaluation> fitted_;
+    std::size_t num_modelled_ = 0;
+
+    std::mutex mutable guard_model_;
+    std::shared_ptr<rbf_model const> model_;
+    oneapi::tbb::task_group refits_;
+  };
+
+  template <typename URBG>
+    requires std::uniform_random_bit_generator<URBG>
+  column_vector random_point_within(surrogate_sampler const& sampler,
+                                    URBG& engine);
+
+  // Search as find_global_minimum does, with the starting points chosen by a
+  // surrogate_sampler fitted to every evaluation of 'func'. This is for
+  // functions that are expensive enough that the cost of fitting and
+  // evaluating the surrogate is small compared to the function calls saved.
+  template <typename FUNC, typename LOCAL = bfgs_minimizer>
+  minimization_results find_global_minimum_guided(
+    FUNC const& func,
+    region<column_vector> const& starting_point_volume,
+    double tolerance,
+    search_config const& config,
+    surrogate_config const& surrogate = {},
+    LOCAL local_minimizer = LOCAL());
+
+  // Implementation details below.
+
+  template <typename URBG>
+    requires std::uniform_random_bit_generator<URBG>
+  column_vector
+  random_point_within(surrogate_sampler const& sampler, URBG& engine)
+  {
+    std::vector<column_vector> candidates;
+    candidates.reserve(sampler.num_candidates());
+    for (std::size_t i = 0; i != sampler.num_candidates(); ++i)
+      candidates.push_back(random_point_within(sampler.bounds(), engine));
+    return sampler.choose(candidates);
+  }
+
+  template <typename FUNC, typename LOCAL>
+  minimization_results
+  find_global_minimum_guided(FUNC const& func,
+                             region<column_vector> const& starting_point_volume,
+                             double tolerance,
+                             search_config const& config,
+                             surrogate_config const& surrogate,
+                             LOCAL local_minimizer)
+  {
+    surrogate_sampler sampler(starting_point_volume, surrogate);
+    auto recorded = [&func, &sampler](column_vector const& x) {
+      double const value = func(x);
+      sampler.record(x, value);
+      return value;
+    };
+    shared_result solutions(tolerance, config.num_retained);
+    protected_engine<std::mt19937> engine(std::time(0));
+    run_with_concurrency(config.concurrency, [&]() {
+      run_parallel_attempts(recorded,
+                            sampler,
+                            solutions,
+                            engine,
+                            config.max_attempts,
+                            config.grain_size,
+                            local_minimizer);
+    });
+    return {solutions.solutions(), solutions.num_attempts()};
+  }
+}
+
+#endif
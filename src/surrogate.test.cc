@@ -0,0 +1,100 @@
+#include "surrogate.hh"
+#include "geometry.hh"
+
+#include "catch2/catch_test_macros.hpp"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using pfc::column_vector;
+
+namespace {
+  double
+  bowl(column_vector const& x)
+  {
+    return (x(0) - 0.3) * (x(0) - 0.3) + 2.0 * (x(1) + 0.2) * (x(1) + 0.2);
+  }
+}
+
+TEST_CASE("rbf model interpolates its points")
+{
+  std::mt19937 engine(3);
+  auto const unit = pfc::make_box_in_n_dim(2, 0.0, 1.0);
+  std::vector<column_vector> points;
+  std::vector<double> values;
+  for (int i = 0; i != 30; ++i) {
+    points.push_back(pfc::random_point_within(unit, engine));
+    values.push_back(bowl(points.back()));
+  }
+  pfc::rbf_model const model(points, values);
+  for (std::size_t i = 0; i != points.size(); ++i)
+    CHECK(std::abs(model(points[i]) - values[i]) < 1.0e-6);
+  // Between the points, the model of a smooth function is close to it.
+  CHECK(std::abs(model(column_vector({0.5, 0.5})) -
+                 bowl(column_vector({0.5, 0.5}))) < 0.05);
+}
+
+TEST_CASE("an incremental fit matches a full fit")
+{
+  std::mt19937 engine(7);
+  auto const unit = pfc::make_box_in_n_dim(2, 0.0, 1.0);
+  std::vector<column_vector> points;
+  std::vector<double> values;
+  for (int i = 0; i != 40; ++i) {
+    points.push_back(pfc::random_point_within(unit, engine));
+    values.push_back(bowl(points.back()));
+  }
+  pfc::rbf_model const base({points.begin(), points.begin() + 30},
+                            {values.begin(), values.begin() + 30});
+  pfc::rbf_model const extended(base,
+                                {points.begin() + 30, points.end()},
+                                {values.begin() + 30, values.end()});
+  pfc::rbf_model const full(points, values);
+  REQUIRE(extended.points().size() == 40);
+  for (std::size_t i = 0; i != points.size(); ++i)
+    CHECK(std::abs(extended(points[i]) - values[i]) < 1.0e-6);
+  for (int i = 0; i != 100; ++i) {
+    auto const x = pfc::random_point_within(unit, engine);
+    CHECK(std::abs(extended(x) - full(x)) < 1.0e-6);
+  }
+}
+
+TEST_CASE("sampler prefers points where the surrogate is small")
+{
+  auto const volume = pfc::make_box_in_n_dim(2, -1.0, 1.0);
+  pfc::surrogate_config config;
+  config.refit_interval = 20;
+  config.surrogate_weight = 1.0;
+  pfc::surrogate_sampler sampler(volume, config);
+  std::mt19937 engine(5);
+  for (int i = 0; i != 100; ++i) {
+    auto const x = pfc::random_point_within(volume, engine);
+    sampler.record(x, bowl(x));
+  }
+  sampler.wait();
+  CHECK(sampler.num_evaluations() == 100);
+  CHECK(sampler.num_fits() > 0);
+
+  column_vector const far({-0.9, 0.9});
+  column_vector const near({0.25, -0.15});
+  auto const chosen = sampler.choose({far, near});
+  CHECK(chosen(0) == near(0));
+  CHECK(chosen(1) == near(1));
+}
+
+TEST_CASE("guided search finds the minimum")
+{
+  pfc::search_config config;
+  config.num_retained = 4;
+  config.max_attempts = 200;
+  auto [solutions, num_attempts] = pfc::find_global_minimum_guided(
+    bowl, pfc::make_box_in_n_dim(2, -1.0, 1.0), 1.0e-8, config);
+  REQUIRE(!solutions.empty());
+  double best = std::numeric_limits<double>::infinity();
+  for (auto const& s : solutions)
+    best = std::min(best, s.value);
+  CHECK(best < 1.0e-8);
+  CHECK(num_attempts < config.max_attempts);
+}
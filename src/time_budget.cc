@@ -0,0 +1,91 @@
+#include "time_budget.hh"
+
+#include <chrono>
+#include <ctime>
+
+namespace pfc {
+
+  time_budget::time_budget(double limit_ms, clock_type clock)
+    : limit_ms_(limit_ms), clock_(clock), start_ms_(now_ms())
+  {}
+
+  time_budget::time_budget(time_budget const& other)
+    : limit_ms_(other.limit_ms_)
+    , clock_(other.clock_)
+    , start_ms_(other.start_ms_)
+    , cpu_expired_(other.cpu_expired_.load())
+    , next_cpu_check_ms_(other.next_cpu_check_ms_.load())
+  {}
+
+  time_budget&
+  time_budget::operator=(time_budget const& other)
+  {
+    limit_ms_ = other.limit_ms_;
+    clock_ = other.clock_;
+    start_ms_ = other.start_ms_;
+    cpu_expired_ = other.cpu_expired_.load();
+    next_cpu_check_ms_ = other.next_cpu_check_ms_.load();
+    return *this;
+  }
+
+  double
+  time_budget::wall_ms()
+  {
+    using namespace std::chrono;
+    auto const t = steady_clock::now().time_since_epoch();
+    return duration<double>(t).count() * 1000.0;
+  }
+
+  double
+  time_budget::now_ms() const
+  {
+    if (clock_ == clock_type::cpu)
+      return 1000.0 * std::clock() / CLOCKS_PER_SEC;
+    return wall_ms();
+  }
+
+  bool
+  time_budget::limited() const
+  {
+    return limit_ms_ >= 0.0;
+  }
+
+  bool
+  time_budget::expired() const
+  {
+    if (!limited())
+      return false;
+    if (clock_ == clock_type::wall)
+      return wall_ms() - start_ms_ >= limit_ms_;
+
+    if (cpu_expired_.load(std::memory_order_relaxed))
+      return true;
+    // Only the thread that moves the next check time forward reads the CPU
+    // time; the others report the budget as not yet expired.
+    double const now = wall_ms();
+    double next = next_cpu_check_ms_.load(std::memory_order_relaxed);
+    if (now < next || !next_cpu_check_ms_.compare_exchange_strong(
+                        next, now + cpu_check_interval_ms))
+      return false;
+    if (now_ms() - start_ms_ < limit_ms_)
+      return false;
+    cpu_expired_.store(true, std::memory_order_relaxed);
+    return true;
+  }
+
+  double
+  time_budget::used_ms() const
+  {
+    return now_ms() - start_ms_;
+  }
+
+  double
+  time_budget::percent_used() const
+  {
+    if (!limited())
+      return 0.0;
+    if (limit_ms_ == 0.0)
+      return 100.0;
+    return 100.0 * used_ms() / limit_ms_;
+  }
+}
@@ -0,0 +1,66 @@
+#ifndef PROFILED_FC_CPU_TIME_BUDGET_HH
+#define PROFILED_FC_CPU_TIME_BUDGET_HH
+
+#include <atomic>
+
+namespace pfc {
+
+  // time_budget represents a limit on the time a search may take, measured
+  // either in wall-clock time or in the CPU time used by the whole process
+  // (summed over all threads). The budget starts when the time_budget is
+  // constructed.
+  //
+  // Any number of threads can check a time_budget at once without locking.
+  // Checking a wall-clock budget costs one read of the steady clock.
+  // Reading the CPU time of the process is a system call that the kernel
+  // answers by summing over all the threads, so a CPU-time budget reads it
+  // at most once every cpu_check_interval_ms of wall-clock time, in
+  // whichever thread first finds that interval over; other checks cost one
+  // read of the steady clock, and a CPU-time budget is seen to expire up to
+  // that interval late. Checking an unlimited budget reads no clock at all.
+  class time_budget {
+  public:
+    enum class clock_type { wall, cpu };
+
+    // Create an unlimited budget.
+    time_budget() = default;
+
+    // Create a budget of 'limit_ms' milliseconds of the given kind of time,
+    // starting now.
+    explicit time_budget(double limit_ms, clock_type clock = clock_type::wall);
+
+    time_budget(time_budget const& other);
+    time_budget& operator=(time_budget const& other);
+
+    // The most wall-clock time between reads of the CPU time.
+    static constexpr double cpu_check_interval_ms = 1.0;
+
+    // Report whether there is a limit at all.
+    bool limited() const;
+
+    // Report whether the budget has been used up.
+    bool expired() const;
+
+    // Report the time used since the budget started, in milliseconds.
+    double used_ms() const;
+
+    // Report the percentage of the budget used so far. This can exceed 100,
+    // because work in progress when the budget expires has to finish. For an
+    // unlimited budget, this is 0.
+    double percent_used() const;
+
+  private:
+    double now_ms() const;
+    static double wall_ms();
+
+    double limit_ms_ = -1.0; // negative means unlimited
+    clock_type clock_ = clock_type::wall;
+    double start_ms_ = 0.0;
+    // For a CPU-time budget: whether it has been seen to expire, and the
+    // wall-clock time at which the CPU time is next to be read.
+    std::atomic<bool> mutable cpu_expired_ = false;
+    std::atomic<double> mutable next_cpu_check_ms_ = 0.0;
+  };
+}
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef PROFILED_FC_CPU_TIMED_LOCK_HH
+#define PROFILED_FC_CPU_TIMED_LOCK_HH
+
+#include <chrono>
+#include <mutex>
+
+namespace pfc {
+
+  // Acquire the mutex 'm', and return the lock that owns it. If the mutex was
+  // not immediately available, add the time we spent blocked waiting for it,
+  // in nanoseconds, to 'wait_ns'. Because 'wait_ns' is only modified while the
+  // mutex is held, it should be protected by the same mutex.
+  //
+  // The clock is only read when there is contention, so the cost of the
+  // accounting in the uncontended case is just that of a try_lock.
+  inline std::unique_lock<std::mutex>
+  lock_and_count_wait(std::mutex& m, long& wait_ns)
+  {
+    std::unique_lock<std::mutex> lock(m, std::try_to_lock);
+    if (!lock.owns_lock()) {
+      auto const start = std::chrono::steady_clock::now();
+      lock.lock();
+      auto const stop = std::chrono::steady_clock::now();
+      wait_ns +=
+        std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start)
+          .count();
+    }
+    return lock;
+  }
+}
+
+#endif